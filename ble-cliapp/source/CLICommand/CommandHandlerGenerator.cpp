@@ -36,3 +36,19 @@ void CommandHandlerGenerator::print_error(
     } 
     out << endObject;
 }
+
+bool CommandHandlerGenerator::decode_arguments(
+    const CommandArgs& args, 
+    const CommandResponsePtr& response, 
+    const argument_parser_t* parsers, 
+    void* const* values,
+    std::size_t count,
+    ConstArray<CommandArgDescription> (*argsDescription)()) { 
+    for (std::size_t i = 0; i < count; ++i) { 
+        if (!parsers[i](args[i], values[i])) { 
+            print_error(response, i, argsDescription);
+            return false;
+        }
+    }
+    return true;
+}
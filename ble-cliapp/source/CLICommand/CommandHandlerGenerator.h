@@ -14,6 +14,9 @@
 #ifndef BLE_CLIAPP_CLICOMMAND_COMMAND_HANDLER_GENERATOR_H_
 #define BLE_CLIAPP_CLICOMMAND_COMMAND_HANDLER_GENERATOR_H_
 
+#include <stddef.h>
+#include <tuple>
+#include <utility>
 #include "Command.h"
 
 /**
@@ -22,12 +25,16 @@
  * long as the arguments of the handler implement the serialization protocol. 
  * 
  * For a Command of type T, if T::handler can be of the form 
- * void(Arg1, Arg2,...,Arg9, const CommandResponsePtr&) as long as Arg1...Arg9 implement 
+ * void(Arg1, Arg2,...,ArgN, const CommandResponsePtr&) as long as Arg1...ArgN implement 
  * the serialization protocol. 
  * 
  * The entry handler with the form void(const CommandArgs&, const CommandResponsePtr&) 
  * is generated by this class: CommandHandlerGenerator<T>::handler.  
  * 
+ * Arguments are decoded by a single loop, shared by all the commands, which 
+ * walks a table of parse functions built for each handler signature. There 
+ * is one parse function per argument type, whatever the number of commands 
+ * using that type. 
  * 
  * @code
  * struct AddCommand : public BaseCommand { 
@@ -57,6 +64,15 @@ struct CommandHandlerGenerator {
 
 private:
 
+    /**
+     * @brief Type of the functions deserializing an argument.
+     * @param str The string to deserialize. 
+     * @param value Pointer to the argument to set. 
+     * @return true if the deserialization succeeded and false otherwise.
+     */
+    typedef bool (*argument_parser_t)(const char* str, void* value);
+
+
     /**
      * @brief Traits which remove the reference of the type T in input. The 
      * result is accessible via the inner typedef type.
@@ -76,6 +92,29 @@ private:
     };
 
 
+    /**
+     * @brief Type of the Index-th parameter of the function signature Params.
+     * The reference, if any, is removed. 
+     */
+    template<std::size_t Index, typename... Params>
+    struct argument_type { 
+        typedef typename remove_reference<
+            typename std::tuple_element<Index, std::tuple<Params...> >::type
+        >::type type;
+    };
+
+
+    /**
+     * @brief Parse function of arguments of type T. 
+     * @details A single instance of this function exists for every argument 
+     * type, it is shared by all the commands accepting an argument of type T.
+     */
+    template<typename T>
+    static bool parse_argument(const char* str, void* value) { 
+        return fromString(str, *static_cast<T*>(value));
+    }
+
+
     /**
      * @brief Generic function used to print an error in the command response if the 
      * deserialization fail.
@@ -91,6 +130,31 @@ private:
     );
 
 
+    /**
+     * @brief Deserialize the arguments of a command. 
+     * @details This is the only place where arguments are decoded, commands 
+     * just provide the parse function and the destination of each argument. 
+     * An error is printed in the response if one argument cannot be 
+     * deserialized. 
+     * 
+     * @param args the command line arguments 
+     * @param response the command response 
+     * @param parsers The parse function of each argument.
+     * @param values The destination of each argument.
+     * @param count The number of arguments to deserialize.
+     * @param argsDescription Accessor to the command argsDescription. 
+     * @return true if all the arguments have been deserialized and false otherwise.
+     */
+    static bool decode_arguments(
+        const CommandArgs& args, 
+        const CommandResponsePtr& response, 
+        const argument_parser_t* parsers, 
+        void* const* values,
+        std::size_t count,
+        ConstArray<CommandArgDescription> (*argsDescription)()
+    );
+
+
     /**
      * @brief Generated handler for the Command handler real_handler.
      * @detail In this form, the real_handler is already a valid form of 
@@ -131,152 +195,10 @@ private:
 
     /**
      * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect one argument of type Arg0, this 
-     * argument is deserialized first then if the deserialization was a success, the 
-     * function is called with the deserialized argument and the command response.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        real_handler(arg0, response);
-    }
-
-
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect two argument of type Arg0 and Arg1, 
-     * these arguments are deserialized first then if the deserialization was a success, 
-     * the function real_handler is called with the deserialized arguments and the 
-     * command response as parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0, typename Arg1>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        real_handler(arg0, arg1, response);
-    }
-
-
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, Arg1 and Arg2, 
-     * these arguments are deserialized first then if the deserialization was a success, 
-     * the function real_handler is called with the deserialized arguments and the 
-     * command response as parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0, typename Arg1, typename Arg2>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-        real_handler(arg0, arg1, arg2, response);
-    }
-
-
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, 
-     * Arg1, Arg2 and Arg3. These arguments are deserialized first then if the 
-     * deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0, typename Arg1, typename Arg2, typename Arg3>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, Arg3, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
-        real_handler(arg0, arg1, arg2, arg3, response);
-    }
-
-
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, 
-     * Arg1, Arg2, Arg3 and Arg4. These arguments are deserialized first then if the 
-     * deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
+     * @detail In this form, the real_handler expect N arguments followed by the 
+     * command response. The arguments are deserialized first then if the 
+     * deserialization was a success, the function is called with the 
+     * deserialized arguments and the command response.
      * 
      * @param args the command line arguments 
      * @param response the command response 
@@ -284,479 +206,43 @@ private:
      * unserialized.
      * @param argsDescription Accessor to the command argsDescription. 
      */
-    template<typename Arg0, typename Arg1, typename Arg2, typename Arg3, typename Arg4>
+    template<typename... Params>
     static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, Arg3, Arg4, const CommandResponsePtr&),
+                        void(*real_handler)(Params...),
                         ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
-        real_handler(arg0, arg1, arg2, arg3, arg4, response);
+        // the last parameter of the real handler is the command response
+        generated_handler(
+            args, response, real_handler, argsDescription, 
+            std::make_index_sequence<sizeof...(Params) - 1>()
+        );
     }
 
 
     /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, 
-     * Arg1, Arg2, Arg3, Arg4 and Arg5. These arguments are deserialized first then if the 
-     * deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
+     * @brief Implementation of the generated handler for real handlers 
+     * expecting arguments. Indexes are the positions of the arguments in the 
+     * handler signature.
      */
-    template<typename Arg0, typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5>
+    template<typename... Params, std::size_t... Indexes>
     static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
-        real_handler(arg0, arg1, arg2, arg3, arg4, arg5, response);
-    }
+                        void(*real_handler)(Params...),
+                        ConstArray<CommandArgDescription> (*argsDescription)(), 
+                        std::index_sequence<Indexes...>) { 
+        // descriptor of the arguments, shared by all the commands with the same signature
+        static constexpr argument_parser_t parsers[] = { 
+            &parse_argument<typename argument_type<Indexes, Params...>::type>...
+        };
 
+        std::tuple<typename argument_type<Indexes, Params...>::type...> arguments;
+        void* const values[] = { 
+            &std::get<Indexes>(arguments)...
+        };
 
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, 
-     * Arg1, Arg2, Arg3, Arg4, Arg5 and Arg6. These arguments are deserialized first then 
-     * if the deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0, typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, 
-             typename Arg6>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
+        if (!decode_arguments(args, response, parsers, values, sizeof...(Indexes), argsDescription)) { 
             return;
         }
 
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
-        real_handler(arg0, arg1, arg2, arg3, arg4, arg5, arg6, response);
-    }
-
-
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, 
-     * Arg1, Arg2, Arg3, Arg4, Arg5, Arg6 and Arg7. These arguments are deserialized first then 
-     * if the deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0, typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, 
-             typename Arg6, typename Arg7>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg7>::type arg7;
-        if (!fromString(args[7], arg7)) {
-            print_error(response, 7, argsDescription);
-            return;
-        }     
-
-        real_handler(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, response);
-    }
-
-
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, 
-     * Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7 and Arg8. These arguments are deserialized first then 
-     * if the deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0, typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, 
-             typename Arg6, typename Arg7, typename Arg8>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg7>::type arg7;
-        if (!fromString(args[7], arg7)) {
-            print_error(response, 7, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg8>::type arg8;
-        if (!fromString(args[8], arg8)) {
-            print_error(response, 8, argsDescription);
-            return;
-        }     
-
-        real_handler(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, response);
-    }
-
-
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, 
-     * Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8 and Arg9. These arguments are deserialized first then 
-     * if the deserialization was a success, the function real_handler is called 
-     * with the deserialized arguments and the command response as parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0, typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, 
-             typename Arg6, typename Arg7, typename Arg8, typename Arg9>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, Arg9, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg7>::type arg7;
-        if (!fromString(args[7], arg7)) {
-            print_error(response, 7, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg8>::type arg8;
-        if (!fromString(args[8], arg8)) {
-            print_error(response, 8, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg9>::type arg9;
-        if (!fromString(args[9], arg9)) {
-            print_error(response, 9, argsDescription);
-            return;
-        }
-
-        real_handler(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, response);
-    }
-
-
-    /**
-     * @brief Generated handler for the Command handler real_handler.
-     * @detail In this form, the real_handler expect three argument of type Arg0, 
-     * Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, Arg9 and Arg100. These arguments are deserialized 
-     * first then if the deserialization was a success, the function real_handler 
-     * is called with the deserialized arguments and the command response as 
-     * parameters.
-     * 
-     * @param args the command line arguments 
-     * @param response the command response 
-     * @param real_handler The handler to call once all the arguments have been 
-     * unserialized.
-     * @param argsDescription Accessor to the command argsDescription. 
-     */
-    template<typename Arg0, typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, 
-             typename Arg6, typename Arg7, typename Arg8, typename Arg9, typename Arg10>
-    static void generated_handler(const CommandArgs& args, const CommandResponsePtr& response, 
-                        void(*real_handler)(Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, Arg9, Arg10, const CommandResponsePtr&),
-                        ConstArray<CommandArgDescription> (*argsDescription)()) { 
-        typename remove_reference<Arg0>::type arg0;
-        if (!fromString(args[0], arg0)) {
-            print_error(response, 0, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg1>::type arg1;
-        if (!fromString(args[1], arg1)) {
-            print_error(response, 1, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg2>::type arg2;
-        if (!fromString(args[2], arg2)) {
-            print_error(response, 2, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg3>::type arg3;
-        if (!fromString(args[3], arg3)) {
-            print_error(response, 3, argsDescription);
-            return;
-        }        
-
-        typename remove_reference<Arg4>::type arg4;
-        if (!fromString(args[4], arg4)) {
-            print_error(response, 4, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg5>::type arg5;
-        if (!fromString(args[5], arg5)) {
-            print_error(response, 5, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg6>::type arg6;
-        if (!fromString(args[6], arg6)) {
-            print_error(response, 6, argsDescription);
-            return;
-        }
-
-        typename remove_reference<Arg7>::type arg7;
-        if (!fromString(args[7], arg7)) {
-            print_error(response, 7, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg8>::type arg8;
-        if (!fromString(args[8], arg8)) {
-            print_error(response, 8, argsDescription);
-            return;
-        }     
-
-        typename remove_reference<Arg9>::type arg9;
-        if (!fromString(args[9], arg9)) {
-            print_error(response, 9, argsDescription);
-            return;
-        }             
-
-        typename remove_reference<Arg10>::type arg10;
-        if (!fromString(args[10], arg10)) {
-            print_error(response, 10, argsDescription);
-            return;
-        }     
-
-        real_handler(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, response);
+        real_handler(std::get<Indexes>(arguments)..., response);
     }
 };
 
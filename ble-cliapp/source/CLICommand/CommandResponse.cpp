@@ -14,17 +14,47 @@
 #include <functional>
 #include "CommandResponse.h"
 
+#if ENABLE_COMMAND_TIMING
+#include <chrono>
+#include "drivers/Timer.h"
+#endif
+
 using namespace serialization;
 
 namespace {
 
 void dummyOnClose(const CommandResponse*) { }
 
+#if ENABLE_COMMAND_TIMING
+bool timingEnabled = false;
+
+// runs only while timings are enabled: it prevents deep sleep
+mbed::Timer& timer() {
+    static mbed::Timer instance;
+    return instance;
+}
+
+// microseconds elapsed since the timing has been enabled; wraps like a ticker
+uint32_t now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        timer().elapsed_time()
+    ).count();
+}
+#endif
+
 }
 
 CommandResponse::CommandResponse() :
-    onClose(dummyOnClose), out(), statusCode(), nameSet(0), argumentsSet(0),
-    statusCodeSet(0), resultStarted(0), closed(0) {
+    onClose(dummyOnClose), out(), statusCode(),
+#if ENABLE_COMMAND_TIMING
+    receivedAt(timingEnabled ? now() : 0), handlerStartedAt(0), resultStartedAt(0), procedureEndedAt(0),
+#endif
+    nameSet(0), argumentsSet(0), statusCodeSet(0), resultStarted(0), closed(0),
+    handlerStarted(0), procedureEnded(0)
+#if ENABLE_COMMAND_TIMING
+    , timed(timingEnabled)
+#endif
+    {
     // start the output
     out << startObject;
 }
@@ -75,6 +105,9 @@ CommandResponse::StatusCode_t CommandResponse::getStatusCode() const {
 
 JSONOutputStream& CommandResponse::getResultStream() {
     if(!resultStarted) {
+#if ENABLE_COMMAND_TIMING
+        resultStartedAt = now();
+#endif
         out << key(statusCode < 0 ? "error" : "result");
         resultStarted = 1;
     }
@@ -91,6 +124,7 @@ void CommandResponse::close() {
         return;
     }
 
+    writeTiming();
     out << endObject;
     out.flush();
     closed = 1;
@@ -102,6 +136,65 @@ bool CommandResponse::isClosed() {
     return closed;
 }
 
+void CommandResponse::markHandlerStart() {
+#if ENABLE_COMMAND_TIMING
+    handlerStartedAt = now();
+#endif
+    handlerStarted = 1;
+}
+
+void CommandResponse::markProcedureEnd() {
+#if ENABLE_COMMAND_TIMING
+    procedureEndedAt = now();
+#endif
+    procedureEnded = 1;
+}
+
+bool CommandResponse::enableTiming(bool enable) {
+#if ENABLE_COMMAND_TIMING
+    if(enable == timingEnabled) {
+        return true;
+    }
+
+    if(enable) {
+        timer().reset();
+        timer().start();
+    } else {
+        timer().stop();
+    }
+    timingEnabled = enable;
+    return true;
+#else
+    return enable == false;
+#endif
+}
+
+void CommandResponse::writeTiming() {
+#if ENABLE_COMMAND_TIMING
+    // responses opened or closed while the timing is disabled, like the ones of
+    // enableCommandTiming, would report times of a stopped clock
+    if(!timed || !timingEnabled) {
+        return;
+    }
+
+    const uint32_t closedAt = now();
+
+    // all values are relative to the reception of the command
+    out << key("timing") << startObject;
+    if(handlerStarted) {
+        out << key("handler") << (uint32_t) (handlerStartedAt - receivedAt);
+    }
+    if(resultStarted) {
+        out << key("result") << (uint32_t) (resultStartedAt - receivedAt);
+    }
+    if(procedureEnded) {
+        out << key("procedure") << (uint32_t) (procedureEndedAt - receivedAt);
+    }
+    out << key("close") << (uint32_t) (closedAt - receivedAt);
+    out << endObject;
+#endif
+}
+
 bool CommandResponse::invalidParameters(const char* msg) {
     return setStatusCodeAndMessage(INVALID_PARAMETERS, msg);
 }
@@ -117,6 +117,31 @@ public:
      */
     bool isClosed();
 
+    /**
+     * @brief Record the start of the command handler.
+     */
+    void markHandlerStart();
+
+    /**
+     * @brief Record the end of the asynchronous procedure which has processed
+     * the command.
+     */
+    void markProcedureEnd();
+
+    /**
+     * @brief Enable or disable the report of command timings.
+     * @details When enabled, responses contain a timing object with the time,
+     * in microseconds, elapsed between the reception of the command and the
+     * start of the handler, the start of the result, the end of the asynchronous
+     * procedure and the closure of the response.
+     * Responses of commands received while the timing was disabled, including
+     * the response enabling it, do not contain timings.
+     * @note Timings are available only if the application has been compiled
+     * with ENABLE_COMMAND_TIMING.
+     * @return true if the timings can be reported and false otherwise.
+     */
+    static bool enableTiming(bool enable);
+
     /**
      * @brief shorthand for:
      * \code
@@ -226,14 +251,28 @@ private:
         return true;
     }
 
+    void writeTiming();
+
     OnClose_t onClose;
     serialization::JSONOutputStream out;
     StatusCode_t statusCode;
+#if ENABLE_COMMAND_TIMING
+    uint32_t receivedAt;
+    uint32_t handlerStartedAt;
+    uint32_t resultStartedAt;
+    uint32_t procedureEndedAt;
+#endif
     bool nameSet:1;
     bool argumentsSet:1;
     bool statusCodeSet:1;
     bool resultStarted:1;
     bool closed:1;
+    bool handlerStarted:1;
+    bool procedureEnded:1;
+#if ENABLE_COMMAND_TIMING
+    // the timing was enabled when the command has been received
+    bool timed:1;
+#endif
 };
 
 
@@ -76,6 +76,7 @@ int CommandSuiteImplementation::commandHandler(
     }
 
     // execute the handler
+    response->markHandlerStart();
     command->handler(commandArgs, response);
 
     // if response is not referenced elsewhere, this means that the execution is done,
@@ -14,14 +14,33 @@
 #include "AsyncProcedure.h"
 #include "../CommandEventQueue.h"
 
+AsyncProcedure* AsyncProcedure::runningProcedures = NULL;
+
 AsyncProcedure::AsyncProcedure(const CommandResponsePtr& res, uint32_t t) :
-    response(res), timeoutHandle(NULL), timeout(t) {
+    response(res), timeoutHandle(NULL), timeout(t), nextProcedure(runningProcedures) {
+    runningProcedures = this;
 }
 
 AsyncProcedure::~AsyncProcedure() {
     if(timeoutHandle) {
         getCLICommandEventQueue()->cancel(timeoutHandle);
     }
+
+    for (AsyncProcedure** it = &runningProcedures; *it; it = &(*it)->nextProcedure) {
+        if (*it == this) {
+            *it = nextProcedure;
+            break;
+        }
+    }
+}
+
+void AsyncProcedure::abortAll() {
+    // terminate removes the procedure from the list
+    while (runningProcedures) {
+        AsyncProcedure* procedure = runningProcedures;
+        procedure->doWhenTimeout();
+        procedure->terminate();
+    }
 }
 
 void AsyncProcedure::start() {
@@ -40,6 +59,7 @@ void AsyncProcedure::start() {
 }
 
 void AsyncProcedure::terminate() {
+    response->markProcedureEnd();
     delete this;
 }
 
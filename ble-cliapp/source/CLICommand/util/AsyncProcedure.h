@@ -95,6 +95,14 @@ struct AsyncProcedure {
     template<typename ProcedureType, typename T0, typename T1, typename T2, typename T3, typename T4, typename T5>
     friend void startProcedure(const T0& arg0, const T1& arg1, const T2& arg2, const T3& arg3, const T4& arg4, const T5& arg5);
 
+    /**
+     * @brief End all the procedures running.
+     * @details Procedures are ended like on timeout: doWhenTimeout is called
+     * then the procedure is terminated. This is used to bring the application
+     * back to an idle state without a reset of the board.
+     */
+    static void abortAll();
+
 protected:
 
     /**
@@ -151,6 +159,10 @@ private:
 
     eq::EventQueue::event_handle_t timeoutHandle;
     uint32_t timeout;
+
+    // intrusive list of the procedures running
+    static AsyncProcedure* runningProcedures;
+    AsyncProcedure* nextProcedure;
 };
 
 /**
@@ -13,16 +13,42 @@
  */
 #include "BLECommands.h"
 #include "Serialization/BLECommonSerializer.h"
+#include "Serialization/GapSerializer.h"
+#include "Serialization/GapAdvertisingDataSerializer.h"
+#include "Serialization/CharacteristicProperties.h"
+#include "Serialization/CharacteristicSecurity.h"
+#include "Serialization/SecurityManagerSerialization.h"
 #include "ble/common/FunctionPointerWithContext.h"
 #include "CLICommand/util/AsyncProcedure.h"
 #include "CLICommand/CommandHelper.h"
 #include "Common.h"
+#include "hal/us_ticker_api.h"
+#include "platform/mbed_stats.h"
+#include "CLICommand/CommandEventQueue.h"
+#include "util/StackWatermark.h"
+
+#include "parameters/AdvertisingParameters.h"
+#include "parameters/AdvDataBuilder.h"
+#include "parameters/ScanParameters.h"
+#include "parameters/ConnectionParameters.h"
+#include "GattClientCommands.h"
+#include "SecurityManagerCommands.h"
 
 #if not defined(NO_FILESYSTEM)
 #include "LittleFileSystem.h"
 #include "HeapBlockDevice.h"
+#include "util/LatencyBlockDevice.h"
 #endif //not defined(NO_FILESYSTEM)
 
+// same defaults as the registration of the suites in main.cpp
+#ifndef ENABLE_GATT_CLIENT_COMMANDS
+#define ENABLE_GATT_CLIENT_COMMANDS 1
+#endif
+
+#ifndef ENABLE_SECURITY_MANAGER_COMMANDS
+#define ENABLE_SECURITY_MANAGER_COMMANDS 1
+#endif
+
 using mbed::util::SharedPointer;
 
 // isolation
@@ -113,6 +139,51 @@ DECLARE_CMD(ResetCommand) {
 };
 
 
+DECLARE_CMD(ResetStateCommand) {
+    CMD_NAME("resetState")
+
+    CMD_HELP(
+        "Restore the application to its initial state without a reset of the board.\r\n"
+        "The bonding state is purged, the automatic pairing and the authorisation "
+        "of pairing requests are disabled, the whitelist is cleared, the ble instance "
+        "is shutdown - which release the services registered in the GattServer - and "
+        "the parameters builders, the GATT discovery cache and the command timing are reset.\r\n"
+        "Procedures still running are not affected: they are ended by the character "
+        "CTRL+C (0x03) received on the serial port."
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        if(get_ble().hasInitialized()) {
+            // fails if the security manager has not been initialized: nothing to purge then.
+            sm().purgeAllBondingState();
+#if ENABLE_SECURITY_MANAGER_COMMANDS
+            SecurityManagerCommandSuiteDescription::reset();
+#endif
+
+            ble::whitelist_t whitelist = { NULL, 0, 0 };
+            gap().setWhitelist(whitelist);
+
+            ble_error_t err = get_ble().shutdown();
+            if(err) {
+                response->faillure(err);
+                return;
+            }
+        }
+
+        AdvertisingParametersCommandSuiteDescription::reset();
+        AdvertisingDataBuilderCommandSuiteDescription::reset();
+        ScanParametersCommandSuiteDescription::reset();
+        ConnectionParametersCommandSuiteDescription::reset();
+#if ENABLE_GATT_CLIENT_COMMANDS
+        GattClientCommandSuiteDescription::reset();
+#endif
+        CommandResponse::enableTiming(false);
+
+        response->success();
+    }
+};
+
+
 DECLARE_CMD(GetVersionCommand) {
     CMD_NAME("getVersion")
     
@@ -134,24 +205,223 @@ DECLARE_CMD(GetVersionCommand) {
 };
 
 
+DECLARE_CMD(EnableCommandTiming) {
+    CMD_NAME("enableCommandTiming")
+
+    CMD_HELP(
+        "Enable or disable the report of the timing of commands.\r\n"
+        "When enabled, every response contains a timing object with the time "
+        "in microseconds elapsed between the reception of the command and: "
+        "the start of its handler, the start of its result, the end of its "
+        "asynchronous procedure and the closure of the response."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("bool", "enable", "Enable or disable the command timings")
+    )
+
+    CMD_HANDLER(bool enable, CommandResponsePtr& response) {
+        if(CommandResponse::enableTiming(enable)) {
+            response->success();
+        } else {
+            response->notImplemented("Command timing is not available, recompile with ENABLE_COMMAND_TIMING");
+        }
+    }
+};
+
+
+#if ENABLE_SERIALIZER_BENCHMARK
+/*
+ * Time, in µs, the serialization and deserialization of every entry of the
+ * mapping of T, with the serializer and with a linear search of the mapping.
+ */
+template<typename T>
+static void benchmarkSerializer(serialization::JSONOutputStream& os, const char* name, uint16_t iterations) {
+    using namespace serialization;
+    typedef Serializer<T> serializer;
+    typedef typename serializer::serialized_type type;
+
+    const ConstArray<ValueToStringMapping<type> > map = serializer::description::mapping();
+    const char* error = serializer::description::errorMessage();
+    // results are accumulated so the calls cannot be optimized away
+    volatile uintptr_t sink = 0;
+    type value;
+
+    // the first use builds the indexes
+    sink += (uintptr_t) serializer::toString(map[0].value);
+
+    uint32_t start = us_ticker_read();
+    for (uint16_t i = 0; i < iterations; ++i) {
+        for (std::size_t j = 0; j < map.count(); ++j) {
+            sink += (uintptr_t) serializer::toString(map[j].value);
+        }
+    }
+    const uint32_t toStringTime = us_ticker_read() - start;
+
+    start = us_ticker_read();
+    for (uint16_t i = 0; i < iterations; ++i) {
+        for (std::size_t j = 0; j < map.count(); ++j) {
+            sink += (uintptr_t) serializer::linearToString(map[j].value, map, error);
+        }
+    }
+    const uint32_t linearToStringTime = us_ticker_read() - start;
+
+    start = us_ticker_read();
+    for (uint16_t i = 0; i < iterations; ++i) {
+        for (std::size_t j = 0; j < map.count(); ++j) {
+            sink += serializer::fromString(map[j].str, value);
+        }
+    }
+    const uint32_t fromStringTime = us_ticker_read() - start;
+
+    start = us_ticker_read();
+    for (uint16_t i = 0; i < iterations; ++i) {
+        for (std::size_t j = 0; j < map.count(); ++j) {
+            sink += serializer::linearFromString(map[j].str, value, map);
+        }
+    }
+    const uint32_t linearFromStringTime = us_ticker_read() - start;
+
+    os << startObject <<
+        key("type") << name <<
+        key("entries") << (uint32_t) map.count() <<
+        key("dense_index") << serializer::hasDenseIndex() <<
+        key("sorted_index") << serializer::hasSortedIndex() <<
+        key("consistent") << serializer::checkIndex() <<
+        key("to_string") << toStringTime <<
+        key("linear_to_string") << linearToStringTime <<
+        key("from_string") << fromStringTime <<
+        key("linear_from_string") << linearFromStringTime <<
+    endObject;
+}
+
+#define BENCHMARK_SERIALIZER(T) benchmarkSerializer<T>(os, #T, iterations)
+#endif //ENABLE_SERIALIZER_BENCHMARK
+
+DECLARE_CMD(BenchmarkSerializers) {
+    CMD_NAME("benchmarkSerializers")
+
+    CMD_HELP(
+        "Measure the time taken to serialize and deserialize every entry of the "
+        "enum serializers, with their index and with a linear search, and check "
+        "that both give the same results. Available when compiled with "
+        "ENABLE_SERIALIZER_BENCHMARK."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("uint16_t", "iterations", "Number of passes over the entries of each serializer")
+    )
+
+    CMD_HANDLER(uint16_t iterations, CommandResponsePtr& response) {
+#if ENABLE_SERIALIZER_BENCHMARK
+        using namespace serialization;
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+
+        os << startArray;
+        BENCHMARK_SERIALIZER(ble_error_t);
+        BENCHMARK_SERIALIZER(HVXType_t);
+        BENCHMARK_SERIALIZER(ble::phy_t::type);
+        BENCHMARK_SERIALIZER(ble::peer_address_type_t);
+        BENCHMARK_SERIALIZER(ble::peripheral_privacy_configuration_t::resolution_strategy_t);
+        BENCHMARK_SERIALIZER(ble::central_privacy_configuration_t::resolution_strategy_t);
+        BENCHMARK_SERIALIZER(ble::advertising_type_t::type);
+        BENCHMARK_SERIALIZER(ble::own_address_type_t::type);
+        BENCHMARK_SERIALIZER(ble::advertising_filter_policy_t::type);
+        BENCHMARK_SERIALIZER(ble::scanning_filter_policy_t::type);
+        BENCHMARK_SERIALIZER(ble::initiator_filter_policy_t::type);
+        BENCHMARK_SERIALIZER(ble::duplicates_filter_t::type);
+        BENCHMARK_SERIALIZER(ble::peer_address_type_t::type);
+        BENCHMARK_SERIALIZER(ble::local_disconnection_reason_t::type);
+        BENCHMARK_SERIALIZER(ble::controller_supported_features_t::type);
+        BENCHMARK_SERIALIZER(ble::advertising_data_status_t::type);
+        BENCHMARK_SERIALIZER(ble::adv_data_type_t::type);
+        BENCHMARK_SERIALIZER(ble::adv_data_appearance_t::type);
+        BENCHMARK_SERIALIZER(ble::adv_data_flags_t);
+        BENCHMARK_SERIALIZER(GattCharacteristic::Properties_t);
+        BENCHMARK_SERIALIZER(ble::att_security_requirement_t::type);
+        BENCHMARK_SERIALIZER(SecurityManager::SecurityIOCapabilities_t);
+        BENCHMARK_SERIALIZER(SecurityManager::SecurityCompletionStatus_t);
+        BENCHMARK_SERIALIZER(SecurityManager_link_encryption_t);
+        os << endArray;
+#else
+        (void) iterations;
+        response->notImplemented("Serializer benchmark is not available, recompile with ENABLE_SERIALIZER_BENCHMARK");
+#endif //ENABLE_SERIALIZER_BENCHMARK
+    }
+};
+
+#if ENABLE_SERIALIZER_BENCHMARK
+#undef BENCHMARK_SERIALIZER
+#endif //ENABLE_SERIALIZER_BENCHMARK
+
+
+#if not defined(NO_FILESYSTEM)
+static LatencyBlockDevice* block_device = NULL;
+#endif //not defined(NO_FILESYSTEM)
+
 DECLARE_CMD(CreateFilesystem) {
     CMD_NAME("createFilesystem")
 
-    CMD_HELP("Create a filesystem")
+    CMD_HELP(
+        "Create a filesystem in RAM. The size of the block device defaults to "
+        "FILESYSTEM_SIZE. The latency of flash devices can be emulated by delaying "
+        "the erase of each erase unit and the programming of each program unit."
+    )
 
-    CMD_HANDLER(CommandResponsePtr& response) {
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 3;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
 #if defined(NO_FILESYSTEM)
         response->faillure();
 #else
+        uint32_t size = FILESYSTEM_SIZE;
+        uint32_t eraseLatency = 0;
+        uint32_t programLatency = 0;
+
+        if ((args.count() > 0 && !fromString(args[0], size)) ||
+            (args.count() > 1 && !fromString(args[1], eraseLatency)) ||
+            (args.count() > 2 && !fromString(args[2], programLatency))) {
+            response->invalidParameters("[<size> [<erase_latency> [<program_latency>]]] expected");
+            return;
+        }
+
+        if (size == 0 || (size % FILESYSTEM_BLOCK_SIZE)) {
+            response->invalidParameters("the size should be a multiple of the block size");
+            return;
+        }
+
         static LittleFileSystem& fs = *(new LittleFileSystem("fs"));
-        static HeapBlockDevice& bd = *(new HeapBlockDevice(4096, 256));
+        static HeapBlockDevice* heap_bd = NULL;
+
+        // the block device is reallocated when its size changes
+        if (heap_bd && heap_bd->size() != size) {
+            fs.unmount();
+            block_device->deinit();
+            delete block_device;
+            delete heap_bd;
+            block_device = NULL;
+            heap_bd = NULL;
+        }
 
-        bd.init();
-        bd.erase(0, bd.size());
-        int err = fs.mount(&bd);
+        if (!heap_bd) {
+            heap_bd = new HeapBlockDevice(size, FILESYSTEM_BLOCK_SIZE);
+            block_device = new LatencyBlockDevice(heap_bd);
+        }
+
+        // the filesystem is formatted without latency
+        block_device->setLatency(0, 0);
+        block_device->init();
+        block_device->erase(0, block_device->size());
+        int err = fs.mount(block_device);
         if (err) {
-            err = fs.reformat(&bd);
+            err = fs.reformat(block_device);
         }
+        block_device->setLatency(eraseLatency, programLatency);
 
         if (err == 0) {
             response->success();
@@ -162,13 +432,104 @@ DECLARE_CMD(CreateFilesystem) {
     }
 };
 
+
+DECLARE_CMD(GetDiagnostics) {
+    CMD_NAME("getDiagnostics")
+
+    CMD_HELP(
+        "Report the memory usage of the application: heap usage and allocations, "
+        "stack high watermark of the main loop and occupancy of the event queue.\r\n"
+        "Heap statistics are available only if the application has been "
+        "compiled with MBED_HEAP_STATS_ENABLED."
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON object", "heap", "Current and peak heap usage, allocations count and failures"),
+        CMD_RESULT("JSON object", "stack", "Size, current and peak usage of the main stack"),
+        CMD_RESULT("JSON object", "event_queue", "Current and peak events pending and posts rejected")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        mbed_stats_heap_t heap;
+        mbed_stats_heap_get(&heap);
+        const StackWatermark::Usage stack = StackWatermark::usage();
+        const eq::EventQueue::Statistics queue = getCLICommandEventQueue()->get_statistics();
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+
+        os << startObject <<
+            key("heap") << startObject <<
+#if MBED_HEAP_STATS_ENABLED
+                key("enabled") << true <<
+                key("current") << heap.current_size <<
+                key("peak") << heap.max_size <<
+                key("reserved") << heap.reserved_size <<
+                key("overhead") << heap.overhead_size <<
+                key("allocated") << heap.total_size <<
+                key("allocations") << heap.alloc_cnt <<
+                key("failed_allocations") << heap.alloc_fail_cnt <<
+#else
+                key("enabled") << false <<
+#endif
+            endObject <<
+            key("stack") << startObject <<
+                key("painted") << StackWatermark::painted() <<
+                key("size") << stack.size <<
+                key("current") << stack.current <<
+                key("peak") << stack.peak <<
+                key("free") << (uint32_t) (stack.size - stack.peak) <<
+            endObject <<
+            key("event_queue") << startObject <<
+                key("size") << (uint32_t) queue.size <<
+                key("capacity") << (uint32_t) queue.capacity <<
+                key("peak") << (uint32_t) queue.peak <<
+                key("failed_posts") << (uint32_t) queue.failed_posts <<
+            endObject <<
+        endObject;
+    }
+};
+
+
+DECLARE_CMD(ResetDiagnostics) {
+    CMD_NAME("resetDiagnostics")
+
+    CMD_HELP(
+        "Restart the measure of the peaks reported by getDiagnostics: the main "
+        "stack is painted again and the event queue peak and failed posts are "
+        "cleared. The heap peak cannot be reset."
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        getCLICommandEventQueue()->reset_statistics();
+        if (StackWatermark::paint()) {
+            response->success();
+        } else {
+            response->faillure("the bounds of the main stack are not known");
+        }
+    }
+};
+
 } // end of annonymous namespace
 
+#if not defined(NO_FILESYSTEM)
+LatencyBlockDevice* BLECommandSuiteDescription::getBlockDevice() {
+    return block_device;
+}
+#endif //not defined(NO_FILESYSTEM)
+
 
 DECLARE_SUITE_COMMANDS(BLECommandSuiteDescription, 
     CMD_INSTANCE(ShutdownCommand),
     CMD_INSTANCE(InitCommand),
     CMD_INSTANCE(ResetCommand),
+    CMD_INSTANCE(ResetStateCommand),
     CMD_INSTANCE(GetVersionCommand),
-    CMD_INSTANCE(CreateFilesystem)
+    CMD_INSTANCE(EnableCommandTiming),
+    CMD_INSTANCE(BenchmarkSerializers),
+    CMD_INSTANCE(CreateFilesystem),
+    CMD_INSTANCE(GetDiagnostics),
+    CMD_INSTANCE(ResetDiagnostics)
 )
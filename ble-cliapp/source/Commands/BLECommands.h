@@ -16,6 +16,15 @@
 
 #include "CLICommand/CommandSuite.h"
 #include "ble/BLE.h"
+#include "util/LatencyBlockDevice.h"
+
+#ifndef FILESYSTEM_SIZE
+#define FILESYSTEM_SIZE 4096
+#endif
+
+#ifndef FILESYSTEM_BLOCK_SIZE
+#define FILESYSTEM_BLOCK_SIZE 256
+#endif
 
 class BLECommandSuiteDescription {
 
@@ -32,6 +41,14 @@ public:
         return "BLE <command> <command arguments>.";
     }
 
+#if not defined(NO_FILESYSTEM)
+    /**
+     * Return the block device of the filesystem or NULL if the filesystem has
+     * not been created.
+     */
+    static LatencyBlockDevice* getBlockDevice();
+#endif //not defined(NO_FILESYSTEM)
+
     // see implementation
     static ConstArray<const Command*> commands();
 };
@@ -16,6 +16,7 @@
 
 #include "CLICommand/CommandSuite.h"
 #include "ble/BLE.h"
+#include "ble/gatt/ChainableGattServerEventHandler.h"
 #include <core-util/SharedPointer.h>
 
 /**
@@ -46,6 +47,17 @@ inline ble::GattServer& gattServer() {
     return get_ble().gattServer();
 }
 
+/**
+ * @brief Return the chain of GattServer event handlers of this application.
+ * @details The GattServer accepts a single event handler: handlers are added
+ * to this chain, which is the one installed in the GattServer, rather than
+ * replacing each other.
+ */
+inline ChainableGattServerEventHandler& gattServerEventHandlers() {
+    static ChainableGattServerEventHandler handlers;
+    return handlers;
+}
+
 /**
  * @brief Return the instance of the security manager of this device.
  */
@@ -12,18 +12,22 @@
  * limitations under the License.
  */
 
-
+#include <string.h>
+#include <algorithm>
 #include "ble/BLE.h"
 #include "ble/Gap.h"
 #include "Serialization/GapSerializer.h"
 #include "Serialization/GapAdvertisingDataSerializer.h"
 #include "Serialization/BLECommonSerializer.h"
+#include "Serialization/Measure.h"
 #include "CLICommand/CommandSuite.h"
 #include "CLICommand/util/AsyncProcedure.h"
+#include "CLICommand/CommandEventQueue.h"
 #include "Common.h"
 #include "CLICommand/CommandHelper.h"
 
 #include "Timer.h"
+#include "hal/us_ticker_api.h"
 
 #include "GapCommands.h"
 
@@ -33,6 +37,8 @@
 #include "parameters/ConnectionParameters.h"
 #include "Serialization/Hex.h"
 #include "util/HijackMember.h"
+#include "util/GapEventDispatcher.h"
+#include "util/ConnectionStatistics.h"
 #include "GapImpl.h"
 
 typedef bool (ble::impl::Gap::*gap_impl_is_radio_active_method)() const;
@@ -343,8 +349,6 @@ struct EventHandler : public ble::Gap::EventHandler {
                 key("reason") << event.getReason() <<
             endObject <<
         endObject;
-
-        disconnection_chain.call(event);
     }
 
     virtual void onReadPhy(
@@ -394,16 +398,82 @@ struct EventHandler : public ble::Gap::EventHandler {
             endObject <<
         endObject;
     }
+};
+
+/**
+ * Notify the disconnection callbacks registered by other command suites. It
+ * observes disconnections, it receives them even when a procedure captures them.
+ */
+struct DisconnectionObserver : public ble::Gap::EventHandler {
+    void onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event) override
+    {
+        disconnection_chain.call(event);
+    }
 
     CallChainOfFunctionPointersWithContext<const ble::DisconnectionCompleteEvent&> disconnection_chain;
 };
 
 static EventHandler handler;
-
-void enable_event_handling() {
-    gap().setEventHandler(&handler);
+static DisconnectionObserver disconnection_observer;
+static ConnectionStatistics connection_statistics;
+static GapEventDispatcher dispatcher;
+
+static void enable_event_handling() {
+    static bool initialized = false;
+    if (!initialized) {
+        dispatcher.setDefaultHandler(&handler);
+        dispatcher.subscribe(
+            &disconnection_observer,
+            GapEventDispatcher::mask(GapEventDispatcher::DISCONNECTION_COMPLETE),
+            GapEventDispatcher::OBSERVE
+        );
+        dispatcher.subscribe(
+            &connection_statistics,
+            GapEventDispatcher::mask(GapEventDispatcher::CONNECTION_COMPLETE) |
+            GapEventDispatcher::mask(GapEventDispatcher::CONNECTION_PARAMETERS_UPDATE_COMPLETE) |
+            GapEventDispatcher::mask(GapEventDispatcher::READ_PHY) |
+            GapEventDispatcher::mask(GapEventDispatcher::PHY_UPDATE_COMPLETE) |
+            GapEventDispatcher::mask(GapEventDispatcher::DISCONNECTION_COMPLETE),
+            GapEventDispatcher::OBSERVE
+        );
+        initialized = true;
+    }
+    gap().setEventHandler(&dispatcher);
 }
 
+/**
+ * Subscription of a procedure to the Gap events it consumes. While it is alive,
+ * these events are not reported by the default event handler unless they are
+ * only observed.
+ */
+class EventSubscription {
+public:
+    EventSubscription(ble::Gap::EventHandler* handler, GapEventDispatcher::event_t event) :
+        id(dispatcher.subscribe(handler, GapEventDispatcher::mask(event))) { }
+
+    EventSubscription(
+        ble::Gap::EventHandler* handler,
+        GapEventDispatcher::event_mask_t events,
+        GapEventDispatcher::mode_t mode
+    ) : id(dispatcher.subscribe(handler, events, mode)) { }
+
+    ~EventSubscription() {
+        dispatcher.unsubscribe(id);
+    }
+
+    bool is_valid() const {
+        return id != GapEventDispatcher::INVALID_SUBSCRIPTION;
+    }
+
+private:
+    EventSubscription(const EventSubscription&);
+    EventSubscription& operator=(const EventSubscription&);
+
+    GapEventDispatcher::subscription_t id;
+};
+
+static const char* const NO_EVENT_SUBSCRIPTION = "Too many procedures waiting for Gap events";
+
 DECLARE_CMD(GetAddressCommand) {
     CMD_NAME("getAddress")
     CMD_HELP(
@@ -436,6 +506,22 @@ DECLARE_CMD(GetAddressCommand) {
     }
 };
 
+DECLARE_CMD(SetRandomStaticAddressCommand) {
+    CMD_NAME("setRandomStaticAddress")
+    CMD_HELP(
+        "Set the random static address of this device. It is used when the own "
+        "address type of a procedure is RANDOM."
+    )
+
+    CMD_ARGS(
+        CMD_ARG("ble::address_t", "address", "The random static address")
+    )
+
+    CMD_HANDLER(ble::address_t& address, CommandResponsePtr& response) {
+        reportErrorOrSuccess(response, gap().setRandomStaticAddress(address));
+    }
+};
+
 DECLARE_CMD(GetMaxWhitelistSizeCommand) {
     CMD_NAME("getMaxWhitelistSize")
     CMD_HELP("get the maximum size the whitelist can take")
@@ -557,19 +643,18 @@ DECLARE_CMD(EnablePrivacyCommand) {
         EnablePrivacyProcedure(
             const SharedPointer<CommandResponse>& response,
             uint32_t procedureTimeout
-        ) : AsyncProcedure(response, procedureTimeout)
-        {
-        }
-
-        virtual ~EnablePrivacyProcedure()
+        ) : AsyncProcedure(response, procedureTimeout),
+            _events(this, GapEventDispatcher::PRIVACY_ENABLED)
         {
-            // revert to default event handler
-            enable_event_handling();
         }
 
         virtual bool doStart()
         {
-            gap().setEventHandler(this);
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
+
             ble_error_t result = gap().enablePrivacy(true);
             if (result != BLE_ERROR_NONE) {
                 reportErrorOrSuccess(
@@ -591,6 +676,8 @@ DECLARE_CMD(EnablePrivacyCommand) {
             response->faillure(BLE_ERROR_INTERNAL_STACK_FAILURE);
             terminate();
         }
+
+        EventSubscription _events;
     };
 
 };
@@ -707,15 +794,15 @@ DECLARE_CMD(ReadPhyCommand) {
             ble::connection_handle_t connectionHandle,
             const SharedPointer<CommandResponse>& response,
             uint32_t procedureTimeout
-        ) : AsyncProcedure(response, procedureTimeout), handle(connectionHandle) { }
-
-        virtual ~ReadPhyProcedure() {
-            // revert to default event handler
-            enable_event_handling();
-        }
+        ) : AsyncProcedure(response, procedureTimeout), handle(connectionHandle),
+            _events(this, GapEventDispatcher::READ_PHY) { }
 
         virtual bool doStart() {
-            gap().setEventHandler(this);
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
+
             ble_error_t result = gap().readPhy(handle);
             if (result != BLE_ERROR_NONE) {
                 reportErrorOrSuccess(
@@ -747,6 +834,7 @@ DECLARE_CMD(ReadPhyCommand) {
         }
 
         ble::connection_handle_t handle;
+        EventSubscription _events;
     };
 };
 
@@ -863,6 +951,10 @@ DECLARE_CMD(SetAdvertisingPayload) {
 
 DECLARE_CMD(ApplyAdvPayloadFromBuilder) {
     CMD_NAME("applyAdvPayloadFromBuilder")
+    CMD_HELP(
+        "Apply the payload of the advDataBuilder builder selected: the default "
+        "builder unless a set builder has been selected with advDataBuilder selectSet."
+    )
     CMD_ARGS(
         CMD_ARG("ble::advertising_handle_t", "handle", "Advertising set (legacy = 0) to apply builder data to.")
     )
@@ -872,6 +964,56 @@ DECLARE_CMD(ApplyAdvPayloadFromBuilder) {
     }
 };
 
+DECLARE_CMD(ApplyAdvPayloadToSets) {
+    CMD_NAME("applyAdvPayloadToSets")
+    CMD_HELP(
+        "Apply to each advertising set listed the payload of its builder. The "
+        "payload of the builder selected is applied to the sets without builder."
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 0xFF;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        if (args.count() == 0) {
+            response->invalidParameters("<handle> [<handle>...] expected");
+            return;
+        }
+
+        for (size_t i = 0; i < args.count(); ++i) {
+            ble::advertising_handle_t handle;
+            if (!fromString(args[i], handle)) {
+                response->invalidParameters("invalid advertising handle");
+                return;
+            }
+        }
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+        os << startArray;
+
+        for (size_t i = 0; i < args.count(); ++i) {
+            ble::advertising_handle_t handle;
+            fromString(args[i], handle);
+
+            mbed::Span<const uint8_t> payload;
+            if (!AdvertisingDataBuilderCommandSuiteDescription::getForSet(handle, payload)) {
+                payload = AdvertisingDataBuilderCommandSuiteDescription::get();
+            }
+
+            os << startObject <<
+                key("handle") << handle <<
+                key("length") << (uint16_t) payload.size() <<
+                key("status") << gap().setAdvertisingPayload(handle, payload) <<
+            endObject;
+        }
+
+        os << endArray;
+    }
+};
+
 DECLARE_CMD(SetAdvertisingScanResponse) {
     CMD_NAME("setAdvertisingScanResponse")
     CMD_ARGS(
@@ -886,6 +1028,11 @@ DECLARE_CMD(SetAdvertisingScanResponse) {
 
 DECLARE_CMD(ApplyScanRespFromBuilder) {
     CMD_NAME("applyScanRespFromBuilder")
+    CMD_HELP(
+        "Apply as scan response the payload of the advDataBuilder builder selected: "
+        "the default builder unless a set builder has been selected with "
+        "advDataBuilder selectSet."
+    )
     CMD_ARGS(
         CMD_ARG("ble::advertising_handle_t", "handle", "Advertising set (legacy = 0) to apply builder data to.")
     )
@@ -913,19 +1060,19 @@ DECLARE_CMD(StartAdvertising) {
             uint8_t maxEvents,
             CommandResponsePtr& response
         ) : AsyncProcedure(response, 1000),
-            _handle(handle), _duration(duration), _maxEvents(maxEvents)
+            _handle(handle), _duration(duration), _maxEvents(maxEvents),
+            _events(this, GapEventDispatcher::ADVERTISING_START)
         {
-            gap().setEventHandler(this);
         }
 
         // AsyncProcedure implementation
 
-        ~StartAdvertisingProcedure() override {
-            // revert to default event handler
-            enable_event_handling();
-        }
-
         bool doStart() override {
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
+
             ble_error_t err = gap().startAdvertising(_handle, _duration, _maxEvents);
             if (err != BLE_ERROR_NONE) {
                 response->faillure(err);
@@ -954,6 +1101,7 @@ DECLARE_CMD(StartAdvertising) {
         ble::advertising_handle_t _handle;
         ble::adv_duration_t _duration;
         uint8_t _maxEvents;
+        EventSubscription _events;
     };
 };
 
@@ -970,19 +1118,19 @@ DECLARE_CMD(StopAdvertising) {
         StopAdvertisingProcedure(
             ble::advertising_handle_t handle,
             CommandResponsePtr& response
-        ) : AsyncProcedure(response, 1000), _handle(handle)
+        ) : AsyncProcedure(response, 1000), _handle(handle),
+            _events(this, GapEventDispatcher::ADVERTISING_END)
         {
-            gap().setEventHandler(this);
         }
 
         // AsyncProcedure implementation
 
-        ~StopAdvertisingProcedure() override {
-            // revert to default event handler
-            enable_event_handling();
-        }
-
         bool doStart() override {
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
+
             ble_error_t err = gap().stopAdvertising(_handle);
             if (err != BLE_ERROR_NONE) {
                 response->faillure(err);
@@ -1009,6 +1157,365 @@ DECLARE_CMD(StopAdvertising) {
 
     private:
         ble::advertising_handle_t _handle;
+        EventSubscription _events;
+    };
+};
+
+DECLARE_CMD(ProvisionAdvertisingSets) {
+    CMD_NAME("provisionAdvertisingSets")
+    CMD_HELP(
+        "Create, configure and start advertising sets one after the other. The sets "
+        "use the advertising parameters of advParams as a template, the payload of "
+        "their builder or the payload of the builder selected. Overrides of the "
+        "template for a set are expressed as <index>:<field>=<value> with the fields "
+        "type, interval, tx_power, primary_phy, secondary_phy, legacy and anonymous. "
+        "A set which fails to be configured or started is destroyed; the sets not "
+        "processed when the procedure times out are reported as pending."
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 0xFF;
+    }
+
+    enum field_t {
+        TYPE,
+        INTERVAL,
+        TX_POWER,
+        PRIMARY_PHY,
+        SECONDARY_PHY,
+        LEGACY,
+        ANONYMOUS
+    };
+
+    struct Override {
+        uint8_t index;
+        field_t field;
+        union {
+            ble::advertising_type_t::type type;
+            uint32_t interval;
+            int8_t tx_power;
+            ble::phy_t::type phy;
+            bool enable;
+        };
+    };
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint8_t count;
+        if (args.count() < 1 || !fromString(args[0], count) || count == 0) {
+            response->invalidParameters("<count> [<index>:<field>=<value>...] expected");
+            return;
+        }
+
+        const size_t overrideCount = args.count() - 1;
+        Override* overrides = new Override[overrideCount];
+        for (size_t i = 0; i < overrideCount; ++i) {
+            if (!parseOverride(args[i + 1], overrides[i]) || overrides[i].index >= count) {
+                response->invalidParameters("invalid override");
+                delete[] overrides;
+                return;
+            }
+        }
+
+        startProcedure<ProvisionAdvertisingSetsProcedure>(
+            count, overrides, overrideCount, response, count * 1000 /* ms */
+        );
+    }
+
+    static bool parseOverride(const char* str, Override& result) {
+        const char* separator = strchr(str, ':');
+        const char* equal = strchr(str, '=');
+        if (!separator || !equal || equal < separator) {
+            return false;
+        }
+
+        char index[4] = { 0 };
+        char field[16] = { 0 };
+        if ((size_t) (separator - str) >= sizeof(index) ||
+            (size_t) (equal - separator - 1) >= sizeof(field)) {
+            return false;
+        }
+        memcpy(index, str, separator - str);
+        memcpy(field, separator + 1, equal - separator - 1);
+        const char* value = equal + 1;
+
+        if (!fromString(index, result.index)) {
+            return false;
+        }
+
+        if (strcmp(field, "type") == 0) {
+            result.field = TYPE;
+            return fromString(value, result.type);
+        } else if (strcmp(field, "interval") == 0) {
+            result.field = INTERVAL;
+            ble::adv_interval_t interval;
+            if (!fromString(value, interval)) {
+                return false;
+            }
+            result.interval = interval.value();
+            return true;
+        } else if (strcmp(field, "tx_power") == 0) {
+            result.field = TX_POWER;
+            return fromString(value, result.tx_power);
+        } else if (strcmp(field, "primary_phy") == 0) {
+            result.field = PRIMARY_PHY;
+            return fromString(value, result.phy);
+        } else if (strcmp(field, "secondary_phy") == 0) {
+            result.field = SECONDARY_PHY;
+            return fromString(value, result.phy);
+        } else if (strcmp(field, "legacy") == 0) {
+            result.field = LEGACY;
+            return fromString(value, result.enable);
+        } else if (strcmp(field, "anonymous") == 0) {
+            result.field = ANONYMOUS;
+            return fromString(value, result.enable);
+        }
+
+        return false;
+    }
+
+    struct ProvisionAdvertisingSetsProcedure : public AsyncProcedure, Gap::EventHandler {
+        enum stage_t {
+            PENDING,
+            CREATE,
+            SET_PAYLOAD,
+            START,
+            STARTED
+        };
+
+        struct Result {
+            ble::advertising_handle_t handle;
+            stage_t stage;
+            ble_error_t status;
+            // time in µs to create and configure the set
+            uint32_t setup;
+            // time in µs between the call to startAdvertising and the start event
+            uint32_t start_latency;
+        };
+
+        ProvisionAdvertisingSetsProcedure(
+            uint8_t count,
+            Override* overrides,
+            size_t overrideCount,
+            CommandResponsePtr& response,
+            uint32_t timeout
+        ) : AsyncProcedure(response, timeout),
+            _count(count), _overrides(overrides), _overrideCount(overrideCount),
+            _results(new Result[count]()), _next(0), _startTimestamp(0),
+            _events(this, GapEventDispatcher::ADVERTISING_START)
+        {
+            for (uint8_t i = 0; i < _count; ++i) {
+                _results[i].stage = PENDING;
+                _results[i].status = BLE_ERROR_NONE;
+            }
+        }
+
+        virtual ~ProvisionAdvertisingSetsProcedure()
+        {
+            delete[] _overrides;
+            delete[] _results;
+        }
+
+        // AsyncProcedure implementation
+
+        virtual bool doStart()
+        {
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
+
+            if (provisionNext()) {
+                return true;
+            }
+
+            reportResults();
+            return false;
+        }
+
+        virtual void doWhenTimeout()
+        {
+            // the set waiting for its start event is reported as timed out and
+            // released; the next ones are reported as pending
+            if (_next < _count) {
+                _results[_next].status = BLE_ERROR_TIMEOUT;
+                gap().stopAdvertising(_results[_next].handle);
+                release(_results[_next]);
+                ++_next;
+            }
+            reportResults();
+        }
+
+        // Gap::EventHandler implementation
+
+        virtual void onAdvertisingStart(const ble::AdvertisingStartEvent &event)
+        {
+            if (_next == _count || event.getAdvHandle() != _results[_next].handle) {
+                return;
+            }
+
+            _results[_next].start_latency = us_ticker_read() - _startTimestamp;
+            _results[_next].stage = STARTED;
+            ++_next;
+
+            if (!provisionNext()) {
+                reportResults();
+                terminate();
+            }
+        }
+
+    private:
+        /*
+         * Provision the next sets until one is waiting for its start event.
+         * Return false once every set has been processed.
+         */
+        bool provisionNext()
+        {
+            while (_next < _count) {
+                Result& result = _results[_next];
+                const uint32_t setupStart = us_ticker_read();
+
+                ble::AdvertisingParameters parameters = getAdvertisingParameters();
+                applyOverrides(_next, parameters);
+
+                result.stage = CREATE;
+                result.status = gap().createAdvertisingSet(&result.handle, parameters);
+                if (result.status != BLE_ERROR_NONE) {
+                    ++_next;
+                    continue;
+                }
+
+                mbed::Span<const uint8_t> payload;
+                if (!AdvertisingDataBuilderCommandSuiteDescription::getForSet(result.handle, payload)) {
+                    payload = AdvertisingDataBuilderCommandSuiteDescription::get();
+                }
+
+                result.stage = SET_PAYLOAD;
+                result.status = gap().setAdvertisingPayload(result.handle, payload);
+                if (result.status != BLE_ERROR_NONE) {
+                    release(result);
+                    ++_next;
+                    continue;
+                }
+
+                result.stage = START;
+                _startTimestamp = us_ticker_read();
+                result.setup = _startTimestamp - setupStart;
+                result.status = gap().startAdvertising(result.handle);
+                if (result.status != BLE_ERROR_NONE) {
+                    release(result);
+                    ++_next;
+                    continue;
+                }
+
+                return true;
+            }
+
+            return false;
+        }
+
+        // a set created but not started is not left behind
+        void release(const Result& result)
+        {
+            gap().destroyAdvertisingSet(result.handle);
+        }
+
+        void applyOverrides(uint8_t index, ble::AdvertisingParameters& parameters)
+        {
+            for (size_t i = 0; i < _overrideCount; ++i) {
+                const Override& o = _overrides[i];
+                if (o.index != index) {
+                    continue;
+                }
+
+                switch (o.field) {
+                    case TYPE:
+                        parameters.setType(o.type);
+                        break;
+                    case INTERVAL:
+                        parameters.setPrimaryInterval(
+                            ble::adv_interval_t(o.interval),
+                            ble::adv_interval_t(o.interval)
+                        );
+                        break;
+                    case TX_POWER:
+                        parameters.setTxPower(o.tx_power);
+                        break;
+                    case PRIMARY_PHY:
+                        parameters.setPhy(o.phy, parameters.getSecondaryPhy());
+                        break;
+                    case SECONDARY_PHY:
+                        parameters.setPhy(parameters.getPrimaryPhy(), o.phy);
+                        break;
+                    case LEGACY:
+                        parameters.setUseLegacyPDU(o.enable);
+                        break;
+                    case ANONYMOUS:
+                        parameters.setAnonymousAdvertising(o.enable);
+                        break;
+                }
+            }
+        }
+
+        static const char* stageToString(stage_t stage)
+        {
+            switch (stage) {
+                case PENDING:
+                    return "pending";
+                case CREATE:
+                    return "create";
+                case SET_PAYLOAD:
+                    return "set_payload";
+                case START:
+                    return "start";
+                case STARTED:
+                    return "started";
+            }
+            return "unknown";
+        }
+
+        void reportResults()
+        {
+            uint8_t started = 0;
+            for (uint8_t i = 0; i < _count; ++i) {
+                if (_results[i].stage == STARTED) {
+                    ++started;
+                }
+            }
+
+            response->success();
+            JSONOutputStream& os = response->getResultStream();
+
+            os << startObject <<
+                key("count") << _count <<
+                key("started") << started <<
+                key("sets") << startArray;
+
+            for (uint8_t i = 0; i < _count; ++i) {
+                const Result& result = _results[i];
+                os << startObject <<
+                    key("stage") << stageToString(result.stage) <<
+                    key("status") << (result.stage == PENDING ? BLE_ERROR_TIMEOUT : result.status);
+                if (result.stage != PENDING && result.stage != CREATE) {
+                    os << key("handle") << result.handle;
+                }
+                if (result.stage == STARTED) {
+                    os << key("setup") << result.setup <<
+                        key("start_latency") << result.start_latency;
+                }
+                os << endObject;
+            }
+
+            os << endArray << endObject;
+        }
+
+        uint8_t _count;
+        Override* _overrides;
+        size_t _overrideCount;
+        Result* _results;
+        uint8_t _next;
+        uint32_t _startTimestamp;
+        EventSubscription _events;
     };
 };
 
@@ -1141,9 +1648,14 @@ DECLARE_CMD(ScanForAddress) {
             ble::address_t peer_address,
             uint32_t timeout,
             CommandResponsePtr& response
-        ) : AsyncProcedure(response, timeout), peer_address(peer_address)
+        ) : AsyncProcedure(response, timeout), peer_address(peer_address),
+            _events(this, GapEventDispatcher::ADVERTISING_REPORT)
         {
-            gap().setEventHandler(this);
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return;
+            }
+
             ble_error_t err = gap().startScan();
             if (err != BLE_ERROR_NONE) {
                 response->faillure(err);
@@ -1160,19 +1672,14 @@ DECLARE_CMD(ScanForAddress) {
 
         // AsyncProcedure implementation
 
-        virtual ~ScanForAddressProcedure(){
-            // revert to default event handler
-            enable_event_handling();
-        }
-
         virtual bool doStart() {
-            return true;
+            return _events.is_valid();
         }
 
         virtual void doWhenTimeout() {
             timer.stop();
             gap().stopScan();
-            response->getResultStream() << endArray;
+            response->getResultStream() << lineBreak << endArray;
         }
 
         // Gap::EventHandler implementation
@@ -1185,7 +1692,7 @@ DECLARE_CMD(ScanForAddress) {
 
             JSONOutputStream& os = response->getResultStream();
 
-            os << startObject <<
+            os << lineBreak << startObject <<
                 key("time") << (uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(timer.elapsed_time()).count() <<
                 key("connectable") << event.getType().connectable() <<
                 key("scannable") << event.getType().scannable_advertising() <<
@@ -1238,6 +1745,7 @@ DECLARE_CMD(ScanForAddress) {
     private:
         ble::address_t peer_address;
         mbed::Timer timer;
+        EventSubscription _events;
     };
 };
 
@@ -1260,9 +1768,14 @@ DECLARE_CMD(ScanForData) {
             container::Vector<uint8_t> data,
             uint32_t timeout,
             CommandResponsePtr& response
-        ) : AsyncProcedure(response, timeout), _data(data)
+        ) : AsyncProcedure(response, timeout), _data(data),
+            _events(this, GapEventDispatcher::ADVERTISING_REPORT)
         {
-            gap().setEventHandler(this);
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return;
+            }
+
             ble_error_t err = gap().startScan();
             if (err != BLE_ERROR_NONE) {
                 response->faillure(err);
@@ -1279,19 +1792,14 @@ DECLARE_CMD(ScanForData) {
 
         // AsyncProcedure implementation
 
-        virtual ~ScanForDataProcedure(){
-            // revert to default event handler
-            enable_event_handling();
-        }
-
         virtual bool doStart() {
-            return true;
+            return _events.is_valid();
         }
 
         virtual void doWhenTimeout() {
             timer.stop();
             gap().stopScan();
-            response->getResultStream() << endArray;
+            response->getResultStream() << lineBreak << endArray;
         }
 
         // Gap::EventHandler implementation
@@ -1304,7 +1812,7 @@ DECLARE_CMD(ScanForData) {
 
             JSONOutputStream& os = response->getResultStream();
 
-            os << startObject <<
+            os << lineBreak << startObject <<
                key("time") << (int32_t) timer.read_ms() <<
                key("connectable") << event.getType().connectable() <<
                key("scannable") << event.getType().scannable_advertising() <<
@@ -1357,31 +1865,237 @@ DECLARE_CMD(ScanForData) {
     private:
         container::Vector<uint8_t> _data;
         mbed::Timer timer;
+        EventSubscription _events;
     };
 };
 
-DECLARE_CMD(StopScan) {
-    CMD_NAME("stopScan")
-    CMD_HANDLER(CommandResponsePtr& response) {
-        ble_error_t err = gap().stopScan();
-        reportErrorOrSuccess(response, err);
+DECLARE_CMD(AnalyzeAdvertisingInterval) {
+    CMD_NAME("analyzeAdvertisingInterval")
+    CMD_HELP(
+        "Scan for the advertising packets of a list of peers and analyze the time "
+        "between two consecutive packets of the same peer and advertising set. "
+        "Scan responses are ignored. Packets received less than 20ms after the "
+        "previous packet of a stream are copies of the same advertising event "
+        "on another channel and are counted as duplicates. Packets are "
+        "timestamped when their report is processed by the application; the "
+        "Gap API does not expose the radio timestamp."
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 0xFF;
     }
-};
 
-DECLARE_CMD(CreateSync) {
-    CMD_NAME("createSync")
-    CMD_ARGS(
-        CMD_ARG("ble::peer_address_type_t::type", "peerAddressType", ""),
-        CMD_ARG("ble::address_t", "peerAddress", ""),
-        CMD_ARG("uint8_t", "sid", ""),
-        CMD_ARG("uint16_t", "maxPacketSkip", ""),
-        CMD_ARG("ble::sync_timeout_t", "timeout", ""),
-    )
-    CMD_HANDLER(
-        ble::peer_address_type_t::type peerAddressType,
-        ble::address_t &peerAddress,
-        uint8_t sid,
-        uint16_t maxPacketSkip,
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        if (args.count() < 2) {
+            response->invalidParameters("<timeout> <peer_address> [<peer_address>...] expected");
+            return;
+        }
+
+        uint32_t timeout;
+        if (!fromString(args[0], timeout)) {
+            response->invalidParameters("invalid timeout");
+            return;
+        }
+
+        uint8_t peerCount = args.count() - 1;
+        ble::address_t* peers = new ble::address_t[peerCount];
+        for (uint8_t i = 0; i < peerCount; ++i) {
+            if (!macAddressFromString(args[i + 1], peers[i])) {
+                response->invalidParameters("invalid address");
+                delete[] peers;
+                return;
+            }
+        }
+
+        startProcedure<AnalyzeAdvertisingIntervalProcedure>(peers, peerCount, timeout, response);
+    }
+
+    struct AnalyzeAdvertisingIntervalProcedure : public AsyncProcedure, Gap::EventHandler {
+        static const size_t MAX_STREAMS = 4;
+        // shortest advertising interval allowed by the specification
+        static const uint32_t MIN_INTERVAL_US = 20000;
+        // sid of the streams of legacy advertising packets
+        enum { NO_SID = 0xFF };
+
+        // Packets received from a peer for a given advertising set
+        struct Stream {
+            ble::address_t peer_address;
+            uint8_t sid;
+            uint32_t reports;
+            uint32_t duplicates;
+            // timestamp of the first packet of the last advertising event
+            uint32_t last_timestamp;
+            // inter-arrival times in µs
+            Histogram intervals;
+        };
+
+        AnalyzeAdvertisingIntervalProcedure(
+            ble::address_t* peers,
+            uint8_t peerCount,
+            uint32_t timeout,
+            CommandResponsePtr& response
+        ) : AsyncProcedure(response, timeout),
+            _peers(peers), _peerCount(peerCount), _streamCount(0), _droppedStreams(0),
+            _events(this, GapEventDispatcher::ADVERTISING_REPORT)
+        {
+        }
+
+        virtual ~AnalyzeAdvertisingIntervalProcedure()
+        {
+            delete[] _peers;
+        }
+
+        // AsyncProcedure implementation
+
+        virtual bool doStart()
+        {
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
+
+            ble_error_t err = gap().startScan();
+            if (err != BLE_ERROR_NONE) {
+                response->faillure(err);
+                return false;
+            }
+            return true;
+        }
+
+        virtual void doWhenTimeout()
+        {
+            gap().stopScan();
+            reportResults();
+        }
+
+        // Gap::EventHandler implementation
+
+        virtual void onAdvertisingReport(const ble::AdvertisingReportEvent &event)
+        {
+            // timestamp as soon as possible to reduce the jitter
+            const uint32_t timestamp = us_ticker_read();
+
+            if (event.getType().scan_response() || !isPeer(event.getPeerAddress())) {
+                return;
+            }
+
+            const uint8_t sid = event.getType().legacy_advertising() ?
+                NO_SID : event.getSID();
+
+            Stream* stream = findStream(event.getPeerAddress(), sid);
+            if (!stream) {
+                return;
+            }
+
+            const uint32_t interval = timestamp - stream->last_timestamp;
+            if (stream->reports && interval < MIN_INTERVAL_US) {
+                // same advertising event received on another channel
+                ++stream->duplicates;
+                return;
+            }
+
+            if (stream->reports) {
+                stream->intervals.add(interval);
+            }
+
+            stream->last_timestamp = timestamp;
+            ++stream->reports;
+        }
+
+    private:
+        bool isPeer(const ble::address_t& address) const
+        {
+            for (uint8_t i = 0; i < _peerCount; ++i) {
+                if (_peers[i] == address) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        Stream* findStream(const ble::address_t& address, uint8_t sid)
+        {
+            for (size_t i = 0; i < _streamCount; ++i) {
+                if (_streams[i].sid == sid && _streams[i].peer_address == address) {
+                    return &_streams[i];
+                }
+            }
+
+            if (_streamCount == MAX_STREAMS) {
+                ++_droppedStreams;
+                return NULL;
+            }
+
+            Stream& stream = _streams[_streamCount++];
+            stream = Stream();
+            stream.peer_address = address;
+            stream.sid = sid;
+            return &stream;
+        }
+
+        void reportResults()
+        {
+            response->success();
+            JSONOutputStream& os = response->getResultStream();
+
+            os << startObject <<
+                // reports are timestamped in the event queue, not by the radio
+                key("timestamp_source") << "HOST" <<
+                key("dropped_streams") << _droppedStreams <<
+                key("streams") << startArray;
+
+            for (size_t i = 0; i < _streamCount; ++i) {
+                reportStream(os, _streams[i]);
+            }
+
+            os << endArray << endObject;
+        }
+
+        static void reportStream(JSONOutputStream& os, const Stream& stream)
+        {
+            os << startObject <<
+                key("peer_address") << stream.peer_address;
+            if (stream.sid != NO_SID) {
+                os << key("sid") << stream.sid;
+            }
+            os << key("reports") << stream.reports <<
+                key("duplicates") << stream.duplicates <<
+                key("intervals") << stream.intervals <<
+            endObject;
+        }
+
+        ble::address_t* _peers;
+        uint8_t _peerCount;
+        Stream _streams[MAX_STREAMS];
+        size_t _streamCount;
+        uint32_t _droppedStreams;
+        EventSubscription _events;
+    };
+};
+
+DECLARE_CMD(StopScan) {
+    CMD_NAME("stopScan")
+    CMD_HANDLER(CommandResponsePtr& response) {
+        ble_error_t err = gap().stopScan();
+        reportErrorOrSuccess(response, err);
+    }
+};
+
+DECLARE_CMD(CreateSync) {
+    CMD_NAME("createSync")
+    CMD_ARGS(
+        CMD_ARG("ble::peer_address_type_t::type", "peerAddressType", ""),
+        CMD_ARG("ble::address_t", "peerAddress", ""),
+        CMD_ARG("uint8_t", "sid", ""),
+        CMD_ARG("uint16_t", "maxPacketSkip", ""),
+        CMD_ARG("ble::sync_timeout_t", "timeout", ""),
+    )
+    CMD_HANDLER(
+        ble::peer_address_type_t::type peerAddressType,
+        ble::address_t &peerAddress,
+        uint8_t sid,
+        uint16_t maxPacketSkip,
         ble::sync_timeout_t timeout,
         CommandResponsePtr& response
     )
@@ -1436,6 +2150,353 @@ DECLARE_CMD(TerminateSync) {
     }
 };
 
+DECLARE_CMD(MonitorPeriodicSync) {
+    CMD_NAME("monitorPeriodicSync")
+    CMD_HELP(
+        "Monitor the periodic advertising reports of the syncs listed, or of all the "
+        "syncs if none is listed, for a duration in ms. Reports are counted instead "
+        "of being printed. Aggregates are reported at the end and, if the period is "
+        "not 0, as an event every period in ms. Missed periodic events are derived "
+        "from the advertising interval of syncs established during the monitoring, "
+        "otherwise from the shortest time observed between two periodic events."
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 0xFF;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        if (args.count() < 2) {
+            response->invalidParameters("<duration> <period> [<sync_handle>...] expected");
+            return;
+        }
+
+        uint32_t duration;
+        if (!fromString(args[0], duration) || duration == 0) {
+            response->invalidParameters("invalid duration");
+            return;
+        }
+
+        uint32_t period;
+        if (!fromString(args[1], period)) {
+            response->invalidParameters("invalid period");
+            return;
+        }
+
+        uint8_t handleCount = args.count() - 2;
+        if (handleCount > MonitorPeriodicSyncProcedure::MAX_SYNCS) {
+            response->invalidParameters("too many sync handles");
+            return;
+        }
+
+        ble::periodic_sync_handle_t handles[MonitorPeriodicSyncProcedure::MAX_SYNCS];
+        for (uint8_t i = 0; i < handleCount; ++i) {
+            if (!fromString(args[i + 2], handles[i])) {
+                response->invalidParameters("invalid sync handle");
+                return;
+            }
+        }
+
+        startProcedure<MonitorPeriodicSyncProcedure>(
+            handles, handleCount, period, response, duration
+        );
+    }
+
+    struct MonitorPeriodicSyncProcedure : public AsyncProcedure, Gap::EventHandler {
+        static const size_t MAX_SYNCS = 4;
+        static const size_t DATA_STATUS_COUNT = 3;
+        // value of the RSSI when it is not available
+        static const ble::rssi_t RSSI_NOT_AVAILABLE = 127;
+
+        struct Sync {
+            ble::periodic_sync_handle_t handle;
+            // periodic advertising interval in µs, 0 if unknown
+            uint32_t interval;
+            bool interval_estimated;
+            uint16_t established;
+            uint16_t losses;
+            uint32_t reports;
+            // periodic events received, an event may be reported in several chunks
+            uint32_t events;
+            uint32_t missed_events;
+            uint32_t max_missed_events;
+            // timestamp of the first report of the last periodic event
+            uint32_t last_event_timestamp;
+            bool has_last_event;
+            bool has_last_status;
+            uint8_t last_status;
+            uint32_t status_counts[DATA_STATUS_COUNT];
+            uint32_t transitions[DATA_STATUS_COUNT][DATA_STATUS_COUNT];
+            // in dBm
+            Int8Measure rssi;
+        };
+
+        MonitorPeriodicSyncProcedure(
+            const ble::periodic_sync_handle_t* handles,
+            uint8_t handleCount,
+            uint32_t period,
+            CommandResponsePtr& response,
+            uint32_t duration
+        ) : AsyncProcedure(response, duration),
+            _syncCount(0), _droppedSyncs(0), _filtered(handleCount != 0),
+            _period(period), _periodHandle(NULL), _start(0),
+            _reports(this, GapEventDispatcher::PERIODIC_ADVERTISING_REPORT),
+            _syncEvents(
+                this,
+                GapEventDispatcher::mask(GapEventDispatcher::PERIODIC_ADVERTISING_SYNC_ESTABLISHED) |
+                GapEventDispatcher::mask(GapEventDispatcher::PERIODIC_ADVERTISING_SYNC_LOSS),
+                GapEventDispatcher::OBSERVE
+            )
+        {
+            // with a filter, the table is allocated upfront to the syncs listed
+            for (uint8_t i = 0; i < handleCount; ++i) {
+                addSync(handles[i]);
+            }
+        }
+
+        virtual ~MonitorPeriodicSyncProcedure()
+        {
+            if (_periodHandle) {
+                getCLICommandEventQueue()->cancel(_periodHandle);
+            }
+        }
+
+        // AsyncProcedure implementation
+
+        virtual bool doStart()
+        {
+            if (!_reports.is_valid() || !_syncEvents.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
+
+            _start = us_ticker_read();
+            if (_period) {
+                _periodHandle = getCLICommandEventQueue()->post_every(
+                    &MonitorPeriodicSyncProcedure::whenPeriodElapsed,
+                    this,
+                    _period
+                );
+            }
+            return true;
+        }
+
+        virtual void doWhenTimeout()
+        {
+            response->success();
+            reportSyncs(response->getResultStream());
+        }
+
+        // Gap::EventHandler implementation
+
+        virtual void onPeriodicAdvertisingSyncEstablished(
+            const ble::PeriodicAdvertisingSyncEstablishedEvent &event
+        ) {
+            if (event.getStatus() != BLE_ERROR_NONE) {
+                return;
+            }
+
+            Sync* sync = findSync(event.getSyncHandle());
+            if (!sync) {
+                return;
+            }
+
+            sync->interval = event.getAdvertisingInterval().value() * ble::periodic_interval_t::TIME_BASE;
+            sync->interval_estimated = false;
+            sync->has_last_event = false;
+            sync->has_last_status = false;
+            ++sync->established;
+        }
+
+        virtual void onPeriodicAdvertisingReport(
+            const ble::PeriodicAdvertisingReportEvent &event
+        ) {
+            // timestamp as soon as possible to reduce the jitter
+            const uint32_t timestamp = us_ticker_read();
+
+            Sync* sync = findSync(event.getSyncHandle());
+            if (!sync) {
+                return;
+            }
+
+            ++sync->reports;
+
+            const uint8_t status = event.getDataStatus().value();
+            if (status < DATA_STATUS_COUNT) {
+                ++sync->status_counts[status];
+                if (sync->has_last_status) {
+                    ++sync->transitions[sync->last_status][status];
+                }
+            }
+
+            // A report starts a new periodic event unless the previous one
+            // announced more data.
+            if (!sync->has_last_status ||
+                sync->last_status != ble::advertising_data_status_t::INCOMPLETE_MORE_DATA) {
+                recordEvent(*sync, timestamp);
+            }
+
+            sync->last_status = status;
+            sync->has_last_status = true;
+
+            const ble::rssi_t rssi = event.getRssi();
+            if (rssi != RSSI_NOT_AVAILABLE) {
+                sync->rssi.add(rssi);
+            }
+        }
+
+        virtual void onPeriodicAdvertisingSyncLoss(
+            const ble::PeriodicAdvertisingSyncLoss &event
+        ) {
+            Sync* sync = findSync(event.getSyncHandle());
+            if (!sync) {
+                return;
+            }
+
+            ++sync->losses;
+            sync->has_last_event = false;
+            sync->has_last_status = false;
+        }
+
+    private:
+        void recordEvent(Sync& sync, uint32_t timestamp)
+        {
+            ++sync.events;
+
+            if (sync.has_last_event) {
+                const uint32_t delta = timestamp - sync.last_event_timestamp;
+
+                if (sync.interval == 0 || (sync.interval_estimated && delta < sync.interval)) {
+                    sync.interval = delta;
+                    sync.interval_estimated = true;
+                }
+
+                // rounded to the nearest number of intervals to absorb the jitter
+                const uint32_t elapsed_events = (delta + (sync.interval / 2)) / sync.interval;
+                if (elapsed_events > 1) {
+                    const uint32_t missed = elapsed_events - 1;
+                    sync.missed_events += missed;
+                    sync.max_missed_events = std::max(sync.max_missed_events, missed);
+                }
+            }
+
+            sync.last_event_timestamp = timestamp;
+            sync.has_last_event = true;
+        }
+
+        Sync* findSync(ble::periodic_sync_handle_t handle)
+        {
+            for (size_t i = 0; i < _syncCount; ++i) {
+                if (_syncs[i].handle == handle) {
+                    return &_syncs[i];
+                }
+            }
+
+            if (_filtered) {
+                return NULL;
+            }
+
+            Sync* sync = addSync(handle);
+            if (!sync) {
+                ++_droppedSyncs;
+            }
+            return sync;
+        }
+
+        Sync* addSync(ble::periodic_sync_handle_t handle)
+        {
+            if (_syncCount == MAX_SYNCS) {
+                return NULL;
+            }
+
+            Sync& sync = _syncs[_syncCount++];
+            sync = Sync();
+            sync.handle = handle;
+            return &sync;
+        }
+
+        void whenPeriodElapsed()
+        {
+            JSONEventStream os;
+            os << startObject <<
+                key("type") << "event" <<
+                key("name") << "periodic_sync_monitor" <<
+                key("value");
+            reportSyncs(os);
+            os << endObject;
+        }
+
+        void reportSyncs(JSONOutputStream& os)
+        {
+            os << startObject <<
+                key("elapsed") << (uint32_t) ((us_ticker_read() - _start) / 1000) <<
+                key("dropped_syncs") << _droppedSyncs <<
+                key("syncs") << startArray;
+
+            for (size_t i = 0; i < _syncCount; ++i) {
+                reportSync(os, _syncs[i]);
+            }
+
+            os << endArray << endObject;
+        }
+
+        static void reportSync(JSONOutputStream& os, const Sync& sync)
+        {
+            os << startObject <<
+                key("sync_handle") << sync.handle <<
+                key("established") << sync.established <<
+                key("losses") << sync.losses <<
+                key("reports") << sync.reports <<
+                key("events") << sync.events <<
+                key("missed_events") << sync.missed_events <<
+                key("max_missed_events") << sync.max_missed_events;
+
+            if (sync.interval) {
+                os << key("interval") << sync.interval <<
+                    key("interval_estimated") << sync.interval_estimated;
+            }
+
+            os << key("data_status") << startObject <<
+                key("complete") << sync.status_counts[ble::advertising_data_status_t::COMPLETE] <<
+                key("incomplete_more_data") << sync.status_counts[ble::advertising_data_status_t::INCOMPLETE_MORE_DATA] <<
+                key("incomplete_data_truncated") << sync.status_counts[ble::advertising_data_status_t::INCOMPLETE_DATA_TRUNCATED] <<
+            endObject;
+
+            os << key("transitions") << startArray;
+            for (uint8_t from = 0; from < DATA_STATUS_COUNT; ++from) {
+                for (uint8_t to = 0; to < DATA_STATUS_COUNT; ++to) {
+                    if (from == to || sync.transitions[from][to] == 0) {
+                        continue;
+                    }
+                    os << startObject <<
+                        key("from") << toString((ble::advertising_data_status_t::type) from) <<
+                        key("to") << toString((ble::advertising_data_status_t::type) to) <<
+                        key("count") << sync.transitions[from][to] <<
+                    endObject;
+                }
+            }
+            os << endArray;
+
+            if (sync.rssi.count) {
+                os << key("rssi") << sync.rssi;
+            }
+
+            os << endObject;
+        }
+
+        Sync _syncs[MAX_SYNCS];
+        size_t _syncCount;
+        uint32_t _droppedSyncs;
+        bool _filtered;
+        uint32_t _period;
+        eq::EventQueue::event_handle_t _periodHandle;
+        uint32_t _start;
+        EventSubscription _reports;
+        EventSubscription _syncEvents;
+    };
+};
+
 DECLARE_CMD(AddDeviceToPeriodicAdvertiserList) {
     CMD_NAME("addDeviceToPeriodicAdvertiserList")
     CMD_ARGS(
@@ -1533,9 +2594,14 @@ DECLARE_CMD(Connect) {
             ble::address_t peerAddress,
             CommandResponsePtr& response,
             uint32_t procedureTimeout
-        ) : AsyncProcedure(response, procedureTimeout)
+        ) : AsyncProcedure(response, procedureTimeout),
+            _events(this, GapEventDispatcher::CONNECTION_COMPLETE)
         {
-            gap().setEventHandler(this);
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return;
+            }
+
             ble_error_t err = gap().connect(peerAddressType, peerAddress, getConnectionParameters());
             if (err != BLE_ERROR_NONE) {
                 response->faillure(err);
@@ -1543,14 +2609,9 @@ DECLARE_CMD(Connect) {
             }
         }
 
-        virtual ~ConnectProcedure() {
-            // revert to default event handler
-            enable_event_handling();
-        }
-
         // AsyncProcedure implementation
         virtual bool doStart() {
-            return true;
+            return _events.is_valid();
         }
 
         // Gap::EventHandler implementation
@@ -1567,6 +2628,8 @@ DECLARE_CMD(Connect) {
             printConnectionResult(os, event);
             terminate();
         }
+
+        EventSubscription _events;
     };
 };
 
@@ -1588,18 +2651,17 @@ DECLARE_CMD(WaitForConnection) {
         waitForConnectionProcedure(
             CommandResponsePtr& response,
             uint32_t procedureTimeout
-        ) : AsyncProcedure(response, procedureTimeout)
+        ) : AsyncProcedure(response, procedureTimeout),
+            _events(this, GapEventDispatcher::CONNECTION_COMPLETE)
         {
-            gap().setEventHandler(this);
-        }
-
-        virtual ~waitForConnectionProcedure() {
-            // revert to default event handler
-            enable_event_handling();
         }
 
         // AsyncProcedure implementation
         virtual bool doStart() {
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
             return true;
         }
 
@@ -1617,6 +2679,8 @@ DECLARE_CMD(WaitForConnection) {
             printConnectionResult(os, event);
             terminate();
         }
+
+        EventSubscription _events;
     };
 };
 
@@ -1640,18 +2704,17 @@ DECLARE_CMD(WaitForDisconnection) {
         waitForDisconnectionProcedure(
             CommandResponsePtr& response,
             uint32_t procedureTimeout
-        ) : AsyncProcedure(response, procedureTimeout)
+        ) : AsyncProcedure(response, procedureTimeout),
+            _events(this, GapEventDispatcher::DISCONNECTION_COMPLETE)
         {
-            gap().setEventHandler(this);
-        }
-
-        virtual ~waitForDisconnectionProcedure() {
-            // revert to default event handler
-            enable_event_handling();
         }
 
         // AsyncProcedure implementation
         virtual bool doStart() {
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
             return true;
         }
 
@@ -1663,6 +2726,452 @@ DECLARE_CMD(WaitForDisconnection) {
             printDisconnectionResult(os, event);
             terminate();
         }
+
+        EventSubscription _events;
+    };
+};
+
+DECLARE_CMD(ConnectToMany) {
+    CMD_NAME("connectToMany")
+    CMD_HELP(
+        "Connect to a list of peers and report the setup latency of each "
+        "connection, from the call to connect to the connection complete event. "
+        "In sequential mode, a peer is connected after the connection to the "
+        "previous one completes. In pipelined mode, the whitelist is set with the "
+        "peers not yet connected and the initiator connects to the first one found, "
+        "the connection is restarted as soon as the previous one completes; the "
+        "whitelist is restored at the end of the procedure. A failure is accounted "
+        "to the peer reported by the connection complete event; the pending peers "
+        "fail together only if none of them is found within the attempt timeout or "
+        "if consecutive attempts keep failing without a peer."
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 0xFF;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        if (args.count() < 4 || (args.count() % 2)) {
+            response->invalidParameters(
+                "<sequential|pipelined> <attempt_timeout> [ <addressType> <address> ] expected"
+            );
+            return;
+        }
+
+        bool pipelined;
+        if (strcmp(args[0], "sequential") == 0) {
+            pipelined = false;
+        } else if (strcmp(args[0], "pipelined") == 0) {
+            pipelined = true;
+        } else {
+            response->invalidParameters("invalid mode");
+            return;
+        }
+
+        uint32_t attemptTimeout;
+        if (!fromString(args[1], attemptTimeout) || attemptTimeout == 0) {
+            response->invalidParameters("invalid attempt timeout");
+            return;
+        }
+
+        uint8_t peerCount = (args.count() - 2) / 2;
+        ble::whitelist_t::entry_t* peers = new ble::whitelist_t::entry_t[peerCount]();
+
+        for (uint8_t i = 0; i < peerCount; ++i) {
+            if (!fromString(args[2 + (i * 2)], peers[i].type)) {
+                response->invalidParameters("invalid address type");
+                delete[] peers;
+                return;
+            }
+
+            if (!macAddressFromString(args[2 + (i * 2) + 1], peers[i].address)) {
+                response->invalidParameters("invalid address");
+                delete[] peers;
+                return;
+            }
+        }
+
+        // the procedure timeout is a safety net, attempts are timed out individually
+        startProcedure<ConnectToManyProcedure>(
+            peers, peerCount, pipelined, attemptTimeout,
+            response, (attemptTimeout * peerCount) + 5000 /* ms */
+        );
+    }
+
+    struct ConnectToManyProcedure : public AsyncProcedure, Gap::EventHandler {
+        // consecutive pipelined attempts failing without a peer before the
+        // pending peers are marked as failed
+        static const uint8_t MAX_ANONYMOUS_FAILURES = 3;
+
+        struct Result {
+            ble_error_t status;
+            bool completed;
+            ble::connection_handle_t handle;
+            uint32_t latency;
+        };
+
+        ConnectToManyProcedure(
+            ble::whitelist_t::entry_t* peers,
+            uint8_t peerCount,
+            bool pipelined,
+            uint32_t attemptTimeout,
+            CommandResponsePtr& response,
+            uint32_t procedureTimeout
+        ) : AsyncProcedure(response, procedureTimeout),
+            _peers(peers), _peerCount(peerCount), _pipelined(pipelined),
+            _attemptTimeout(attemptTimeout), _results(new Result[peerCount]()),
+            _current(0), _attemptStart(0), _attemptHandle(NULL),
+            _connecting(false), _cancelled(false), _anonymousFailures(0),
+            _events(this, GapEventDispatcher::CONNECTION_COMPLETE)
+        {
+            _savedWhitelist.addresses = NULL;
+            _savedWhitelist.size = 0;
+            _savedWhitelist.capacity = 0;
+
+            for (uint8_t i = 0; i < _peerCount; ++i) {
+                _results[i].status = BLE_ERROR_NONE;
+                _results[i].completed = false;
+            }
+        }
+
+        virtual ~ConnectToManyProcedure()
+        {
+            cancelAttemptTimeout();
+            restoreWhitelist();
+            delete[] _peers;
+            delete[] _results;
+        }
+
+        // AsyncProcedure implementation
+
+        virtual bool doStart()
+        {
+            if (!_events.is_valid()) {
+                response->faillure(NO_EVENT_SUBSCRIPTION);
+                return false;
+            }
+
+            if (_pipelined) {
+                ble_error_t err = saveWhitelist();
+                if (err) {
+                    response->faillure(err);
+                    return false;
+                }
+            }
+
+            _timer.start();
+            return connectNext();
+        }
+
+        virtual void doWhenTimeout()
+        {
+            if (_connecting) {
+                gap().cancelConnect();
+            }
+            reportResults();
+        }
+
+        // Gap::EventHandler implementation
+
+        virtual void onConnectionComplete(const ble::ConnectionCompleteEvent &event)
+        {
+            if (!_connecting) {
+                return;
+            }
+
+            // ignore connections initiated by peers
+            if (event.getStatus() == BLE_ERROR_NONE &&
+                event.getOwnRole() != ble::connection_role_t::CENTRAL) {
+                return;
+            }
+
+            closeAttempt(event.getStatus(), event.getConnectionHandle(), event.getPeerAddress());
+        }
+
+    private:
+        /*
+         * Record the outcome of the current attempt then start the next one.
+         */
+        void closeAttempt(
+            ble_error_t status,
+            ble::connection_handle_t handle,
+            const ble::address_t& peerAddress
+        ) {
+            cancelAttemptTimeout();
+            _connecting = false;
+            const uint32_t latency = now() - _attemptStart;
+
+            if (status != BLE_ERROR_NONE) {
+                if (_pipelined) {
+                    const uint8_t index = findPeer(peerAddress);
+                    if (index != _peerCount) {
+                        // the attempt failed with this peer only
+                        complete(index, status);
+                    } else if (_cancelled || ++_anonymousFailures >= MAX_ANONYMOUS_FAILURES) {
+                        // none of the pending peers could be reached
+                        for (uint8_t i = 0; i < _peerCount; ++i) {
+                            if (!_results[i].completed) {
+                                complete(i, _cancelled ? BLE_ERROR_TIMEOUT : status);
+                            }
+                        }
+                    }
+                    // otherwise the attempt is restarted with the same peers
+                } else {
+                    complete(_current, _cancelled ? BLE_ERROR_TIMEOUT : status);
+                    ++_current;
+                }
+            } else {
+                uint8_t index = _current;
+                if (_pipelined) {
+                    index = findPeer(peerAddress);
+                    if (index == _peerCount) {
+                        // connected to a device which is not in the list
+                        gap().disconnect(
+                            handle,
+                            ble::local_disconnection_reason_t::USER_TERMINATION
+                        );
+                        restart();
+                        return;
+                    }
+                } else {
+                    ++_current;
+                }
+
+                _anonymousFailures = 0;
+                complete(index, BLE_ERROR_NONE);
+                _results[index].handle = handle;
+                _results[index].latency = latency;
+            }
+
+            restart();
+        }
+
+        uint32_t now() const
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(_timer.elapsed_time()).count();
+        }
+
+        void restart()
+        {
+            if (!connectNext()) {
+                // an error status has been reported by connectNext
+                terminate();
+            }
+        }
+
+        /*
+         * Start the next connection attempt or report the results once every
+         * peer has been processed. Return false if the procedure must be
+         * terminated.
+         */
+        bool connectNext()
+        {
+            while (true) {
+                if (pendingCount() == 0) {
+                    reportResults();
+                    return false;
+                }
+
+                ble_error_t err = _pipelined ? connectPending() : connectPeer(_current);
+                if (err == BLE_ERROR_NONE) {
+                    break;
+                }
+
+                // the attempt cannot be started, account it as a failure
+                if (_pipelined) {
+                    for (uint8_t i = 0; i < _peerCount; ++i) {
+                        if (!_results[i].completed) {
+                            complete(i, err);
+                        }
+                    }
+                } else {
+                    complete(_current, err);
+                    ++_current;
+                }
+            }
+
+            _connecting = true;
+            _cancelled = false;
+            _attemptStart = now();
+            _attemptHandle = getCLICommandEventQueue()->post_in(
+                &ConnectToManyProcedure::whenAttemptTimeout,
+                this,
+                _attemptTimeout
+            );
+            return true;
+        }
+
+        ble_error_t connectPeer(uint8_t index)
+        {
+            return gap().connect(
+                _peers[index].type,
+                _peers[index].address,
+                getConnectionParameters()
+            );
+        }
+
+        ble_error_t connectPending()
+        {
+            ble::whitelist_t::entry_t* pending = new ble::whitelist_t::entry_t[_peerCount]();
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < _peerCount; ++i) {
+                if (!_results[i].completed) {
+                    pending[count++] = _peers[i];
+                }
+            }
+
+            ble::whitelist_t whitelist = {
+                pending,
+                /* size */ count,
+                /* capacity */ count
+            };
+            ble_error_t err = gap().setWhitelist(whitelist);
+            delete[] pending;
+            if (err) {
+                return err;
+            }
+
+            ble::ConnectionParameters parameters = getConnectionParameters();
+            parameters.setFilter(ble::initiator_filter_policy_t::USE_WHITE_LIST);
+
+            // the peer address is ignored when the whitelist is used
+            return gap().connect(
+                _peers[0].type,
+                _peers[0].address,
+                parameters
+            );
+        }
+
+        /*
+         * The whitelist is used by the pipelined mode; it is saved before the
+         * first attempt and restored when the procedure ends.
+         */
+        ble_error_t saveWhitelist()
+        {
+            const uint8_t capacity = gap().getMaxWhitelistSize();
+            _savedWhitelist.addresses = new ble::whitelist_t::entry_t[capacity]();
+            _savedWhitelist.size = 0;
+            _savedWhitelist.capacity = capacity;
+
+            ble_error_t err = gap().getWhitelist(_savedWhitelist);
+            if (err) {
+                delete[] _savedWhitelist.addresses;
+                _savedWhitelist.addresses = NULL;
+            }
+            return err;
+        }
+
+        void restoreWhitelist()
+        {
+            if (!_savedWhitelist.addresses) {
+                return;
+            }
+
+            gap().setWhitelist(_savedWhitelist);
+            delete[] _savedWhitelist.addresses;
+            _savedWhitelist.addresses = NULL;
+        }
+
+        void whenAttemptTimeout()
+        {
+            _attemptHandle = NULL;
+            if (gap().cancelConnect() == BLE_ERROR_NONE) {
+                // the attempt is closed by the connection complete event
+                _cancelled = true;
+                return;
+            }
+
+            _cancelled = true;
+            closeAttempt(BLE_ERROR_TIMEOUT, 0, ble::address_t());
+        }
+
+        void cancelAttemptTimeout()
+        {
+            if (_attemptHandle) {
+                getCLICommandEventQueue()->cancel(_attemptHandle);
+                _attemptHandle = NULL;
+            }
+        }
+
+        void complete(uint8_t index, ble_error_t status)
+        {
+            _results[index].status = status;
+            _results[index].completed = true;
+        }
+
+        uint8_t pendingCount() const
+        {
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < _peerCount; ++i) {
+                if (!_results[i].completed) {
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+        uint8_t findPeer(const ble::address_t& address) const
+        {
+            for (uint8_t i = 0; i < _peerCount; ++i) {
+                if (!_results[i].completed && _peers[i].address == address) {
+                    return i;
+                }
+            }
+            return _peerCount;
+        }
+
+        void reportResults()
+        {
+            // connection latencies in ms
+            Histogram latency;
+            for (uint8_t i = 0; i < _peerCount; ++i) {
+                if (_results[i].completed && _results[i].status == BLE_ERROR_NONE) {
+                    latency.add(_results[i].latency);
+                }
+            }
+            const uint8_t connected = latency.measure.count;
+
+            response->success();
+            JSONOutputStream& os = response->getResultStream();
+
+            os << startObject <<
+                key("mode") << (_pipelined ? "pipelined" : "sequential") <<
+                key("connected") << connected <<
+                key("failed") << (uint8_t) (_peerCount - connected) <<
+                key("duration") << now() <<
+                key("latency") << latency;
+
+            os << key("results") << startArray;
+            for (uint8_t i = 0; i < _peerCount; ++i) {
+                const Result& result = _results[i];
+                os << startObject <<
+                    key("peer_address_type") << _peers[i].type <<
+                    key("peer_address") << _peers[i].address <<
+                    key("status") << (result.completed ? result.status : BLE_ERROR_TIMEOUT);
+                if (result.completed && result.status == BLE_ERROR_NONE) {
+                    os << key("connection_handle") << result.handle <<
+                        key("latency") << result.latency;
+                }
+                os << endObject;
+            }
+            os << endArray << endObject;
+        }
+
+        ble::whitelist_t::entry_t* _peers;
+        uint8_t _peerCount;
+        bool _pipelined;
+        uint32_t _attemptTimeout;
+        Result* _results;
+        uint8_t _current;
+        uint32_t _attemptStart;
+        eq::EventQueue::event_handle_t _attemptHandle;
+        bool _connecting;
+        bool _cancelled;
+        uint8_t _anonymousFailures;
+        ble::whitelist_t _savedWhitelist;
+        mbed::Timer _timer;
+        EventSubscription _events;
     };
 };
 
@@ -1769,6 +3278,59 @@ DECLARE_CMD(Disconnect) {
     }
 };
 
+DECLARE_CMD(GetConnectionStatistics) {
+    CMD_NAME("getConnectionStatistics")
+    CMD_HELP(
+        "Report the statistics of the live connections and of the last "
+        "connections closed, in a single response."
+    )
+    CMD_HANDLER(CommandResponsePtr& response) {
+        const uint32_t now = connection_statistics.now();
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+
+        os << startObject <<
+            key("time") << now <<
+            key("dropped") << connection_statistics.getDroppedCount() <<
+            key("connections") << startArray;
+
+        for (size_t i = 0; i < connection_statistics.capacity(); ++i) {
+            const ConnectionStatistics::Record& record = connection_statistics[i];
+            if (!record.used) {
+                continue;
+            }
+
+            os << startObject <<
+                key("connection_handle") << record.handle <<
+                key("connected") << record.connected <<
+                key("own_role") << (record.role == ble::connection_role_t::CENTRAL ? "CENTRAL" : "PERIPHERAL") <<
+                key("peer_address_type") << record.peer_address_type <<
+                key("peer_address") << record.peer_address <<
+                key("connected_at") << record.connected_at <<
+                key("duration") << ((record.connected ? now : record.disconnected_at) - record.connected_at) <<
+                key("interval") << record.interval <<
+                key("latency") << record.latency <<
+                key("supervision_timeout") << record.supervision_timeout <<
+                key("tx_phy") << record.tx_phy <<
+                key("rx_phy") << record.rx_phy <<
+                key("att_mtu") << record.att_mtu <<
+                key("connection_parameters_updates") << record.connection_parameters_updates <<
+                key("phy_updates") << record.phy_updates <<
+                key("att_bytes_in") << record.att_bytes_in <<
+                key("att_bytes_out") << record.att_bytes_out;
+
+            if (!record.connected) {
+                os << key("disconnection_reason") << record.disconnection_reason;
+            }
+
+            os << endObject;
+        }
+
+        os << endArray << endObject;
+    }
+};
+
 DECLARE_CMD(IsFeatureSupported) {
     CMD_NAME("isFeatureSupported")
     CMD_ARGS(
@@ -1790,6 +3352,7 @@ DECLARE_CMD(IsRadioActive) {
 
 static const Command* const _cmd_handlers[] = {
     CMD_INSTANCE(GetAddressCommand),
+    CMD_INSTANCE(SetRandomStaticAddressCommand),
     CMD_INSTANCE(GetMaxWhitelistSizeCommand),
     CMD_INSTANCE(GetWhitelistCommand),
     CMD_INSTANCE(SetWhitelistCommand),
@@ -1809,39 +3372,49 @@ static const Command* const _cmd_handlers[] = {
     CMD_INSTANCE(SetAdvertisingParameters),
     CMD_INSTANCE(SetAdvertisingPayload),
     CMD_INSTANCE(ApplyAdvPayloadFromBuilder),
+    CMD_INSTANCE(ApplyAdvPayloadToSets),
     CMD_INSTANCE(SetAdvertisingScanResponse),
     CMD_INSTANCE(ApplyScanRespFromBuilder),
     CMD_INSTANCE(StartAdvertising),
     CMD_INSTANCE(StopAdvertising),
+    CMD_INSTANCE(ProvisionAdvertisingSets),
     CMD_INSTANCE(IsAdvertisingActive),
+#if ENABLE_PERIODIC_ADVERTISING_COMMANDS
     CMD_INSTANCE(SetPeriodicAdvertisingParameters),
     CMD_INSTANCE(SetPeriodicAdvertisingPayload),
     CMD_INSTANCE(StartPeriodicAdvertising),
     CMD_INSTANCE(StopPeriodicAdvertising),
     CMD_INSTANCE(IsPeriodicAdvertisingActive),
+#endif
     CMD_INSTANCE(SetScanParameters),
     CMD_INSTANCE(StartScan),
     CMD_INSTANCE(ScanForAddress),
     CMD_INSTANCE(ScanForData),
+    CMD_INSTANCE(AnalyzeAdvertisingInterval),
     CMD_INSTANCE(StopScan),
+#if ENABLE_PERIODIC_ADVERTISING_COMMANDS
     CMD_INSTANCE(CreateSync),
     CMD_INSTANCE(CreateSyncFromList),
     CMD_INSTANCE(CancelCreateSync),
     CMD_INSTANCE(TerminateSync),
+    CMD_INSTANCE(MonitorPeriodicSync),
     CMD_INSTANCE(AddDeviceToPeriodicAdvertiserList),
     CMD_INSTANCE(RemoveDeviceFromPeriodicAdvertiserList),
     CMD_INSTANCE(ClearPeriodicAdvertiserList),
     CMD_INSTANCE(GetMaxPeriodicAdvertiserListSize),
+#endif
     CMD_INSTANCE(Connect),
     CMD_INSTANCE(StartConnecting),
     CMD_INSTANCE(WaitForConnection),
     CMD_INSTANCE(WaitForDisconnection),
+    CMD_INSTANCE(ConnectToMany),
     CMD_INSTANCE(CancelConnect),
     CMD_INSTANCE(UpdateConnectionParameters),
     CMD_INSTANCE(ManageConnectionParametersUpdateRequest),
     CMD_INSTANCE(AcceptConnectionParametersUpdate),
     CMD_INSTANCE(RejectConnectionParametersUpdate),
     CMD_INSTANCE(Disconnect),
+    CMD_INSTANCE(GetConnectionStatistics),
     CMD_INSTANCE(IsFeatureSupported),
     CMD_INSTANCE(IsRadioActive)
 };
@@ -1860,14 +3433,21 @@ void GapCommandSuiteDescription::init()
     enable_event_handling();
 }
 
+const ConnectionStatistics::Record* GapCommandSuiteDescription::get_connection(
+    ble::connection_handle_t handle
+) {
+    enable_event_handling();
+    return connection_statistics.get(handle);
+}
+
 void GapCommandSuiteDescription::add_disconnection_callback(
     FunctionPointerWithContext<const ble::DisconnectionCompleteEvent&> callback
 ) {
-    handler.disconnection_chain.add(callback);
+    disconnection_observer.disconnection_chain.add(callback);
 }
 
 void GapCommandSuiteDescription::detach_disconnection_callback(
     FunctionPointerWithContext<const ble::DisconnectionCompleteEvent&> callback
 ) {
-    handler.disconnection_chain.detach(callback);
+    disconnection_observer.disconnection_chain.detach(callback);
 }
@@ -17,6 +17,11 @@
 #include "CLICommand/CommandSuite.h"
 #include "ble/common/FunctionPointerWithContext.h"
 #include "ble/gap/Events.h"
+#include "util/ConnectionStatistics.h"
+
+#ifndef ENABLE_PERIODIC_ADVERTISING_COMMANDS
+#define ENABLE_PERIODIC_ADVERTISING_COMMANDS 1
+#endif
 
 class GapCommandSuiteDescription {
 
@@ -37,6 +42,15 @@ public:
 
     static void init();
 
+    /**
+     * @brief Get the statistics of a live connection, they contain the peer
+     * address and the parameters of the connection.
+     * @return The record of the connection or NULL if it is not known.
+     */
+    static const ConnectionStatistics::Record* get_connection(
+        ble::connection_handle_t handle
+    );
+
     static void add_disconnection_callback(
         FunctionPointerWithContext<const ble::DisconnectionCompleteEvent&> callback
     );
@@ -12,6 +12,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "ble/BLE.h"
 #include "ble/gatt/DiscoveredService.h"
 #include "ble/gatt/DiscoveredCharacteristic.h"
@@ -23,7 +25,9 @@
 #include "Serialization/Hex.h"
 #include "Serialization/DiscoveredCharacteristic.h"
 #include "Serialization/GattCallbackParamTypes.h"
+#include "Serialization/Measure.h"
 #include "CLICommand/util/AsyncProcedure.h"
+#include "CLICommand/CommandEventQueue.h"
 
 #include "CLICommand/CommandSuite.h"
 
@@ -32,6 +36,8 @@
 
 #include "GattClientCommands.h"
 #include "Commands/GapCommands.h"
+#include "util/GattDiscoveryCache.h"
+#include "hal/us_ticker_api.h"
 
 using mbed::util::SharedPointer;
 using ble::Gap;
@@ -45,10 +51,186 @@ using ble::SecurityManager;
 // isolation
 namespace {
 
+static GattDiscoveryCache discovery_cache;
+
+/**
+ * @brief Parse the arguments of the discovery commands:
+ * <connectionHandle> [<useCache>] [<profile>].
+ * @param report Set to true if useCache is present, the result of the command
+ * is then an object reporting the cost of the discovery.
+ */
+static bool parseDiscoveryArgs(
+    const CommandArgs& args,
+    CommandResponsePtr& response,
+    uint16_t& connectionHandle,
+    bool& report,
+    bool& useCache,
+    bool& profile
+) {
+    if (!fromString(args[0], connectionHandle)) {
+        response->invalidParameters("connectionHandle should be a uint16_t");
+        return false;
+    }
+
+    report = args.count() > 1;
+    useCache = false;
+    if (report && !fromString(args[1], useCache)) {
+        response->invalidParameters("useCache should be a bool");
+        return false;
+    }
+
+    profile = false;
+    if (args.count() > 2 && !fromString(args[2], profile)) {
+        response->invalidParameters("profile should be a bool");
+        return false;
+    }
+
+    return true;
+}
+
+static uint16_t getAttMtu(ble::connection_handle_t connectionHandle) {
+    const ConnectionStatistics::Record* record = GapCommandSuiteDescription::get_connection(connectionHandle);
+    // default ATT_MTU if the connection is not recorded
+    return record ? record->att_mtu : 23;
+}
+
+/**
+ * @brief Clock of a discovery procedure.
+ * @details The result of a discovery is written to the serial port from the
+ * callbacks of the procedure and the write blocks until it is sent; the next
+ * ATT request is only issued once the callback returns. The time spent in the
+ * callbacks is excluded from the clock so the durations reported are the ones
+ * of the ATT procedures.
+ */
+class DiscoveryClock {
+public:
+    DiscoveryClock() : startedAt(0), excluded(0) { }
+
+    void start() {
+        startedAt = us_ticker_read();
+        excluded = 0;
+    }
+
+    /**
+     * @brief Time in µs elapsed since start, the pauses excluded.
+     */
+    uint32_t elapsed() const {
+        return us_ticker_read() - startedAt - excluded;
+    }
+
+    /**
+     * @brief Exclude the rest of the scope from the clock.
+     */
+    class Pause {
+    public:
+        Pause(DiscoveryClock& clock) : clock(clock), pausedAt(us_ticker_read()) { }
+
+        ~Pause() {
+            clock.excluded += us_ticker_read() - pausedAt;
+        }
+
+    private:
+        Pause(const Pause&);
+        Pause& operator=(const Pause&);
+
+        DiscoveryClock& clock;
+        uint32_t pausedAt;
+    };
+
+private:
+    uint32_t startedAt;
+    uint32_t excluded;
+};
+
+/**
+ * @brief Serialize the connection parameters in effect during a discovery.
+ */
+static void serializeDiscoveryLink(
+    serialization::JSONOutputStream& os,
+    ble::connection_handle_t connectionHandle
+) {
+    using namespace serialization;
+
+    const ConnectionStatistics::Record* record = GapCommandSuiteDescription::get_connection(connectionHandle);
+
+    os << key("att_mtu") << getAttMtu(connectionHandle);
+
+    if (record) {
+        os << key("connection_interval") << record->interval <<
+            key("slave_latency") << record->latency;
+    }
+}
+
+/**
+ * @brief Serve a discovery from the cache.
+ * @return true if the peer of the connection is in the cache and the response
+ * has been sent.
+ */
+static bool serveDiscoveryFromCache(
+    ble::connection_handle_t connectionHandle,
+    bool characteristics,
+    CommandResponsePtr& response
+) {
+    using namespace serialization;
+
+    uint32_t start = us_ticker_read();
+    const GattDiscoveryCache::Entry* entry = discovery_cache.lookup(connectionHandle);
+    if (!entry) {
+        return false;
+    }
+
+    response->success();
+    JSONOutputStream& os = response->getResultStream();
+
+    os << startObject <<
+        key("cached") << true <<
+        key("services") << startArray;
+
+    for (size_t i = 0; i < entry->service_count; ++i) {
+        const GattDiscoveryCache::Service& service = entry->services[i];
+        os << startObject <<
+            key("UUID") << service.uuid <<
+            key("start_handle") << service.start_handle <<
+            key("end_handle") << service.end_handle;
+
+        if (characteristics) {
+            os << key("characteristics") << startArray;
+            for (size_t j = service.characteristics_begin; j < service.characteristics_end; ++j) {
+                const GattDiscoveryCache::Characteristic& characteristic = entry->characteristics[j];
+                os << startObject <<
+                    key("UUID") << characteristic.uuid <<
+                    key("properties") << characteristic.properties <<
+                    key("start_handle") << characteristic.decl_handle <<
+                    key("value_handle") << characteristic.value_handle <<
+                    key("end_handle") << characteristic.last_handle <<
+                endObject;
+            }
+            os << endArray;
+        }
+
+        os << endObject;
+    }
+
+    os << endArray <<
+        key("duration") << (uint32_t) (us_ticker_read() - start) <<
+        key("att_requests") << (uint16_t) 0 <<
+        key("discovery_duration") << entry->discovery_duration <<
+        key("discovery_att_requests") << entry->att_requests <<
+    endObject;
+
+    return true;
+}
+
 DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
     CMD_NAME("discoverAllServicesAndCharacteristics")
 
-    CMD_HELP("Discover all services and characteristics available on a peer device")
+    CMD_HELP("Discover all services and characteristics available on a peer device. "
+        "If useCache is present, the result is an object which reports the cost of "
+        "the discovery and the attribute database of the peer is recorded in the "
+        "discovery cache. If useCache is true and the peer is in the cache, the "
+        "services and characteristics are served from the cache. If profile is true, "
+        "the discovery reports the time and ATT requests of each phase, service and "
+        "characteristic.")
 
     CMD_ARGS(
         CMD_ARG("uint16_t", "connectionHandle", "The connection used by this procedure")
@@ -68,15 +250,39 @@ DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
         CMD_RESULT("uint16_t", "[i].characteristics[j].end_handle", "Last handle of the characteristic.")
     )
 
-    CMD_HANDLER(uint16_t connectionHandle, CommandResponsePtr& response) {
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 3;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint16_t connectionHandle;
+        bool report;
+        bool useCache;
+        bool profile;
+        if (!parseDiscoveryArgs(args, response, connectionHandle, report, useCache, profile)) {
+            return;
+        }
+
+        if (useCache && serveDiscoveryFromCache(connectionHandle, /* characteristics */ true, response)) {
+            return;
+        }
+
         startProcedure<DiscoverAllServicesAndCharacteristicsProcedure>(
-            response, /* timeout */ 30 * 1000, connectionHandle
+            response, /* timeout */ 30 * 1000, connectionHandle, report, profile
         );
     }
 
     struct DiscoverAllServicesAndCharacteristicsProcedure : public AsyncProcedure {
-        DiscoverAllServicesAndCharacteristicsProcedure(CommandResponsePtr& res, uint32_t timeout, uint16_t handle) :
-            AsyncProcedure(res, timeout), connectionHandle(handle), isFirstServiceDiscovered(true) {
+        DiscoverAllServicesAndCharacteristicsProcedure(
+            CommandResponsePtr& res,
+            uint32_t timeout,
+            uint16_t handle,
+            bool report,
+            bool profile
+        ) : AsyncProcedure(res, timeout), connectionHandle(handle), isFirstServiceDiscovered(true),
+            report(report), profile(profile), cacheEntry(NULL), estimator(getAttMtu(handle)),
+            servicesPhase(0), serviceStartedAt(0), serviceCharacteristicRequests(0) {
         }
 
         virtual ~DiscoverAllServicesAndCharacteristicsProcedure() {
@@ -85,9 +291,15 @@ DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
             GapCommandSuiteDescription::detach_disconnection_callback(makeFunctionPointer(
                 this, &DiscoverAllServicesAndCharacteristicsProcedure::whenDisconnected
             ));
+            if (cacheEntry) {
+                discovery_cache.endRecording(cacheEntry, /* success */ false, 0, 0);
+            }
         }
 
         virtual bool doStart() {
+            using namespace serialization;
+
+            clock.start();
             ble_error_t err = client().launchServiceDiscovery(
                 connectionHandle,
                 makeFunctionPointer(this, &DiscoverAllServicesAndCharacteristicsProcedure::whenServiceDiscovered),
@@ -99,6 +311,8 @@ DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
                 return false;
             }
 
+            DiscoveryClock::Pause pause(clock);
+
             client().onServiceDiscoveryTermination(makeFunctionPointer(
                 this, &DiscoverAllServicesAndCharacteristicsProcedure::whenServiceDiscoveryTerminated
             ));
@@ -107,28 +321,80 @@ DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
                 this, &DiscoverAllServicesAndCharacteristicsProcedure::whenDisconnected
             ));
 
-            response->getResultStream() << serialization::startArray;
+            if (report) {
+                cacheEntry = discovery_cache.startRecording(connectionHandle);
+                response->getResultStream() << startObject <<
+                    key("cached") << false <<
+                    key("services");
+            }
+
+            response->getResultStream() << startArray;
             return true;
         }
 
         void whenServiceDiscovered(const DiscoveredService * discoveredService) {
             using namespace serialization;
 
+            const uint32_t now = clock.elapsed();
+            DiscoveryClock::Pause pause(clock);
+
+            if (report) {
+                // finish the estimation of the previous service first
+                estimator.addService(discoveredService->getUUID(), discoveredService->getEndHandle());
+                if (cacheEntry) {
+                    discovery_cache.recordService(cacheEntry, discoveredService);
+                }
+            }
+
             if(isFirstServiceDiscovered) {
                 isFirstServiceDiscovered = false;
+                // all the primary services are discovered before the first one
+                // is reported
+                servicesPhase = now;
             } else {
-                response->getResultStream() << endArray << endObject;
+                closeService(now);
             }
 
             response->getResultStream() <<  startObject <<
                 key("UUID") << discoveredService->getUUID() <<
                 key("start_handle") << discoveredService->getStartHandle() <<
-                key("end_handle") << discoveredService->getEndHandle() <<
-                key("characteristics") << startArray;
+                key("end_handle") << discoveredService->getEndHandle();
+
+            if (profile) {
+                response->getResultStream() << key("discovered_at") << now;
+                serviceStartedAt = now;
+                serviceCharacteristicRequests = estimator.characteristicRequests();
+            }
+
+            response->getResultStream() << key("characteristics") << startArray;
         }
 
         void whenCharacteristicDiscovered(const DiscoveredCharacteristic* discoveredCharacteristic) {
-            response->getResultStream() << *discoveredCharacteristic;
+            using namespace serialization;
+
+            const uint32_t now = clock.elapsed();
+            DiscoveryClock::Pause pause(clock);
+
+            if (report) {
+                estimator.addCharacteristic(discoveredCharacteristic->getUUID(), discoveredCharacteristic->getValueHandle());
+                if (cacheEntry) {
+                    discovery_cache.recordCharacteristic(cacheEntry, discoveredCharacteristic);
+                }
+            }
+
+            if (!profile) {
+                response->getResultStream() << *discoveredCharacteristic;
+                return;
+            }
+
+            response->getResultStream() << startObject <<
+                key("UUID") << discoveredCharacteristic->getUUID() <<
+                key("properties") << discoveredCharacteristic->getProperties() <<
+                key("start_handle") << discoveredCharacteristic->getDeclHandle() <<
+                key("value_handle") << discoveredCharacteristic->getValueHandle() <<
+                key("end_handle") << discoveredCharacteristic->getLastHandle() <<
+                key("discovered_at") << now <<
+            endObject;
         }
 
         void whenServiceDiscoveryTerminated(ble::connection_handle_t handle) {
@@ -138,16 +404,72 @@ DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
                 return;
             };
 
+            const uint32_t duration = clock.elapsed();
+            uint16_t attRequests = 0;
+
+            if (report) {
+                attRequests = estimator.finish(/* characteristics */ true);
+            }
+
             if(isFirstServiceDiscovered == false) {
-                response->getResultStream() << endArray << endObject;
+                closeService(duration);
+            } else {
+                servicesPhase = duration;
             }
 
             response->getResultStream() << endArray;
 
+            if (report) {
+                if (cacheEntry) {
+                    discovery_cache.endRecording(cacheEntry, /* success */ true, duration, attRequests);
+                    cacheEntry = NULL;
+                }
+
+                response->getResultStream() <<
+                    key("duration") << duration <<
+                    key("att_requests") << attRequests;
+
+                if (profile) {
+                    response->getResultStream() << key("profile") << startObject;
+                    serializeDiscoveryLink(response->getResultStream(), connectionHandle);
+                    response->getResultStream() <<
+                        key("services_phase") << startObject <<
+                            key("duration") << servicesPhase <<
+                            key("att_requests") << estimator.serviceRequests() <<
+                        endObject <<
+                        key("characteristics_phase") << startObject <<
+                            key("duration") << (uint32_t) (duration - servicesPhase) <<
+                            key("att_requests") << estimator.characteristicRequests() <<
+                        endObject <<
+                    endObject;
+                }
+
+                response->getResultStream() << endObject;
+            }
+
             response->success();
             terminate();
         }
 
+        /**
+         * @brief Close the object of the last service reported, in profile
+         * mode the time spent and the requests issued to discover its
+         * characteristics are added.
+         */
+        void closeService(uint32_t now) {
+            using namespace serialization;
+
+            response->getResultStream() << endArray;
+
+            if (profile) {
+                response->getResultStream() <<
+                    key("characteristics_duration") << (uint32_t) (now - serviceStartedAt) <<
+                    key("att_requests") << (uint16_t) (estimator.characteristicRequests() - serviceCharacteristicRequests);
+            }
+
+            response->getResultStream() << endObject;
+        }
+
         void whenDisconnected(const ble::DisconnectionCompleteEvent &e) {
             using namespace serialization;
 
@@ -155,10 +477,7 @@ DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
                 return;
             };
 
-            if(isFirstServiceDiscovered == false) {
-                response->getResultStream() << endArray << endObject;
-            }
-
+            closeResult();
             response->getResultStream() << "disconnection during discovery";
             response->faillure();
 
@@ -168,23 +487,46 @@ DECLARE_CMD(DiscoverAllServicesAndCharacteristicsCommand) {
         virtual void doWhenTimeout() {
             using namespace serialization;
 
+            closeResult();
+            response->getResultStream() << "discovery timeout";
+            response->faillure();
+        }
+
+        void closeResult() {
+            using namespace serialization;
+
             if(isFirstServiceDiscovered == false) {
                 response->getResultStream() << endArray << endObject;
             }
 
-            response->getResultStream() << "discovery timeout";
-            response->faillure();
+            if (report) {
+                response->getResultStream() << endArray << endObject;
+            }
         }
 
         ble::connection_handle_t connectionHandle;
         bool isFirstServiceDiscovered;
+        bool report;
+        bool profile;
+        GattDiscoveryCache::Entry* cacheEntry;
+        AttRequestEstimator estimator;
+        DiscoveryClock clock;
+        // duration of the primary services discovery
+        uint32_t servicesPhase;
+        // start, on the clock, and requests count of the characteristics
+        // discovery of the current service
+        uint32_t serviceStartedAt;
+        uint16_t serviceCharacteristicRequests;
     };
 };
 
 
 DECLARE_CMD(DiscoverAllServicesCommand) {
     CMD_NAME("discoverAllServices")
-    CMD_HELP("discover all services available on a peer device")
+    CMD_HELP("discover all services available on a peer device. If useCache is present, "
+        "the result is an object which reports the cost of the discovery. If useCache "
+        "is true and the peer is in the discovery cache, the services are served from "
+        "the cache.")
     CMD_ARGS(
         CMD_ARG("uint16_t", "connectionHandle", "The connection used by this procedure")
     )
@@ -197,15 +539,33 @@ DECLARE_CMD(DiscoverAllServicesCommand) {
         CMD_RESULT("uint16_t", "[i].end_handle", "Last handle of the service.")
     )
 
-    CMD_HANDLER(uint16_t connectionHandle, CommandResponsePtr& response) {
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 2;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint16_t connectionHandle;
+        bool report;
+        bool useCache;
+        bool profile;
+        if (!parseDiscoveryArgs(args, response, connectionHandle, report, useCache, profile)) {
+            return;
+        }
+
+        if (useCache && serveDiscoveryFromCache(connectionHandle, /* characteristics */ false, response)) {
+            return;
+        }
+
         startProcedure<DiscoverAllServicesProcedure>(
-            response, /* timeout */ 30 * 1000, connectionHandle
+            response, /* timeout */ 30 * 1000, connectionHandle, report
         );
     }
 
     struct DiscoverAllServicesProcedure : public AsyncProcedure {
-        DiscoverAllServicesProcedure(CommandResponsePtr& res, uint32_t timeout, uint16_t handle) :
-            AsyncProcedure(res, timeout), connectionHandle(handle) {
+        DiscoverAllServicesProcedure(CommandResponsePtr& res, uint32_t timeout, uint16_t handle, bool report) :
+            AsyncProcedure(res, timeout), connectionHandle(handle),
+            report(report), estimator(getAttMtu(handle)) {
         }
 
         virtual ~DiscoverAllServicesProcedure() {
@@ -216,6 +576,9 @@ DECLARE_CMD(DiscoverAllServicesCommand) {
         }
 
         virtual bool doStart() {
+            using namespace serialization;
+
+            clock.start();
             ble_error_t err = client().discoverServices(
                 connectionHandle,
                 makeFunctionPointer(this, &DiscoverAllServicesProcedure::whenServiceDiscovered)
@@ -226,6 +589,8 @@ DECLARE_CMD(DiscoverAllServicesCommand) {
                 return false;
             }
 
+            DiscoveryClock::Pause pause(clock);
+
             client().onServiceDiscoveryTermination(makeFunctionPointer(
                 this, &DiscoverAllServicesProcedure::whenServiceDiscoveryTerminated
             ));
@@ -234,13 +599,25 @@ DECLARE_CMD(DiscoverAllServicesCommand) {
                 this, &DiscoverAllServicesProcedure::whenDisconnected
             ));
 
-            response->getResultStream() << serialization::startArray;
+            if (report) {
+                response->getResultStream() << startObject <<
+                    key("cached") << false <<
+                    key("services");
+            }
+
+            response->getResultStream() << startArray;
             return true;
         }
 
         void whenServiceDiscovered(const DiscoveredService * discoveredService) {
             using namespace serialization;
 
+            DiscoveryClock::Pause pause(clock);
+
+            if (report) {
+                estimator.addService(discoveredService->getUUID(), discoveredService->getEndHandle());
+            }
+
             response->getResultStream() <<  startObject <<
                 key("UUID") << discoveredService->getUUID() <<
                 key("start_handle") << discoveredService->getStartHandle() <<
@@ -255,7 +632,16 @@ DECLARE_CMD(DiscoverAllServicesCommand) {
                 return;
             };
 
+            const uint32_t duration = clock.elapsed();
             response->getResultStream() << endArray;
+
+            if (report) {
+                response->getResultStream() <<
+                    key("duration") << duration <<
+                    key("att_requests") << estimator.finish(/* characteristics */ false) <<
+                endObject;
+            }
+
             response->success();
             terminate();
         }
@@ -265,21 +651,99 @@ DECLARE_CMD(DiscoverAllServicesCommand) {
                 return;
             };
 
+            closeResult();
             response->getResultStream() << "disconnection during discovery";
             response->faillure();
             terminate();
         }
 
         virtual void doWhenTimeout() {
+            closeResult();
             response->getResultStream() << "discovery timeout";
             response->faillure();
         }
 
+        void closeResult() {
+            using namespace serialization;
+
+            if (report) {
+                response->getResultStream() << endArray << endObject;
+            }
+        }
+
         uint16_t connectionHandle;
+        bool report;
+        AttRequestEstimator estimator;
+        DiscoveryClock clock;
     };
 };
 
 
+DECLARE_CMD(GetDiscoveryCacheCommand) {
+    CMD_NAME("getDiscoveryCache")
+
+    CMD_HELP("Get the content and the statistics of the discovery cache.")
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "hits", "Number of discoveries served from the cache."),
+        CMD_RESULT("uint32_t", "misses", "Number of discoveries not found in the cache."),
+        CMD_RESULT("uint32_t", "invalidations", "Number of entries invalidated."),
+        CMD_RESULT("JSON Array", "entries", "Peers in the cache.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        const GattDiscoveryCache::Statistics& statistics = discovery_cache.getStatistics();
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+
+        os << startObject <<
+            key("hits") << statistics.hits <<
+            key("misses") << statistics.misses <<
+            key("invalidations") << statistics.invalidations <<
+            key("entries") << startArray;
+
+        for (size_t i = 0; i < discovery_cache.capacity(); ++i) {
+            const GattDiscoveryCache::Entry& entry = discovery_cache[i];
+            if (!entry.used) {
+                continue;
+            }
+
+            os << startObject <<
+                key("peer_address_type") << entry.peer_address_type <<
+                key("peer_address") << entry.peer_address <<
+                key("services") << entry.service_count <<
+                key("characteristics") << entry.characteristic_count <<
+                key("service_changed_handle") << entry.service_changed_handle <<
+                key("service_changed_subscribed") << entry.service_changed_subscribed <<
+                key("discovery_duration") << entry.discovery_duration <<
+                key("att_requests") << entry.att_requests <<
+                key("hits") << entry.hits <<
+            endObject;
+        }
+
+        os << endArray << endObject;
+    }
+};
+
+
+DECLARE_CMD(FlushDiscoveryCacheCommand) {
+    CMD_NAME("flushDiscoveryCache")
+
+    CMD_HELP("Invalidate all the entries of the discovery cache.")
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "", "Number of entries invalidated.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        response->success((uint32_t) discovery_cache.flush());
+    }
+};
+
+
 
 DECLARE_CMD(DiscoverPrimaryServicesByUUIDCommand) {
     CMD_NAME("discoverPrimaryServicesByUUID")
@@ -444,7 +908,8 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
 
     CMD_HELP("Find all the characteristic descriptor’s Attribute Handles and Attribute "
                "Types within a characteristic definition. The characteristic specified is "
-               "identified by the characteristic handle range.")
+               "identified by the characteristic handle range. If profile is true, the "
+               "result is an object which reports the time and ATT requests of the discovery.")
 
     CMD_ARGS(
         CMD_ARG("uint16_t", "connectionHandle", "The connection used by this procedure" ),
@@ -458,7 +923,36 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
         CMD_RESULT("uint16_t", "[i].handle", "Handle of the descriptor.")
     )
 
-    CMD_HANDLER(uint16_t connectionHandle, uint16_t startHandle, uint16_t lastHandle, CommandResponsePtr& response) {
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 4;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint16_t connectionHandle;
+        if (!fromString(args[0], connectionHandle)) {
+            response->invalidParameters("connectionHandle should be a uint16_t");
+            return;
+        }
+
+        uint16_t startHandle;
+        if (!fromString(args[1], startHandle)) {
+            response->invalidParameters("characteristicStartHandle should be a uint16_t");
+            return;
+        }
+
+        uint16_t lastHandle;
+        if (!fromString(args[2], lastHandle)) {
+            response->invalidParameters("endHandle should be a uint16_t");
+            return;
+        }
+
+        bool profile = false;
+        if (args.count() > 3 && !fromString(args[3], profile)) {
+            response->invalidParameters("profile should be a bool");
+            return;
+        }
+
         if(startHandle >= lastHandle) {
             response->invalidParameters("start handle should not be greater or equal to last handle");
             return;
@@ -466,13 +960,25 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
 
         // if there is no descriptors to discover, just return an empty array
         if ((startHandle + 1) == lastHandle) {
-            response->getResultStream() << serialization::startArray << serialization::endArray;
+            using namespace serialization;
+
+            if (profile) {
+                response->getResultStream() << startObject <<
+                    key("descriptors") << startArray << endArray <<
+                    key("duration") << (uint32_t) 0 <<
+                    key("att_requests") << (uint16_t) 0 <<
+                    key("profile") << startObject;
+                serializeDiscoveryLink(response->getResultStream(), connectionHandle);
+                response->getResultStream() << endObject << endObject;
+            } else {
+                response->getResultStream() << startArray << endArray;
+            }
             response->success();
             return;
         }
 
         startProcedure<DiscoverAllCharacteristicsDescriptorsProcedure>(
-            response, /* timeout */ 30 * 1000, connectionHandle, startHandle, lastHandle
+            response, /* timeout */ 30 * 1000, connectionHandle, startHandle, lastHandle, profile
         );
     }
 
@@ -482,11 +988,14 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
             uint32_t timeout,
             uint16_t connectionHandle,
             uint16_t startHandle,
-            uint16_t lastHandle
+            uint16_t lastHandle,
+            bool profile
         ) : AsyncProcedure(res, timeout),
             characteristic(
                 build_discovered_characteristic(connectionHandle, startHandle, lastHandle)
-            ) {
+            ),
+            profile(profile),
+            estimator(getAttMtu(connectionHandle)) {
         }
 
         virtual ~DiscoverAllCharacteristicsDescriptorsProcedure() {
@@ -497,6 +1006,9 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
         }
 
         virtual bool doStart() {
+            using namespace serialization;
+
+            clock.start();
             ble_error_t err = client().discoverCharacteristicDescriptors(
                 characteristic,
                 makeFunctionPointer(this, &DiscoverAllCharacteristicsDescriptorsProcedure::whenDescriptorDiscovered),
@@ -508,21 +1020,36 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
                 return false;
             }
 
+            DiscoveryClock::Pause pause(clock);
+
             GapCommandSuiteDescription::add_disconnection_callback(makeFunctionPointer(
                 this, &DiscoverAllCharacteristicsDescriptorsProcedure::whenDisconnected
             ));
 
-            response->getResultStream() << serialization::startArray;
+            if (profile) {
+                response->getResultStream() << startObject << key("descriptors");
+            }
+
+            response->getResultStream() << startArray;
             return true;
         }
 
         void whenDescriptorDiscovered(const CharacteristicDescriptorDiscovery::DiscoveryCallbackParams_t* result) {
             using namespace serialization;
 
+            const uint32_t now = clock.elapsed();
+            DiscoveryClock::Pause pause(clock);
+
             response->getResultStream() <<  startObject <<
                 key("handle") << result->descriptor.getAttributeHandle() <<
-                key("UUID") << result->descriptor.getUUID() <<
-            endObject;
+                key("UUID") << result->descriptor.getUUID();
+
+            if (profile) {
+                estimator.addDescriptor(result->descriptor.getUUID(), result->descriptor.getAttributeHandle());
+                response->getResultStream() << key("discovered_at") << now;
+            }
+
+            response->getResultStream() << endObject;
         }
 
         void whenServiceDiscoveryTerminated(const CharacteristicDescriptorDiscovery::TerminationCallbackParams_t* params) {
@@ -530,9 +1057,19 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
 
             if(params->status) {
                 response->getResultStream() << params->status << endArray;
+                closeResult();
                 response->faillure();
             } else {
+                const uint32_t duration = clock.elapsed();
                 response->getResultStream() << endArray;
+                if (profile) {
+                    response->getResultStream() <<
+                        key("duration") << duration <<
+                        key("att_requests") << estimator.finishDescriptors(characteristic.getLastHandle()) <<
+                        key("profile") << startObject;
+                    serializeDiscoveryLink(response->getResultStream(), characteristic.getConnectionHandle());
+                    response->getResultStream() << endObject << endObject;
+                }
                 response->success();
             }
 
@@ -547,6 +1084,7 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
             };
 
             response->getResultStream() << "disconnection" << endArray;
+            closeResult();
             response->faillure();
 
             terminate();
@@ -556,9 +1094,18 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
             using namespace serialization;
 
             response->getResultStream() << "discovery timeout" << endArray;
+            closeResult();
             response->faillure();
         }
 
+        void closeResult() {
+            using namespace serialization;
+
+            if (profile) {
+                response->getResultStream() << endObject;
+            }
+        }
+
 
         static DiscoveredCharacteristic build_discovered_characteristic(
             ble::connection_handle_t conn,
@@ -583,6 +1130,9 @@ struct DiscoverAllCharacteristicsDescriptorsCommand : public BaseCommand {
         }
 
         DiscoveredCharacteristic characteristic;
+        bool profile;
+        AttRequestEstimator estimator;
+        DiscoveryClock clock;
     };
 };
 
@@ -799,6 +1349,218 @@ struct SignedWriteWithoutResponseCommand : public BaseCommand {
 };
 
 
+// Largest payload of a write command: LE data length minus the L2CAP and ATT
+// headers.
+static const uint16_t WRITE_BURST_MAX_SIZE = 244;
+// Length of the signature appended to a signed write command.
+static const uint16_t WRITE_SIGNATURE_SIZE = 12;
+// Bounds of the delay, in ms, between two attempts of a write refused because
+// the stack is out of buffers.
+static const uint16_t WRITE_BURST_MIN_BACKOFF = 1;
+static const uint16_t WRITE_BURST_MAX_BACKOFF = 32;
+
+DECLARE_CMD(WriteWithoutResponseBurstCommand) {
+    CMD_NAME("writeWithoutResponseBurst")
+
+    CMD_HELP("Write a characteristic value count times as fast as the stack accepts the "
+        "packets. Writes refused by the stack because it is out of buffers are retried "
+        "after a delay which doubles until a write is accepted. The first two bytes of "
+        "each packet contain its sequence number, use gattServer countWrites on the "
+        "server to measure the packets received.")
+
+    CMD_ARGS(
+        CMD_ARG("uint16_t", "connectionHandle", "The connection used by this procedure"),
+        CMD_ARG("uint16_t", "characteristicValuehandle", "Handle of the characteristic value to write"),
+        CMD_ARG("uint16_t", "count", "Number of packets to write"),
+        CMD_ARG("uint16_t", "size", "Size of each packet"),
+        CMD_ARG("bool", "signed", "Use signed write commands")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint16_t", "count", "Number of packets to write."),
+        CMD_RESULT("uint16_t", "size", "Size of each packet."),
+        CMD_RESULT("bool", "signed", "True if the packets were signed."),
+        CMD_RESULT("uint16_t", "sent", "Number of packets accepted by the stack."),
+        CMD_RESULT("uint32_t", "bytes", "Payload bytes accepted by the stack."),
+        CMD_RESULT("uint32_t", "retries", "Number of writes refused with BLE_ERROR_NO_MEM."),
+        CMD_RESULT("uint32_t", "backoff", "Time spent, in ms, waiting before retries."),
+        CMD_RESULT("uint32_t", "duration", "Duration of the burst in µs."),
+        CMD_RESULT("uint32_t", "goodput", "Payload bytes accepted per second."),
+        CMD_RESULT("JSON Object", "latency", "Distribution of the time, in µs, between the first attempt to write a packet and its acceptance by the stack.")
+    )
+
+    CMD_HANDLER(uint16_t connectionHandle, uint16_t valueHandle, uint16_t count, uint16_t size, bool signedWrite, CommandResponsePtr& response) {
+        if (count == 0) {
+            response->invalidParameters("count should be a non null uint16_t");
+            return;
+        }
+
+        // ATT opcode and handle, plus the signature of signed writes
+        uint16_t overhead = 3 + (signedWrite ? WRITE_SIGNATURE_SIZE : 0);
+        uint16_t attMtu = getAttMtu(connectionHandle);
+        if (size == 0 || size > WRITE_BURST_MAX_SIZE || (size + overhead) > attMtu) {
+            response->invalidParameters("size should be non null and fit in the ATT_MTU");
+            return;
+        }
+
+        startProcedure<WriteBurstProcedure>(
+            response, /* timeout */ 5 * 1000 + count * 50,
+            connectionHandle, valueHandle, count, size, signedWrite
+        );
+    }
+
+    struct WriteBurstProcedure : public AsyncProcedure {
+        WriteBurstProcedure(
+            CommandResponsePtr& res,
+            uint32_t timeout,
+            uint16_t connectionHandle,
+            uint16_t valueHandle,
+            uint16_t count,
+            uint16_t size,
+            bool signedWrite
+        ) : AsyncProcedure(res, timeout),
+            _connectionHandle(connectionHandle), _valueHandle(valueHandle),
+            _count(count), _size(size), _signed(signedWrite),
+            _sent(0), _retries(0), _backoffTotal(0), _backoff(WRITE_BURST_MIN_BACKOFF),
+            _backoffHandle(NULL), _startedAt(0), _packetStartedAt(0), _packetPending(false) {
+        }
+
+        virtual ~WriteBurstProcedure() {
+            if (_backoffHandle) {
+                getCLICommandEventQueue()->cancel(_backoffHandle);
+            }
+            GapCommandSuiteDescription::detach_disconnection_callback(makeFunctionPointer(
+                this, &WriteBurstProcedure::whenDisconnected
+            ));
+        }
+
+        virtual bool doStart() {
+            GapCommandSuiteDescription::add_disconnection_callback(makeFunctionPointer(
+                this, &WriteBurstProcedure::whenDisconnected
+            ));
+
+            _startedAt = us_ticker_read();
+            return send();
+        }
+
+        virtual void doWhenTimeout() {
+            response->getResultStream() << "burst timeout";
+            response->faillure();
+        }
+
+    private:
+        /**
+         * @brief Write packets until the stack refuses one or all the packets
+         * have been sent.
+         * @return false if the procedure has terminated.
+         */
+        bool send() {
+            while (_sent < _count) {
+                if (!_packetPending) {
+                    fillPayload(_sent);
+                    _packetStartedAt = us_ticker_read();
+                    _packetPending = true;
+                }
+
+                ble_error_t err = client().write(
+                    _signed ? GattClient::GATT_OP_SIGNED_WRITE_CMD : GattClient::GATT_OP_WRITE_CMD,
+                    _connectionHandle, _valueHandle, _size, _payload
+                );
+
+                if (err == BLE_ERROR_NO_MEM) {
+                    ++_retries;
+                    _backoffTotal += _backoff;
+                    _backoffHandle = getCLICommandEventQueue()->post_in(
+                        &WriteBurstProcedure::whenBackoffElapsed, this, _backoff
+                    );
+                    _backoff = std::min<uint16_t>(_backoff * 2, WRITE_BURST_MAX_BACKOFF);
+                    return true;
+                }
+
+                if (err) {
+                    response->faillure(err);
+                    return false;
+                }
+
+                _latency.add(us_ticker_read() - _packetStartedAt);
+                _packetPending = false;
+                _backoff = WRITE_BURST_MIN_BACKOFF;
+                ++_sent;
+            }
+
+            reportResults();
+            return false;
+        }
+
+        void fillPayload(uint16_t sequence) {
+            for (uint16_t i = 0; i < _size; ++i) {
+                _payload[i] = sequence + i;
+            }
+
+            // little endian sequence number
+            _payload[0] = sequence;
+            if (_size > 1) {
+                _payload[1] = sequence >> 8;
+            }
+        }
+
+        void whenBackoffElapsed() {
+            _backoffHandle = NULL;
+            if (!send()) {
+                terminate();
+            }
+        }
+
+        void whenDisconnected(const ble::DisconnectionCompleteEvent &e) {
+            if (_connectionHandle != e.getConnectionHandle()) {
+                return;
+            }
+
+            response->getResultStream() << "disconnection during burst";
+            response->faillure();
+            terminate();
+        }
+
+        void reportResults() {
+            using namespace serialization;
+
+            uint32_t duration = us_ticker_read() - _startedAt;
+            uint32_t bytes = (uint32_t) _sent * _size;
+
+            response->success();
+            response->getResultStream() << startObject <<
+                key("count") << _count <<
+                key("size") << _size <<
+                key("signed") << _signed <<
+                key("sent") << _sent <<
+                key("bytes") << bytes <<
+                key("retries") << _retries <<
+                key("backoff") << _backoffTotal <<
+                key("duration") << duration <<
+                key("goodput") << (uint32_t) (duration ? ((uint64_t) bytes * 1000000) / duration : 0) <<
+                key("latency") << _latency <<
+            endObject;
+        }
+
+        uint16_t _connectionHandle;
+        uint16_t _valueHandle;
+        uint16_t _count;
+        uint16_t _size;
+        bool _signed;
+        uint16_t _sent;
+        uint32_t _retries;
+        uint32_t _backoffTotal;
+        uint16_t _backoff;
+        eq::EventQueue::event_handle_t _backoffHandle;
+        uint32_t _startedAt;
+        uint32_t _packetStartedAt;
+        bool _packetPending;
+        Histogram _latency;
+        uint8_t _payload[WRITE_BURST_MAX_SIZE];
+    };
+};
+
+
 struct WriteCommand : public BaseCommand {
     CMD_NAME("write")
 
@@ -982,7 +1744,7 @@ DECLARE_CMD(ListenHVXCommand) {
             using namespace serialization;
             serialization::JSONOutputStream& os = response->getResultStream();
 
-            os << startObject <<
+            os << lineBreak << startObject <<
                 key("connHandle") << hvx_event->connHandle <<
                 key("handle") << hvx_event->handle <<
                 key("type") << hvx_event->type <<
@@ -993,7 +1755,7 @@ DECLARE_CMD(ListenHVXCommand) {
 
         virtual void doWhenTimeout() {
             client().onHVX().detach(makeFunctionPointer(this, &ListenHVXProcedure::whenHVX));
-            response->getResultStream() << serialization::endArray;
+            response->getResultStream() << serialization::lineBreak << serialization::endArray;
         }
     };
 };
@@ -1102,10 +1864,16 @@ DECLARE_CMD(NegotiateAttMtu) {
 
 } // end of annonymous namespace
 
+void GattClientCommandSuiteDescription::reset() {
+    discovery_cache.reset();
+}
+
 
 DECLARE_SUITE_COMMANDS(GattClientCommandSuiteDescription,
     CMD_INSTANCE(DiscoverAllServicesAndCharacteristicsCommand),
     CMD_INSTANCE(DiscoverAllServicesCommand),
+    CMD_INSTANCE(GetDiscoveryCacheCommand),
+    CMD_INSTANCE(FlushDiscoveryCacheCommand),
     CMD_INSTANCE(DiscoverPrimaryServicesByUUIDCommand),
     //CMD_INSTANCE(DiscoverServicesCommand),
     CMD_INSTANCE(FindIncludedServicesCommand),
@@ -1118,6 +1886,7 @@ DECLARE_SUITE_COMMANDS(GattClientCommandSuiteDescription,
     CMD_INSTANCE(ReadMultipleCharacteristicValuesCommand),
     CMD_INSTANCE(WriteWithoutResponseCommand),
     CMD_INSTANCE(SignedWriteWithoutResponseCommand),
+    CMD_INSTANCE(WriteWithoutResponseBurstCommand),
     CMD_INSTANCE(WriteCommand),
     CMD_INSTANCE(WriteLongCommand),
     CMD_INSTANCE(ReliableWriteCommand),
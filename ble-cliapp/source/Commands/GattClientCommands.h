@@ -31,6 +31,11 @@ public:
         return "gattClient <command> <command arguments>.";
     }
 
+    /**
+     * Clear the discovery cache and its statistics.
+     */
+    static void reset();
+
     static ConstArray<const Command*> commands();
 };
 
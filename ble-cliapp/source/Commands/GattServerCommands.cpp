@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include "ble/BLE.h"
 #include "ble/Gap.h"
 #include "ble/services/HeartRateService.h"
@@ -22,14 +23,17 @@
 #include "Serialization/CharacteristicSecurity.h"
 #include "Serialization/BLECommonSerializer.h"
 #include "Serialization/GattCallbackParamTypes.h"
+#include "Serialization/Measure.h"
 
 #include "util/ServiceBuilder.h"
+#include "util/detail/GattServiceArena.h"
 #include "CLICommand/util/AsyncProcedure.h"
 
 #include "Common.h"
 
 #include "GattServerCommands.h"
 #include "CLICommand/CommandHelper.h"
+#include "hal/us_ticker_api.h"
 
 using mbed::util::SharedPointer;
 using ble::Gap;
@@ -42,8 +46,9 @@ namespace {
 
 static ServiceBuilder* serviceBuilder = NULL;
 
-static ::detail::RAIIGattService** gattServices = NULL;
+static ::detail::GattServiceArena** gattServices = NULL;
 static size_t gattServicesCount = 0;
+static size_t gattServicesCapacity = 0;
 static bool cleanupRegistered = false;
 
 static void cleanupServiceBuilder();
@@ -51,11 +56,12 @@ static void cleanupServiceBuilder();
 static void whenShutdown(const ble::GattServer*) {
     cleanupServiceBuilder();
     for(size_t i = 0; i < gattServicesCount; ++i) {
-        delete gattServices[i];
+        ::detail::GattServiceArena::destroy(gattServices[i]);
     }
     std::free(gattServices);
     gattServices = NULL;
     gattServicesCount = 0;
+    gattServicesCapacity = 0;
     gattServer().onShutdown().detach(whenShutdown);
     cleanupRegistered = false;
 }
@@ -386,7 +392,8 @@ DECLARE_CMD(CommitServiceCommand) {
         CMD_RESULT("uint16_t", "characteristics[].descriptors[].length", "Lenght of the descriptor value."),
         CMD_RESULT("uint16_t", "characteristics[].descriptors[].max_length", "Maximum lenght of the descriptor value."),
         CMD_RESULT("bool", "characteristics[].descriptors[].has_variable_length", "Indicate if the descriptor can have a variable length."),
-        CMD_RESULT("HexString", "characteristics[].descriptors[].value", "The value of the descriptor.")
+        CMD_RESULT("HexString", "characteristics[].descriptors[].value", "The value of the descriptor."),
+        CMD_RESULT("uint32_t", "arena_size", "Size in bytes of the memory block holding the service committed.")
     )
 
     CMD_HANDLER(CommandResponsePtr& response) {
@@ -397,19 +404,45 @@ DECLARE_CMD(CommitServiceCommand) {
             return;
         }
 
-        serviceBuilder->commit();
-        ::detail::RAIIGattService* service = serviceBuilder->release();
+        // build the service tree and its values in a single memory block
+        ::detail::GattServiceArena* arena = ::detail::GattServiceArena::create(
+            serviceBuilder->getDeclaration()
+        );
+        if(!arena) {
+            response->faillure("Not enough memory to store the service");
+            cleanupServiceBuilder();
+            return;
+        }
+
+        // reserve the slot of the service before it is added to the GattServer:
+        // it couldn't be released otherwise.
+        if(gattServicesCount == gattServicesCapacity) {
+            size_t newCapacity = gattServicesCapacity ? gattServicesCapacity * 2 : 4;
+            ::detail::GattServiceArena** services = static_cast<::detail::GattServiceArena**>(
+                std::realloc(gattServices, sizeof(*gattServices) * newCapacity)
+            );
+            if(!services) {
+                response->faillure("Not enough memory to store the service");
+                ::detail::GattServiceArena::destroy(arena);
+                cleanupServiceBuilder();
+                return;
+            }
+            gattServices = services;
+            gattServicesCapacity = newCapacity;
+        }
 
+        GattService* service = &arena->getService();
         ble_error_t err = gattServer().addService(*service);
         if(err) {
             response->faillure(err);
-            delete service;
+            ::detail::GattServiceArena::destroy(arena);
         } else {
             response->success();
             // iterate over all handles
             serialization::JSONOutputStream& os = response->getResultStream() << startObject <<
                 key("UUID") << service->getUUID() <<
                 key("handle") << service->getHandle() <<
+                key("arena_size") << (uint32_t) arena->getSize() <<
                 key("characteristics") << startArray;
 
             for(uint16_t i = 0; i < service->getCharacteristicCount(); ++i) {
@@ -464,12 +497,8 @@ DECLARE_CMD(CommitServiceCommand) {
             os << endObject;
 
             // add the service inside the list of instantiated services
-            gattServices = static_cast<::detail::RAIIGattService**>(std::realloc(gattServices, sizeof(*gattServices) * (gattServicesCount + 1)));
-            gattServices[gattServicesCount] = service;
+            gattServices[gattServicesCount] = arena;
             gattServicesCount += 1;
-
-            // release unused memory
-            service->releaseAttributesValue();
         }
 
         // anyway, everything is cleaned up
@@ -494,6 +523,102 @@ DECLARE_CMD(CancelServiceDeclarationCommand) {
 };
 
 
+DECLARE_CMD(DumpDatabaseCommand) {
+    CMD_NAME("dumpDatabase")
+
+    CMD_HELP("Read every attribute of the services committed in the GATT server and "
+               "report them in a single response.")
+
+    CMD_RESULTS(
+        CMD_RESULT("JSON Array", "", "The attributes of the services committed, ordered by handle."),
+        CMD_RESULT("uint16_t", "[].handle", "Handle of the attribute."),
+        CMD_RESULT("UUID", "[].UUID", "UUID of the attribute."),
+        CMD_RESULT("string", "[].type", "Type of the attribute: service, characteristic or descriptor."),
+        CMD_RESULT("JSON Array", "[].properties", "Properties of a characteristic."),
+        CMD_RESULT("uint16_t", "[].length", "Length of the value of a characteristic or descriptor."),
+        CMD_RESULT("HexString", "[].value", "Value of a characteristic or descriptor.")
+    )
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        using namespace serialization;
+
+        // the same buffer is used to read every attribute, size it to the largest one
+        uint16_t bufferSize = 0;
+        for(size_t i = 0; i < gattServicesCount; ++i) {
+            GattService& service = gattServices[i]->getService();
+            for(uint8_t j = 0; j < service.getCharacteristicCount(); ++j) {
+                GattCharacteristic& characteristic = *service.getCharacteristic(j);
+                bufferSize = std::max(bufferSize, characteristic.getValueAttribute().getMaxLength());
+                for(uint8_t k = 0; k < characteristic.getDescriptorCount(); ++k) {
+                    bufferSize = std::max(bufferSize, characteristic.getDescriptor(k)->getMaxLength());
+                }
+            }
+        }
+
+        uint8_t* buffer = bufferSize ? new uint8_t[bufferSize] : NULL;
+
+        response->success();
+        JSONOutputStream& os = response->getResultStream();
+        os << startArray;
+        for(size_t i = 0; i < gattServicesCount; ++i) {
+            GattService& service = gattServices[i]->getService();
+            os << startObject <<
+                key("handle") << service.getHandle() <<
+                key("UUID") << service.getUUID() <<
+                key("type") << "service" <<
+            endObject;
+
+            for(uint8_t j = 0; j < service.getCharacteristicCount(); ++j) {
+                GattCharacteristic& characteristic = *service.getCharacteristic(j);
+                GattAttribute& value = characteristic.getValueAttribute();
+
+                os << startObject <<
+                    key("handle") << value.getHandle() <<
+                    key("UUID") << value.getUUID() <<
+                    key("type") << "characteristic" <<
+                    key("properties");
+                serializeCharacteristicProperties(os, characteristic.getProperties());
+                serializeAttributeValue(os, value.getHandle(), buffer, bufferSize);
+                os << endObject;
+
+                for(uint8_t k = 0; k < characteristic.getDescriptorCount(); ++k) {
+                    GattAttribute& descriptor = *characteristic.getDescriptor(k);
+                    os << startObject <<
+                        key("handle") << descriptor.getHandle() <<
+                        key("UUID") << descriptor.getUUID() <<
+                        key("type") << "descriptor";
+                    serializeAttributeValue(os, descriptor.getHandle(), buffer, bufferSize);
+                    os << endObject;
+                }
+            }
+        }
+        os << endArray;
+
+        delete[] buffer;
+    }
+
+    static void serializeAttributeValue(
+        serialization::JSONOutputStream& os, GattAttribute::Handle_t handle, uint8_t* buffer, uint16_t bufferSize
+    ) {
+        using namespace serialization;
+
+        uint16_t length = bufferSize;
+        ble_error_t err = gattServer().read(handle, buffer, &length);
+        if(err) {
+            os << key("error") << err;
+            return;
+        }
+
+        os << key("length") << length << key("value");
+        if(length) {
+            serializeRawDataToHexString(os, buffer, length);
+        } else {
+            os << "";
+        }
+    }
+};
+
+
 DECLARE_CMD(ReadCommand) {
     CMD_NAME("read")
 
@@ -686,6 +811,144 @@ DECLARE_CMD(WaitForDataWrittenCommand) {
     };
 };
 
+
+DECLARE_CMD(CountWritesCommand) {
+    CMD_NAME("countWrites")
+
+    CMD_HELP("Count the writes of a given characteristic from a given connection until "
+        "count writes are received or the procedure times out. The first two bytes of "
+        "each write are interpreted as a sequence number, as written by "
+        "gattClient writeWithoutResponseBurst.")
+
+    CMD_ARGS(
+        CMD_ARG("uint16_t", "connection_handle", "The connection ID with the client writing data"),
+        CMD_ARG("uint16_t", "attribute_handle", "The attribute handle which will be written"),
+        CMD_ARG("uint16_t", "count", "Number of writes expected"),
+        CMD_ARG("uint16_t", "timeout", "Maximum time allowed for this procedure")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint16_t", "packets", "Number of writes received."),
+        CMD_RESULT("uint32_t", "bytes", "Number of bytes received."),
+        CMD_RESULT("uint16_t", "lost", "Number of sequence numbers skipped."),
+        CMD_RESULT("uint16_t", "out_of_order", "Number of writes received with a sequence number lower than expected."),
+        CMD_RESULT("uint16_t", "signed", "Number of signed writes received."),
+        CMD_RESULT("uint32_t", "duration", "Time, in µs, between the first and the last write."),
+        CMD_RESULT("uint32_t", "goodput", "Bytes received per second after the first write."),
+        CMD_RESULT("JSON Object", "interval", "Distribution of the time, in µs, between two writes.")
+    )
+
+    CMD_HANDLER(ble::connection_handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint16_t count, uint16_t procedureTimeout, CommandResponsePtr& response) {
+        if (count == 0) {
+            response->invalidParameters("count should be a non null uint16_t");
+            return;
+        }
+
+        startProcedure<CountWritesProcedure>(
+            response,
+            procedureTimeout,
+            connectionHandle,
+            attributeHandle,
+            count
+        );
+    }
+
+    struct CountWritesProcedure : public AsyncProcedure {
+        CountWritesProcedure(CommandResponsePtr& res, uint32_t procedureTimeout,
+            ble::connection_handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint16_t count) :
+            AsyncProcedure(res, procedureTimeout),
+            connection(connectionHandle),
+            attribute(attributeHandle),
+            expected(count),
+            packets(0), bytes(0), firstBytes(0), lost(0), outOfOrder(0), signedWrites(0),
+            nextSequence(0), firstAt(0), lastAt(0) {
+        }
+
+        virtual ~CountWritesProcedure() {
+            gattServer().onDataWritten().detach(makeFunctionPointer(this, &CountWritesProcedure::whenDataWritten));
+        }
+
+        virtual bool doStart() {
+            gattServer().onDataWritten(this, &CountWritesProcedure::whenDataWritten);
+            return true;
+        }
+
+        virtual void doWhenTimeout() {
+            // writes without response can be dropped, report what has been received
+            reportResults();
+        }
+
+        void whenDataWritten(const GattWriteCallbackParams* params) {
+            // filter events not relevant
+            if(params->connHandle != connection || params->handle != attribute) {
+                return;
+            }
+
+            uint32_t now = us_ticker_read();
+            if (packets == 0) {
+                firstAt = now;
+                firstBytes = params->len;
+            } else {
+                interval.add(now - lastAt);
+            }
+            lastAt = now;
+
+            ++packets;
+            bytes += params->len;
+            if (params->writeOp == GattWriteCallbackParams::OP_SIGN_WRITE_CMD) {
+                ++signedWrites;
+            }
+
+            if (params->len >= 2) {
+                uint16_t sequence = params->data[0] | (params->data[1] << 8);
+                if (sequence >= nextSequence) {
+                    lost += sequence - nextSequence;
+                    nextSequence = sequence + 1;
+                } else {
+                    ++outOfOrder;
+                }
+            }
+
+            if (packets == expected) {
+                reportResults();
+                terminate();
+            }
+        }
+
+        void reportResults() {
+            using namespace serialization;
+
+            uint32_t duration = lastAt - firstAt;
+
+            response->success();
+            response->getResultStream() << startObject <<
+                key("packets") << packets <<
+                key("bytes") << bytes <<
+                key("lost") << lost <<
+                key("out_of_order") << outOfOrder <<
+                key("signed") << signedWrites <<
+                key("duration") << duration <<
+                key("goodput") << (uint32_t) (duration ? ((uint64_t) (bytes - firstBytes) * 1000000) / duration : 0) <<
+                key("interval") << interval <<
+            endObject;
+        }
+
+        ble::connection_handle_t connection;
+        GattAttribute::Handle_t attribute;
+        uint16_t expected;
+        uint16_t packets;
+        uint32_t bytes;
+        uint32_t firstBytes;
+        uint16_t lost;
+        uint16_t outOfOrder;
+        uint16_t signedWrites;
+        uint16_t nextSequence;
+        uint32_t firstAt;
+        uint32_t lastAt;
+        Histogram interval;
+    };
+};
+
 } // end of annonymous namespace
 
 
@@ -704,6 +967,8 @@ DECLARE_SUITE_COMMANDS(GattServerCommandSuiteDescription,
     CMD_INSTANCE(CommitServiceCommand),
     CMD_INSTANCE(CancelServiceDeclarationCommand),
     CMD_INSTANCE(ReadCommand),
+    CMD_INSTANCE(DumpDatabaseCommand),
     CMD_INSTANCE(WriteCommand),
-    CMD_INSTANCE(WaitForDataWrittenCommand)
+    CMD_INSTANCE(WaitForDataWrittenCommand),
+    CMD_INSTANCE(CountWritesCommand)
 )
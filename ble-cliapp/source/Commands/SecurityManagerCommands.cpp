@@ -22,12 +22,16 @@
 #include "Serialization/SecurityManagerSerialization.h"
 #include "Serialization/BLECommonSerializer.h"
 #include "Serialization/GapSerializer.h"
+#include "Serialization/Measure.h"
 
 #include "Common.h"
 
 #include "SecurityManagerCommands.h"
+#include "BLECommands.h"
 #include "CLICommand/CommandHelper.h"
 #include "CLICommand/util/AsyncProcedure.h"
+#include "CLICommand/CommandEventQueue.h"
+#include "hal/us_ticker_api.h"
 
 using mbed::util::SharedPointer;
 using ble::connection_handle_t;
@@ -251,6 +255,164 @@ DECLARE_CMD(GenerateWhitelistFromBondTableCommand) {
     };
 };
 
+DECLARE_CMD(BenchmarkBondTableCommand) {
+    CMD_NAME("benchmarkBondTable")
+
+    CMD_HELP("Measure, over a number of iterations, the time taken to restore the bond "
+        "table from a database file and the time taken to generate a whitelist from "
+        "the bond table.")
+
+    CMD_ARGS(
+        CMD_ARG("char*", "dbPath", "Path to the file containing the bond table."),
+        CMD_ARG("uint16_t", "iterations", "Number of measures of each operation.")
+    )
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        uint16_t iterations;
+        if (!fromString(args[1], iterations) || iterations == 0) {
+            response->invalidParameters("iterations should be a non null uint16_t");
+            return;
+        }
+
+        startProcedure<BenchmarkBondTableProcedure>(
+            args[0], iterations, response, /* timeout */ iterations * 5 * 1000
+        );
+    }
+
+    struct BenchmarkBondTableProcedure : public AsyncProcedure, public SecurityManager::EventHandler {
+        BenchmarkBondTableProcedure(
+            const char* dbPath,
+            uint16_t iterations,
+            const CommandResponsePtr& res,
+            uint32_t timeout
+        ) : AsyncProcedure(res, timeout),
+            _dbPath(new char[strlen(dbPath) + 1]), _iterations(iterations),
+            _iterationHandle(NULL), _whitelistStart(0)
+        {
+            strcpy(_dbPath, dbPath);
+
+            _whiteList.capacity = gap().getMaxWhitelistSize();
+            _whiteList.addresses = new ble::whitelist_t::entry_t[_whiteList.capacity];
+            _whiteList.size = 0;
+
+            sm().setSecurityManagerEventHandler(this);
+        }
+
+        virtual ~BenchmarkBondTableProcedure() {
+            sm().setSecurityManagerEventHandler(NULL);
+            if (_iterationHandle) {
+                getCLICommandEventQueue()->cancel(_iterationHandle);
+            }
+            delete[] _whiteList.addresses;
+            delete[] _dbPath;
+        }
+
+        virtual bool doStart() {
+#if not defined(NO_FILESYSTEM)
+            LatencyBlockDevice* bd = BLECommandSuiteDescription::getBlockDevice();
+            _initialStatistics = bd ? bd->getStatistics() : LatencyBlockDevice::Statistics();
+#endif //not defined(NO_FILESYSTEM)
+            return runIteration();
+        }
+
+        virtual void doWhenTimeout() {
+            response->getResultStream() << "benchmarkBondTable timeout";
+            response->faillure();
+        }
+
+        // SecurityManagerEventHandler implementation
+        virtual void whitelistFromBondTable(ble::whitelist_t* whitelist) {
+            _generation.add(us_ticker_read() - _whitelistStart);
+
+            if (_generation.count == _iterations) {
+                reportResults(whitelist->size);
+                terminate();
+                return;
+            }
+
+            // The database cannot be replaced from the handler of one of its
+            // operations, the next iteration is started from the event queue.
+            _iterationHandle = getCLICommandEventQueue()->post(
+                &BenchmarkBondTableProcedure::whenIterationPosted, this
+            );
+        }
+
+    private:
+        bool runIteration() {
+            uint32_t start = us_ticker_read();
+            // the database is reopened and its content restored from the file
+            BLE_SM_TEST_ASSERT_RET( sm().setDatabaseFilepath(_dbPath), false );
+            _restore.add(us_ticker_read() - start);
+
+            _whiteList.size = 0;
+            _whitelistStart = us_ticker_read();
+            BLE_SM_TEST_ASSERT_RET( sm().generateWhitelistFromBondTable(&_whiteList), false );
+            return true;
+        }
+
+        void whenIterationPosted() {
+            _iterationHandle = NULL;
+            if (!runIteration()) {
+                terminate();
+            }
+        }
+
+        void reportResults(std::size_t whitelistSize) {
+            using namespace serialization;
+
+            response->success();
+            serialization::JSONOutputStream& os = response->getResultStream();
+
+            os << startObject <<
+                key("iterations") << _iterations <<
+                key("whitelist_size") << (uint32_t) whitelistSize <<
+                key("restore") << _restore <<
+                key("whitelist") << _generation;
+
+#if not defined(NO_FILESYSTEM)
+            LatencyBlockDevice* bd = BLECommandSuiteDescription::getBlockDevice();
+            if (bd) {
+                const LatencyBlockDevice::Statistics& statistics = bd->getStatistics();
+                os << key("block_device") << startObject <<
+                    key("reads") << (statistics.reads - _initialStatistics.reads) <<
+                    key("programs") << (statistics.programs - _initialStatistics.programs) <<
+                    key("erases") << (statistics.erases - _initialStatistics.erases) <<
+                    key("delay") << (statistics.delay - _initialStatistics.delay) <<
+                endObject;
+            }
+#endif //not defined(NO_FILESYSTEM)
+
+            os << endObject;
+        }
+
+        char* _dbPath;
+        uint16_t _iterations;
+        eq::EventQueue::event_handle_t _iterationHandle;
+        uint32_t _whitelistStart;
+        Measure _restore;
+        Measure _generation;
+        ble::whitelist_t _whiteList;
+#if not defined(NO_FILESYSTEM)
+        LatencyBlockDevice::Statistics _initialStatistics;
+#endif //not defined(NO_FILESYSTEM)
+    };
+};
+
+// The Security Manager does not expose whether pairing requests require an
+// authorisation; track the last value set so it can be restored.
+static bool& pairingRequestAuthorisation() {
+    static bool required = false;
+    return required;
+}
+
+static ble_error_t setPairingRequestAuthorisation(bool required) {
+    ble_error_t err = sm().setPairingRequestAuthorisation(required);
+    if (!err) {
+        pairingRequestAuthorisation() = required;
+    }
+    return err;
+}
+
 // Pairing
 DECLARE_CMD(SetPairingRequestAuthorisationCommand) {
     CMD_NAME("setPairingRequestAuthorisation")
@@ -266,7 +428,7 @@ DECLARE_CMD(SetPairingRequestAuthorisationCommand) {
             "they be automatically accepted.")
 
     CMD_HANDLER(bool required, CommandResponsePtr& response) {
-        ble_error_t err = sm().setPairingRequestAuthorisation(required);
+        ble_error_t err = setPairingRequestAuthorisation(required);
         reportErrorOrSuccess(response, err);
     }
 };
@@ -683,8 +845,363 @@ DECLARE_CMD(SetLinkEncryptionAndWaitCommand) {
     };
 };
 
+// Passkey used by both sides of a pairing benchmark, it is displayed by one
+// side and entered by the other.
+static const SecurityManager::Passkey_t BENCHMARK_PASSKEY = { '1', '2', '3', '4', '5', '6' };
+
+// Event handler of the peer of a pairing benchmark. It accepts the pairing
+// requests and answers the authentication requests without user interaction.
+struct AutoPairingHandler : public SecurityManager::EventHandler {
+    AutoPairingHandler() :
+        requests(0), successes(0), failures(0), enabled(false), previousAuthorisation(false) { }
+
+    void reset() {
+        requests = 0;
+        successes = 0;
+        failures = 0;
+        enabled = false;
+    }
+
+    // SecurityManagerEventHandler implementation
+    virtual void pairingRequest(ble::connection_handle_t connectionHandle) {
+        ++requests;
+        sm().acceptPairingRequest(connectionHandle);
+    }
+
+    virtual void confirmationRequest(ble::connection_handle_t connectionHandle) {
+        sm().confirmationEntered(connectionHandle, true);
+    }
+
+    virtual void passkeyRequest(ble::connection_handle_t connectionHandle) {
+        sm().passkeyEntered(connectionHandle, const_cast<uint8_t*>(BENCHMARK_PASSKEY));
+    }
+
+    virtual void pairingResult(ble::connection_handle_t connectionHandle, SecurityManager::SecurityCompletionStatus_t result) {
+        if (result == SecurityManager::SEC_STATUS_SUCCESS) {
+            ++successes;
+        } else {
+            ++failures;
+        }
+    }
+
+    uint32_t requests;
+    uint32_t successes;
+    uint32_t failures;
+    // pairing request authorisation to restore when the mode is disabled
+    bool enabled;
+    bool previousAuthorisation;
+};
+
+static AutoPairingHandler& autoPairingHandler() {
+    static AutoPairingHandler handler;
+    return handler;
+}
+
+DECLARE_CMD(SetAutoPairingCommand) {
+    CMD_NAME("setAutoPairing")
+
+    CMD_HELP("Accept pairing requests and answer confirmation and passkey requests "
+        "automatically. This is the mode of the peer of benchmarkPairing; the passkey "
+        "displayed and entered is 123456. The mode ends when another procedure "
+        "of the Security Manager is started. Disabling the mode restores the "
+        "authorisation of pairing requests set before it was enabled.")
+
+    CMD_ARGS(
+        CMD_ARG("bool", "enable", "Enable or disable the automatic pairing.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint32_t", "requests", "Number of pairing requests accepted while the mode was enabled."),
+        CMD_RESULT("uint32_t", "successes", "Number of pairing completed successfully while the mode was enabled."),
+        CMD_RESULT("uint32_t", "failures", "Number of pairing failed while the mode was enabled.")
+    )
+
+    CMD_HANDLER(bool enable, CommandResponsePtr& response) {
+        using namespace serialization;
+
+        AutoPairingHandler& handler = autoPairingHandler();
+
+        if (enable) {
+            const bool previousAuthorisation = handler.enabled ?
+                handler.previousAuthorisation : pairingRequestAuthorisation();
+            ble_error_t err = sm().setDisplayPasskey(BENCHMARK_PASSKEY);
+            if (!err) {
+                // pairing requests are accepted by the handler so they can be counted
+                err = setPairingRequestAuthorisation(true);
+            }
+            if (err) {
+                response->faillure(err);
+                return;
+            }
+            handler.reset();
+            handler.enabled = true;
+            handler.previousAuthorisation = previousAuthorisation;
+            sm().setSecurityManagerEventHandler(&handler);
+        } else {
+            sm().setSecurityManagerEventHandler(NULL);
+            if (handler.enabled) {
+                ble_error_t err = setPairingRequestAuthorisation(handler.previousAuthorisation);
+                if (err) {
+                    response->faillure(err);
+                    return;
+                }
+                handler.enabled = false;
+            }
+        }
+
+        response->success();
+        response->getResultStream() << startObject <<
+            key("requests") << handler.requests <<
+            key("successes") << handler.successes <<
+            key("failures") << handler.failures <<
+        endObject;
+    }
+};
+
+DECLARE_CMD(BenchmarkPairingCommand) {
+    CMD_NAME("benchmarkPairing")
+
+    CMD_HELP("Pair repeatedly over a connection and measure the duration of each phase "
+        "of the pairing. The peer should be in auto pairing mode and bonding should be "
+        "disabled on both sides. Confirmation and passkey requests are answered locally "
+        "with the passkey 123456.")
+
+    CMD_ARGS(
+        CMD_ARG("uint16_t", "connectionHandle", "The connection used by this procedure"),
+        CMD_ARG("uint16_t", "iterations", "Number of pairing to run.")
+    )
+
+    CMD_RESULTS(
+        CMD_RESULT("uint16_t", "iterations", "Number of pairing run."),
+        CMD_RESULT("string", "pairing_method", "Method of the last pairing: JUST_WORKS, PASSKEY_ENTRY or NUMERIC_COMPARISON."),
+        CMD_RESULT("string", "pairing_type", "Type of the last pairing: SECURE_CONNECTIONS, LEGACY or UNKNOWN."),
+        CMD_RESULT("uint32_t", "successes", "Number of pairing completed successfully."),
+        CMD_RESULT("uint32_t", "failures", "Number of pairing failed."),
+        CMD_RESULT("ble::link_encryption_t", "link_encryption", "Encryption of the link after the last pairing."),
+        CMD_RESULT("JSON object", "authentication", "Duration from the pairing request to the authentication request."),
+        CMD_RESULT("JSON object", "encryption", "Duration from the pairing request to the encryption of the link."),
+        CMD_RESULT("JSON object", "key_distribution", "Duration from the encryption of the link to the end of the pairing."),
+        CMD_RESULT("JSON object", "total", "Duration from the pairing request to the end of the pairing.")
+    )
+
+    CMD_HANDLER(uint16_t connectionHandle, uint16_t iterations, CommandResponsePtr& response) {
+        if (iterations == 0) {
+            response->invalidParameters("iterations should be a non null uint16_t");
+            return;
+        }
+
+        startProcedure<BenchmarkPairingProcedure>(
+            connectionHandle, iterations, response, /* timeout */ iterations * 10 * 1000
+        );
+    }
+
+    struct BenchmarkPairingProcedure : public AsyncProcedure, public SecurityManager::EventHandler {
+        // pairing method, deduced from the requests of the Security Manager
+        enum method_t {
+            JUST_WORKS,
+            PASSKEY_ENTRY,
+            NUMERIC_COMPARISON
+        };
+
+        BenchmarkPairingProcedure(
+            uint16_t connectionHandle,
+            uint16_t iterations,
+            const CommandResponsePtr& res,
+            uint32_t timeout
+        ) : AsyncProcedure(res, timeout),
+            _connectionHandle(connectionHandle), _iterations(iterations),
+            _iteration(0), _successes(0), _failures(0),
+            _iterationHandle(NULL), _requestedAt(0), _encryptedAt(0),
+            _authenticated(false), _encrypted(false), _method(JUST_WORKS),
+            _encryption(ble::link_encryption_t::NOT_ENCRYPTED)
+        {
+            sm().setSecurityManagerEventHandler(this);
+        }
+
+        virtual ~BenchmarkPairingProcedure() {
+            sm().setSecurityManagerEventHandler(NULL);
+            if (_iterationHandle) {
+                getCLICommandEventQueue()->cancel(_iterationHandle);
+            }
+        }
+
+        virtual bool doStart() {
+            BLE_SM_TEST_ASSERT_RET( sm().setDisplayPasskey(BENCHMARK_PASSKEY), false );
+            return runIteration();
+        }
+
+        virtual void doWhenTimeout() {
+            sm().cancelPairingRequest(_connectionHandle);
+
+            response->getResultStream() << "benchmarkPairing timeout";
+            response->faillure();
+        }
+
+        // SecurityManagerEventHandler implementation
+        virtual void confirmationRequest(ble::connection_handle_t connectionHandle) {
+            if (connectionHandle != _connectionHandle) { return; }
+            authenticationRequested(NUMERIC_COMPARISON);
+            sm().confirmationEntered(connectionHandle, true);
+        }
+
+        virtual void passkeyRequest(ble::connection_handle_t connectionHandle) {
+            if (connectionHandle != _connectionHandle) { return; }
+            authenticationRequested(PASSKEY_ENTRY);
+            sm().passkeyEntered(connectionHandle, const_cast<uint8_t*>(BENCHMARK_PASSKEY));
+        }
+
+        virtual void passkeyDisplay(ble::connection_handle_t connectionHandle, const SecurityManager::Passkey_t passkey) {
+            if (connectionHandle != _connectionHandle) { return; }
+            // the value of a numeric comparison is displayed as well
+            if (_method != NUMERIC_COMPARISON) {
+                authenticationRequested(PASSKEY_ENTRY);
+            }
+        }
+
+        virtual void linkEncryptionResult(ble::connection_handle_t connectionHandle, ble::link_encryption_t result) {
+            if (connectionHandle != _connectionHandle) { return; }
+
+            _encryption = result;
+            if (_encrypted || result == ble::link_encryption_t::NOT_ENCRYPTED) {
+                return;
+            }
+
+            _encrypted = true;
+            _encryptedAt = us_ticker_read();
+            _encryptionDuration.add(_encryptedAt - _requestedAt);
+        }
+
+        virtual void pairingResult(ble::connection_handle_t connectionHandle, SecurityManager::SecurityCompletionStatus_t result) {
+            if (connectionHandle != _connectionHandle) { return; }
+
+            uint32_t now = us_ticker_read();
+            if (result == SecurityManager::SEC_STATUS_SUCCESS) {
+                ++_successes;
+                _total.add(now - _requestedAt);
+                if (_encrypted) {
+                    _keyDistribution.add(now - _encryptedAt);
+                }
+            } else {
+                ++_failures;
+            }
+
+            if (++_iteration == _iterations) {
+                reportResults();
+                terminate();
+                return;
+            }
+
+            // Pairing cannot be requested from the handler of the previous
+            // one, the next iteration is started from the event queue.
+            _iterationHandle = getCLICommandEventQueue()->post(
+                &BenchmarkPairingProcedure::whenIterationPosted, this
+            );
+        }
+
+    private:
+        bool runIteration() {
+            _authenticated = false;
+            _encrypted = false;
+            _method = JUST_WORKS;
+            _requestedAt = us_ticker_read();
+            BLE_SM_TEST_ASSERT_RET( sm().requestPairing(_connectionHandle), false );
+            return true;
+        }
+
+        void whenIterationPosted() {
+            _iterationHandle = NULL;
+            if (!runIteration()) {
+                terminate();
+            }
+        }
+
+        void authenticationRequested(method_t method) {
+            _method = method;
+            if (_authenticated) {
+                return;
+            }
+            _authenticated = true;
+            _authentication.add(us_ticker_read() - _requestedAt);
+        }
+
+        const char* pairingMethod() const {
+            switch (_method) {
+                case PASSKEY_ENTRY:
+                    return "PASSKEY_ENTRY";
+                case NUMERIC_COMPARISON:
+                    return "NUMERIC_COMPARISON";
+                default:
+                    return "JUST_WORKS";
+            }
+        }
+
+        // Legacy pairing and Secure Connections are told apart by the method
+        // and by the encryption of the link; they cannot be for a just works
+        // pairing when both are supported.
+        const char* pairingType() const {
+            bool secureConnections = false;
+            sm().getSecureConnectionsSupport(&secureConnections);
+
+            if (!secureConnections) {
+                return "LEGACY";
+            }
+            if (_method == NUMERIC_COMPARISON ||
+                _encryption == ble::link_encryption_t::ENCRYPTED_WITH_SC_AND_MITM) {
+                return "SECURE_CONNECTIONS";
+            }
+            if (_encryption == ble::link_encryption_t::ENCRYPTED_WITH_MITM) {
+                return "LEGACY";
+            }
+            return "UNKNOWN";
+        }
+
+        void reportResults() {
+            using namespace serialization;
+
+            response->success();
+            serialization::JSONOutputStream& os = response->getResultStream();
+
+            os << startObject <<
+                key("iterations") << _iterations <<
+                key("pairing_method") << pairingMethod() <<
+                key("pairing_type") << pairingType() <<
+                key("successes") << _successes <<
+                key("failures") << _failures <<
+                key("link_encryption") << _encryption <<
+                key("authentication") << _authentication <<
+                key("encryption") << _encryptionDuration <<
+                key("key_distribution") << _keyDistribution <<
+                key("total") << _total <<
+            endObject;
+        }
+
+        uint16_t _connectionHandle;
+        uint16_t _iterations;
+        uint16_t _iteration;
+        uint32_t _successes;
+        uint32_t _failures;
+        eq::EventQueue::event_handle_t _iterationHandle;
+        uint32_t _requestedAt;
+        uint32_t _encryptedAt;
+        bool _authenticated;
+        bool _encrypted;
+        method_t _method;
+        ble::link_encryption_t _encryption;
+        Measure _authentication;
+        Measure _encryptionDuration;
+        Measure _keyDistribution;
+        Measure _total;
+    };
+};
+
 } // end of anonymous namespace
 
+void SecurityManagerCommandSuiteDescription::reset() {
+    sm().setSecurityManagerEventHandler(NULL);
+    setPairingRequestAuthorisation(false);
+    autoPairingHandler().reset();
+}
+
 
 DECLARE_SUITE_COMMANDS(SecurityManagerCommandSuiteDescription,
     CMD_INSTANCE(InitCommand),
@@ -692,6 +1209,7 @@ DECLARE_SUITE_COMMANDS(SecurityManagerCommandSuiteDescription,
     CMD_INSTANCE(PreserveBondingStateOnResetCommand),
     CMD_INSTANCE(PurgeAllBondingStateCommand),
     CMD_INSTANCE(GenerateWhitelistFromBondTableCommand),
+    CMD_INSTANCE(BenchmarkBondTableCommand),
 
     // Pairing commands
     CMD_INSTANCE(SetPairingRequestAuthorisationCommand),
@@ -700,6 +1218,8 @@ DECLARE_SUITE_COMMANDS(SecurityManagerCommandSuiteDescription,
     CMD_INSTANCE(EnterConfirmationAndWaitCommand),
     CMD_INSTANCE(EnterPasskeyAndWaitCommand),
     CMD_INSTANCE(RequestPairingAndWaitCommand),
+    CMD_INSTANCE(SetAutoPairingCommand),
+    CMD_INSTANCE(BenchmarkPairingCommand),
 
     // Configuration commands
     CMD_INSTANCE(AllowLegacyPairingCommand),
@@ -32,6 +32,12 @@ public:
         return "securityManager <command> <command arguments>.";
     }
 
+    /**
+     * Stop the automatic pairing and require no authorisation of pairing
+     * requests. The ble instance must be initialized.
+     */
+    static void reset();
+
     static ConstArray<const Command*> commands();
 };
 
@@ -0,0 +1,67 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Measure.h"
+
+using namespace serialization;
+
+template<typename T, typename Sum>
+static JSONOutputStream& serializeMeasureFields(JSONOutputStream& os, const BasicMeasure<T, Sum>& measure) {
+    os << key("count") << measure.count;
+
+    if (measure.count) {
+        os << key("min") << measure.min <<
+            key("max") << measure.max <<
+            key("mean") << measure.mean() <<
+            key("stddev") << measure.stddev();
+    }
+
+    return os;
+}
+
+JSONOutputStream& operator<<(JSONOutputStream& os, const Measure& measure) {
+    os << startObject;
+    serializeMeasureFields(os, measure);
+    return os << endObject;
+}
+
+JSONOutputStream& operator<<(JSONOutputStream& os, const Int8Measure& measure) {
+    os << startObject;
+    serializeMeasureFields(os, measure);
+    return os << endObject;
+}
+
+JSONOutputStream& operator<<(JSONOutputStream& os, const Histogram& histogram) {
+    os << startObject;
+    serializeMeasureFields(os, histogram.measure);
+
+    if (histogram.measure.count) {
+        os << key("p50") << histogram.percentile(50) <<
+            key("p90") << histogram.percentile(90) <<
+            key("p99") << histogram.percentile(99);
+    }
+
+    os << key("buckets") << startArray;
+    for (uint8_t i = 0; i < Histogram::BUCKETS; ++i) {
+        if (!histogram.buckets[i]) {
+            continue;
+        }
+        os << startObject <<
+            key("upper_bound") << (uint32_t) ((2UL << i) - 1) <<
+            key("count") << histogram.buckets[i] <<
+        endObject;
+    }
+    os << endArray;
+
+    return os << endObject;
+}
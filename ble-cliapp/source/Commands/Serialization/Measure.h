@@ -0,0 +1,41 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_SERIALIZATION_MEASURE_H_
+#define BLE_CLIAPP_SERIALIZATION_MEASURE_H_
+
+#include "Serialization/JSONOutputStream.h"
+#include "Commands/util/Measure.h"
+
+/**
+ * @brief Serialize a measure as an object with the field count and, if
+ * count is not null, the fields min, max, mean and stddev.
+ */
+serialization::JSONOutputStream& operator<<(serialization::JSONOutputStream& os, const Measure& measure);
+
+/**
+ * @brief Serialize a measure of signed 8 bit values like a Measure.
+ */
+serialization::JSONOutputStream& operator<<(serialization::JSONOutputStream& os, const Int8Measure& measure);
+
+/**
+ * @brief Serialize an histogram as the object of its measure completed with
+ * the fields:
+ *     - "p50", "p90", "p99": Upper bound of the bucket containing the
+ *       percentile.
+ *     - "buckets": Array of the non empty buckets, each bucket is an object
+ *       with the field "upper_bound", in µs, and the field "count".
+ */
+serialization::JSONOutputStream& operator<<(serialization::JSONOutputStream& os, const Histogram& histogram);
+
+#endif //BLE_CLIAPP_SERIALIZATION_MEASURE_H_
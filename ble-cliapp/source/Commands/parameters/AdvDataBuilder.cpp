@@ -11,6 +11,9 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 #include "Serialization/BLECommonSerializer.h"
 #include "Serialization/GapSerializer.h"
 #include "Serialization/GapAdvertisingDataSerializer.h"
@@ -18,22 +21,200 @@
 #include "../Common.h"
 #include "CLICommand/CommandSuite.h"
 #include "CLICommand/CommandHelper.h"
+#include "util/HijackMember.h"
 
 #include "AdvDataBuilder.h"
 
+HIJACK_MEMBER(_payload_length_accessor, uint16_t ble::AdvertisingDataBuilder::*, &ble::AdvertisingDataBuilder::_payload_length);
+
 namespace {
 
-// global advertising data builder being modified
+// default advertising data builder
 constexpr static uint8_t max_payload_len = 255; // maximum for BLE 5
 static uint8_t adv_buffer[max_payload_len];
 static ble::AdvertisingDataBuilder adv_data_builder(adv_buffer);
 
+// maximum advertising data length of an extended advertising set
+constexpr static uint16_t max_set_payload_len = 1650;
+
+struct Builder {
+    uint8_t* buffer;
+    uint16_t capacity;
+    ble::AdvertisingDataBuilder* builder;
+};
+
+static Builder default_builder = { adv_buffer, max_payload_len, &adv_data_builder };
+
+// Builders of the advertising sets, created at their first selection. Their
+// buffer is sized from the maximum advertising data length of the controller.
+static Builder set_builders[ADV_DATA_BUILDER_MAX_SETS] = { };
+
+// builder modified by the commands of the suite
+static Builder* current_builder = &default_builder;
+
+static ble::AdvertisingDataBuilder& current() {
+    return *current_builder->builder;
+}
+
+static Builder* get_set_builder(ble::advertising_handle_t handle) {
+    if (handle >= ADV_DATA_BUILDER_MAX_SETS || handle >= gap().getMaxAdvertisingSetNumber()) {
+        return NULL;
+    }
+
+    Builder& set = set_builders[handle];
+    if (set.builder) {
+        return &set;
+    }
+
+    const uint16_t capacity = std::min<uint16_t>(gap().getMaxAdvertisingDataLength(), max_set_payload_len);
+    set.buffer = static_cast<uint8_t*>(malloc(capacity));
+    if (!set.buffer) {
+        return NULL;
+    }
+    set.capacity = capacity;
+    set.builder = new ble::AdvertisingDataBuilder(mbed::make_Span(set.buffer, capacity));
+    return &set;
+}
+
+static void release_set_builders() {
+    for (size_t i = 0; i < ADV_DATA_BUILDER_MAX_SETS; ++i) {
+        delete set_builders[i].builder;
+        free(set_builders[i].buffer);
+        set_builders[i] = Builder();
+    }
+    current_builder = &default_builder;
+}
+
+// check that the payload is a sequence of complete length-type-value elements
+static bool is_valid_payload(const uint8_t* payload, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+        const uint8_t length = payload[i];
+        if (length == 0 || (i + 1 + length) > size) {
+            return false;
+        }
+        i += 1 + length;
+    }
+    return true;
+}
+
+// check that offset is the start of an element of the payload or its end
+static bool is_element_boundary(const uint8_t* payload, size_t size, size_t offset) {
+    size_t i = 0;
+    while (i < offset && i < size) {
+        i += 1 + payload[i];
+    }
+    return i == offset;
+}
+
+DECLARE_CMD(SelectSet) {
+    CMD_NAME("selectSet")
+    CMD_HELP(
+        "Select the builder of an advertising set, the following commands of the "
+        "suite modify this builder. The builder is created at the first selection."
+    )
+    CMD_ARGS(
+        CMD_ARG("ble::advertising_handle_t", "handle", "Advertising set of the builder.")
+    )
+
+    CMD_HANDLER(ble::advertising_handle_t handle, CommandResponsePtr& response) {
+        Builder* builder = get_set_builder(handle);
+        if (!builder) {
+            response->faillure("Cannot create the builder of this advertising set");
+            return;
+        }
+        current_builder = builder;
+        response->success();
+    }
+};
+
+DECLARE_CMD(SelectDefault) {
+    CMD_NAME("selectDefault")
+    CMD_HELP("Select the default builder, its capacity is 255 bytes.")
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        current_builder = &default_builder;
+        response->success();
+    }
+};
+
+DECLARE_CMD(GetCapacity) {
+    CMD_NAME("getCapacity")
+    CMD_HELP("Return the capacity of the builder selected.")
+
+    CMD_HANDLER(CommandResponsePtr& response) {
+        response->success(current_builder->capacity);
+    }
+};
+
+DECLARE_CMD(SetPayload) {
+    CMD_NAME("setPayload")
+    CMD_HELP(
+        "Replace the payload of the builder selected from an offset, 0 by default. "
+        "The payload is a sequence of length-type-value elements and the offset "
+        "is the start or the end of an element of the current payload; large "
+        "payloads are written in chunks, each appended at the end of the previous one."
+    )
+    CMD_ARGS(
+        CMD_ARG("RawData_t", "payload", ""),
+        CMD_ARG("uint16_t", "offset", "Optional, position in the current payload of the first byte written.")
+    )
+
+    template<typename T>
+    static std::size_t maximumArgsRequired() {
+        return 2;
+    }
+
+    CMD_HANDLER(const CommandArgs& args, CommandResponsePtr& response) {
+        if (args.count() < 1 || args.count() > 2) {
+            response->invalidParameters("<payload> [<offset>] expected");
+            return;
+        }
+
+        RawData_t payload;
+        if (!fromString(args[0], payload)) {
+            response->invalidParameters("The payload is ill formed");
+            return;
+        }
+
+        uint16_t offset = 0;
+        if (args.count() == 2 && !fromString(args[1], offset)) {
+            response->invalidParameters("The offset is ill formed");
+            return;
+        }
+
+        const uint8_t* current_payload = current_builder->buffer;
+        const uint16_t current_length = current().getAdvertisingData().size();
+        if (!is_element_boundary(current_payload, current_length, offset)) {
+            response->invalidParameters("The offset is not at the boundary of an element");
+            return;
+        }
+
+        if ((offset + payload.size()) > current_builder->capacity) {
+            response->faillure(BLE_ERROR_BUFFER_OVERFLOW);
+            return;
+        }
+
+        if (!is_valid_payload(payload.cbegin(), payload.size())) {
+            response->invalidParameters("The payload is not a sequence of complete elements");
+            return;
+        }
+
+        if (offset == 0) {
+            current().clear();
+        }
+        memcpy(current_builder->buffer + offset, payload.cbegin(), payload.size());
+        current().*_payload_length_accessor = offset + payload.size();
+        response->success();
+    }
+};
+
 DECLARE_CMD(GetAdvertisingData) {
     CMD_NAME("getAdvertisingData")
 
     CMD_HANDLER(CommandResponsePtr& response) {
         // print raw advertising data bytes to serial
-        response->success(adv_data_builder.getAdvertisingData());
+        response->success(current().getAdvertisingData());
     }
 };
 
@@ -45,7 +226,7 @@ DECLARE_CMD(AddData) {
     )
 
     CMD_HANDLER(ble::adv_data_type_t::type type, RawData_t& data, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.addData(type, mbed::make_const_Span(data.cbegin(), data.size()));
+        ble_error_t err = current().addData(type, mbed::make_const_Span(data.cbegin(), data.size()));
         reportErrorOrSuccess(response, err);
     }
 };
@@ -58,7 +239,7 @@ DECLARE_CMD(AppendData) {
     )
 
     CMD_HANDLER(ble::adv_data_type_t::type type, RawData_t& data, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.appendData(type, mbed::make_const_Span(data.cbegin(), data.size()));
+        ble_error_t err = current().appendData(type, mbed::make_const_Span(data.cbegin(), data.size()));
         reportErrorOrSuccess(response, err);
     }
 };
@@ -70,7 +251,7 @@ DECLARE_CMD(RemoveData) {
     )
 
     CMD_HANDLER(ble::adv_data_type_t::type type, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.removeData(type);
+        ble_error_t err = current().removeData(type);
         reportErrorOrSuccess(response, err);
     }
 };
@@ -83,7 +264,7 @@ DECLARE_CMD(AddOrReplaceData) {
     )
 
     CMD_HANDLER(ble::adv_data_type_t::type type, RawData_t& data, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.addOrReplaceData(type, mbed::make_const_Span(data.cbegin(), data.size()));
+        ble_error_t err = current().addOrReplaceData(type, mbed::make_const_Span(data.cbegin(), data.size()));
         reportErrorOrSuccess(response, err);
     }
 };
@@ -96,7 +277,7 @@ DECLARE_CMD(AddOrAppendData) {
     )
 
     CMD_HANDLER(ble::adv_data_type_t::type type, RawData_t& data, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.addOrAppendData(type, mbed::make_const_Span(data.cbegin(), data.size()));
+        ble_error_t err = current().addOrAppendData(type, mbed::make_const_Span(data.cbegin(), data.size()));
         reportErrorOrSuccess(response, err);
     }
 };
@@ -104,7 +285,7 @@ DECLARE_CMD(AddOrAppendData) {
 DECLARE_CMD(Clear) {
     CMD_NAME("clear")
     CMD_HANDLER(CommandResponsePtr& response) {
-        adv_data_builder.clear();
+        current().clear();
         response->success();
     }
 };
@@ -116,7 +297,7 @@ DECLARE_CMD(SetAppearance) {
     )
 
     CMD_HANDLER(ble::adv_data_appearance_t::type appearance, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setAppearance(appearance);
+        ble_error_t err = current().setAppearance(appearance);
         reportErrorOrSuccess(response, err);
     }
 };
@@ -128,7 +309,7 @@ DECLARE_CMD(SetFlags) {
     )
 
     CMD_HANDLER(ble::adv_data_flags_t flags, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setFlags(flags);
+        ble_error_t err = current().setFlags(flags);
         reportErrorOrSuccess(response, err);
     }
 };
@@ -140,7 +321,7 @@ DECLARE_CMD(SetTxPowerAdvertised) {
     )
 
     CMD_HANDLER(int8_t txPower, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setTxPowerAdvertised(txPower);
+        ble_error_t err = current().setTxPowerAdvertised(txPower);
         reportErrorOrSuccess(response, err);
     }
 };
@@ -158,7 +339,7 @@ DECLARE_CMD(SetName) {
             response->invalidParameters("complete should be a bool");
             return;
         }
-        ble_error_t err = adv_data_builder.setName(args[0], complete);
+        ble_error_t err = current().setName(args[0], complete);
         reportErrorOrSuccess(response, err);
     }
 };
@@ -170,7 +351,7 @@ DECLARE_CMD(SetManufacturerSpecificData) {
     )
 
     CMD_HANDLER(RawData_t& data, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setManufacturerSpecificData(mbed::make_const_Span(data.cbegin(), data.size()));
+        ble_error_t err = current().setManufacturerSpecificData(mbed::make_const_Span(data.cbegin(), data.size()));
         reportErrorOrSuccess(response, err);
     }
 };
@@ -182,7 +363,7 @@ DECLARE_CMD(SetAdvertisingInterval) {
     )
 
     CMD_HANDLER(const uint32_t interval, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setAdvertisingInterval(ble::adv_interval_t(interval));
+        ble_error_t err = current().setAdvertisingInterval(ble::adv_interval_t(interval));
         reportErrorOrSuccess(response, err);
     }
 };
@@ -195,7 +376,7 @@ DECLARE_CMD(SetConnectionIntervalPreference) {
     )
 
     CMD_HANDLER(uint16_t min, uint16_t max, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setConnectionIntervalPreference(
+        ble_error_t err = current().setConnectionIntervalPreference(
             ble::conn_interval_t(min),
             ble::conn_interval_t(max)
         );
@@ -211,7 +392,7 @@ DECLARE_CMD(SetServiceData) {
     )
 
     CMD_HANDLER(UUID service, RawData_t& data, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setServiceData(
+        ble_error_t err = current().setServiceData(
             service,
             mbed::make_const_Span(data.cbegin(), data.size())
         );
@@ -228,7 +409,7 @@ DECLARE_CMD(SetLocalServiceList) {
 
     // The CLI app is only able to parse one UUID at a time
     CMD_HANDLER(UUID data, bool complete, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setLocalServiceList(
+        ble_error_t err = current().setLocalServiceList(
             mbed::make_const_Span(&data, 1),
             complete
         );
@@ -244,7 +425,7 @@ DECLARE_CMD(SetRequestedServiceList) {
 
     // The CLI app is only able to parse one UUID at a time
     CMD_HANDLER(UUID data, CommandResponsePtr& response) {
-        ble_error_t err = adv_data_builder.setRequestedServiceList(mbed::make_const_Span(&data, 1));
+        ble_error_t err = current().setRequestedServiceList(mbed::make_const_Span(&data, 1));
         reportErrorOrSuccess(response, err);
     }
 };
@@ -252,6 +433,10 @@ DECLARE_CMD(SetRequestedServiceList) {
 }
 
 DECLARE_SUITE_COMMANDS(AdvertisingDataBuilderCommandSuiteDescription,
+    CMD_INSTANCE(SelectSet),
+    CMD_INSTANCE(SelectDefault),
+    CMD_INSTANCE(GetCapacity),
+    CMD_INSTANCE(SetPayload),
     CMD_INSTANCE(GetAdvertisingData),
     CMD_INSTANCE(AddData),
     CMD_INSTANCE(AppendData),
@@ -273,5 +458,22 @@ DECLARE_SUITE_COMMANDS(AdvertisingDataBuilderCommandSuiteDescription,
 
 const mbed::Span<const uint8_t> AdvertisingDataBuilderCommandSuiteDescription::get()
 {
-    return adv_data_builder.getAdvertisingData();
+    return current().getAdvertisingData();
+}
+
+bool AdvertisingDataBuilderCommandSuiteDescription::getForSet(
+    ble::advertising_handle_t handle,
+    mbed::Span<const uint8_t>& payload
+) {
+    if (handle >= ADV_DATA_BUILDER_MAX_SETS || !set_builders[handle].builder) {
+        return false;
+    }
+    payload = set_builders[handle].builder->getAdvertisingData();
+    return true;
+}
+
+void AdvertisingDataBuilderCommandSuiteDescription::reset()
+{
+    release_set_builders();
+    adv_data_builder.clear();
 }
@@ -17,6 +17,10 @@
 #include "CLICommand/CommandSuite.h"
 #include "ble/gap/AdvertisingDataBuilder.h"
 
+#ifndef ADV_DATA_BUILDER_MAX_SETS
+#define ADV_DATA_BUILDER_MAX_SETS 16
+#endif
+
 class AdvertisingDataBuilderCommandSuiteDescription {
 
 public:
@@ -32,8 +36,22 @@ public:
         return "advDataBuilder <command> <command arguments>.";
     }
 
+    /**
+     * Return the payload of the builder selected: the default builder unless
+     * selectSet has been called since the last selectDefault or reset.
+     * This is the payload applied by applyAdvPayloadFromBuilder and
+     * applyScanRespFromBuilder.
+     */
     static const mbed::Span<const uint8_t> get();
 
+    /**
+     * Get the payload of the builder of an advertising set.
+     * @return false if the advertising set has no builder.
+     */
+    static bool getForSet(ble::advertising_handle_t handle, mbed::Span<const uint8_t>& payload);
+
+    static void reset();
+
     // see implementation
     static ConstArray<const Command*> commands();
 };
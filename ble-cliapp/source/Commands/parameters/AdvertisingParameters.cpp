@@ -192,3 +192,7 @@ DECLARE_SUITE_COMMANDS(AdvertisingParametersCommandSuiteDescription,
 const ble::AdvertisingParameters& AdvertisingParametersCommandSuiteDescription::get() {
     return parameters;
 }
+
+void AdvertisingParametersCommandSuiteDescription::reset() {
+    parameters = ble::AdvertisingParameters();
+}
@@ -143,3 +143,7 @@ const ble::ConnectionParameters& ConnectionParametersCommandSuiteDescription::ge
 }
 
 
+
+void ConnectionParametersCommandSuiteDescription::reset() {
+    parameters = ble::ConnectionParameters();
+}
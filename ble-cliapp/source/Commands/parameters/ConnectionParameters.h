@@ -34,6 +34,8 @@ public:
 
     static const ble::ConnectionParameters& get();
 
+    static void reset();
+
     // see implementation
     static ConstArray<const Command*> commands();
 };
@@ -107,3 +107,7 @@ DECLARE_SUITE_COMMANDS(ScanParametersCommandSuiteDescription,
 const ble::ScanParameters& ScanParametersCommandSuiteDescription::get() {
     return parameters;
 }
+
+void ScanParametersCommandSuiteDescription::reset() {
+    parameters = ble::ScanParameters();
+}
@@ -0,0 +1,246 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>
+#include "ConnectionStatistics.h"
+#include "Commands/Common.h"
+
+ConnectionStatistics::Record::Record() :
+    used(false),
+    connected(false),
+    handle(0),
+    role(ble::connection_role_t::CENTRAL),
+    peer_address_type(ble::peer_address_type_t::PUBLIC),
+    peer_address(),
+    connected_at(0),
+    disconnected_at(0),
+    interval(),
+    latency(0),
+    supervision_timeout(),
+    tx_phy(ble::phy_t::LE_1M),
+    rx_phy(ble::phy_t::LE_1M),
+    // default ATT_MTU of a connection
+    att_mtu(23),
+    connection_parameters_updates(0),
+    phy_updates(0),
+    att_bytes_in(0),
+    att_bytes_out(0),
+    disconnection_reason(ble::disconnection_reason_t::REMOTE_USER_TERMINATED_CONNECTION)
+{
+}
+
+ConnectionStatistics::ConnectionStatistics() :
+    dropped(0), gattCallbacksRegistered(false)
+{
+    clock.start();
+}
+
+uint32_t ConnectionStatistics::now() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(clock.elapsed_time()).count();
+}
+
+void ConnectionStatistics::clear()
+{
+    for (size_t i = 0; i < CONNECTION_STATISTICS_MAX_RECORDS; ++i) {
+        records[i] = Record();
+    }
+    dropped = 0;
+}
+
+void ConnectionStatistics::onConnectionComplete(const ble::ConnectionCompleteEvent &event)
+{
+    if (event.getStatus() != BLE_ERROR_NONE) {
+        return;
+    }
+
+    registerGattCallbacks();
+
+    Record* record = allocate();
+    if (!record) {
+        ++dropped;
+        return;
+    }
+
+    *record = Record();
+    record->used = true;
+    record->connected = true;
+    record->handle = event.getConnectionHandle();
+    record->role = event.getOwnRole();
+    record->peer_address_type = event.getPeerAddressType();
+    record->peer_address = event.getPeerAddress();
+    record->connected_at = now();
+    record->interval = event.getConnectionInterval();
+    record->latency = event.getConnectionLatency().value();
+    record->supervision_timeout = event.getSupervisionTimeout();
+}
+
+void ConnectionStatistics::onConnectionParametersUpdateComplete(
+    const ble::ConnectionParametersUpdateCompleteEvent &event
+) {
+    Record* record = find(event.getConnectionHandle());
+    if (!record || event.getStatus() != BLE_ERROR_NONE) {
+        return;
+    }
+
+    record->interval = event.getConnectionInterval();
+    record->latency = event.getSlaveLatency().value();
+    record->supervision_timeout = event.getSupervisionTimeout();
+    ++record->connection_parameters_updates;
+}
+
+void ConnectionStatistics::onReadPhy(
+    ble_error_t status,
+    ble::connection_handle_t connectionHandle,
+    ble::phy_t txPhy,
+    ble::phy_t rxPhy
+) {
+    Record* record = find(connectionHandle);
+    if (!record || status != BLE_ERROR_NONE) {
+        return;
+    }
+
+    record->tx_phy = txPhy;
+    record->rx_phy = rxPhy;
+}
+
+void ConnectionStatistics::onPhyUpdateComplete(
+    ble_error_t status,
+    ble::connection_handle_t connectionHandle,
+    ble::phy_t txPhy,
+    ble::phy_t rxPhy
+) {
+    Record* record = find(connectionHandle);
+    if (!record || status != BLE_ERROR_NONE) {
+        return;
+    }
+
+    record->tx_phy = txPhy;
+    record->rx_phy = rxPhy;
+    ++record->phy_updates;
+}
+
+void ConnectionStatistics::onAttMtuChange(ble::connection_handle_t connectionHandle, uint16_t attMtuSize)
+{
+    Record* record = find(connectionHandle);
+    if (record) {
+        record->att_mtu = attMtuSize;
+    }
+}
+
+void ConnectionStatistics::onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event)
+{
+    Record* record = find(event.getConnectionHandle());
+    if (!record) {
+        return;
+    }
+
+    record->connected = false;
+    record->disconnected_at = now();
+    record->disconnection_reason = event.getReason();
+}
+
+const ConnectionStatistics::Record* ConnectionStatistics::get(ble::connection_handle_t handle) const
+{
+    return const_cast<ConnectionStatistics*>(this)->find(handle);
+}
+
+ConnectionStatistics::Record* ConnectionStatistics::find(ble::connection_handle_t handle)
+{
+    // handles are reused by the stack, only live connections are matched
+    for (size_t i = 0; i < CONNECTION_STATISTICS_MAX_RECORDS; ++i) {
+        if (records[i].connected && records[i].handle == handle) {
+            return &records[i];
+        }
+    }
+    return NULL;
+}
+
+ConnectionStatistics::Record* ConnectionStatistics::allocate()
+{
+    Record* oldest = NULL;
+    for (size_t i = 0; i < CONNECTION_STATISTICS_MAX_RECORDS; ++i) {
+        Record& record = records[i];
+        if (!record.used) {
+            return &record;
+        }
+
+        if (!record.connected &&
+            (!oldest || record.disconnected_at < oldest->disconnected_at)) {
+            oldest = &record;
+        }
+    }
+    return oldest;
+}
+
+void ConnectionStatistics::registerGattCallbacks()
+{
+    if (gattCallbacksRegistered) {
+        return;
+    }
+
+    client().onDataRead(makeFunctionPointer(this, &ConnectionStatistics::whenClientDataRead));
+    client().onDataWritten(makeFunctionPointer(this, &ConnectionStatistics::whenClientDataWritten));
+    client().onHVX().add(makeFunctionPointer(this, &ConnectionStatistics::whenClientHVX));
+    gattServer().onDataWritten(this, &ConnectionStatistics::whenServerDataWritten);
+    gattServer().onShutdown(this, &ConnectionStatistics::whenShutdown);
+    // share the GattServer event handler with the rest of the application
+    if (gattServerEventHandlers().addEventHandler(this) == BLE_ERROR_NONE) {
+        gattServer().setEventHandler(&gattServerEventHandlers());
+    }
+    gattCallbacksRegistered = true;
+}
+
+void ConnectionStatistics::whenShutdown(const ble::GattServer*)
+{
+    client().onDataRead().detach(makeFunctionPointer(this, &ConnectionStatistics::whenClientDataRead));
+    client().onDataWritten().detach(makeFunctionPointer(this, &ConnectionStatistics::whenClientDataWritten));
+    client().onHVX().detach(makeFunctionPointer(this, &ConnectionStatistics::whenClientHVX));
+    gattServer().onDataWritten().detach(makeFunctionPointer(this, &ConnectionStatistics::whenServerDataWritten));
+    gattServer().onShutdown().detach(makeFunctionPointer(this, &ConnectionStatistics::whenShutdown));
+    gattServerEventHandlers().removeEventHandler(this);
+    gattCallbacksRegistered = false;
+    clear();
+}
+
+void ConnectionStatistics::whenClientDataRead(const GattReadCallbackParams* params)
+{
+    Record* record = find(params->connHandle);
+    if (record && params->status == BLE_ERROR_NONE) {
+        record->att_bytes_in += params->len;
+    }
+}
+
+void ConnectionStatistics::whenClientDataWritten(const GattWriteCallbackParams* params)
+{
+    Record* record = find(params->connHandle);
+    if (record && params->status == BLE_ERROR_NONE) {
+        record->att_bytes_out += params->len;
+    }
+}
+
+void ConnectionStatistics::whenClientHVX(const GattHVXCallbackParams* params)
+{
+    Record* record = find(params->connHandle);
+    if (record) {
+        record->att_bytes_in += params->len;
+    }
+}
+
+void ConnectionStatistics::whenServerDataWritten(const GattWriteCallbackParams* params)
+{
+    Record* record = find(params->connHandle);
+    if (record) {
+        record->att_bytes_in += params->len;
+    }
+}
@@ -0,0 +1,160 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_CONNECTION_STATISTICS_H_
+#define BLE_CLIAPP_UTIL_CONNECTION_STATISTICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ble/Gap.h"
+#include "ble/GattServer.h"
+#include "ble/gatt/GattCallbackParamTypes.h"
+#include "Timer.h"
+
+#ifndef CONNECTION_STATISTICS_MAX_RECORDS
+#define CONNECTION_STATISTICS_MAX_RECORDS 8
+#endif
+
+/**
+ * @brief Live statistics of the connections of the device.
+ * @details Records are stored in a fixed size table keyed by connection
+ * handle. The record of a connection is kept after the disconnection, until
+ * its slot is needed by a new connection, so the reason of the disconnection
+ * can be queried.
+ *
+ * Gap events are received as a subscriber of the Gap event dispatcher while
+ * ATT traffic and ATT_MTU changes are tracked from GattClient and GattServer
+ * callbacks registered at the first connection; ATT_MTU changes come through
+ * the chain of GattServer event handlers (gattServerEventHandlers()). The table is cleared when the ble instance is
+ * shutdown.
+ */
+class ConnectionStatistics :
+    public ble::Gap::EventHandler,
+    public ble::GattServer::EventHandler {
+public:
+    struct Record {
+        Record();
+
+        bool used;
+        bool connected;
+        ble::connection_handle_t handle;
+        ble::connection_role_t role;
+        ble::peer_address_type_t peer_address_type;
+        ble::address_t peer_address;
+        // time in ms since the start of the statistics
+        uint32_t connected_at;
+        uint32_t disconnected_at;
+        ble::conn_interval_t interval;
+        uint16_t latency;
+        ble::supervision_timeout_t supervision_timeout;
+        ble::phy_t tx_phy;
+        ble::phy_t rx_phy;
+        uint16_t att_mtu;
+        uint16_t connection_parameters_updates;
+        uint16_t phy_updates;
+        uint32_t att_bytes_in;
+        uint32_t att_bytes_out;
+        ble::disconnection_reason_t disconnection_reason;
+    };
+
+    ConnectionStatistics();
+
+    /**
+     * @brief Number of slots in the table.
+     */
+    size_t capacity() const {
+        return CONNECTION_STATISTICS_MAX_RECORDS;
+    }
+
+    /**
+     * @brief Access a slot of the table, check Record::used before reading
+     * the other fields.
+     */
+    const Record& operator[](size_t index) const {
+        return records[index];
+    }
+
+    /**
+     * @brief Number of connections which could not be recorded because all
+     * the slots were used by live connections.
+     */
+    uint32_t getDroppedCount() const {
+        return dropped;
+    }
+
+    /**
+     * @brief Get the record of a live connection.
+     * @return The record of the connection or NULL if the connection is not
+     * recorded.
+     */
+    const Record* get(ble::connection_handle_t handle) const;
+
+    /**
+     * @brief Current time, in ms, on the clock of the records.
+     */
+    uint32_t now() const;
+
+    /**
+     * @brief Clear all the records.
+     */
+    void clear();
+
+    // ble::Gap::EventHandler implementation
+
+    void onConnectionComplete(const ble::ConnectionCompleteEvent &event) override;
+
+    void onConnectionParametersUpdateComplete(
+        const ble::ConnectionParametersUpdateCompleteEvent &event
+    ) override;
+
+    void onReadPhy(
+        ble_error_t status,
+        ble::connection_handle_t connectionHandle,
+        ble::phy_t txPhy,
+        ble::phy_t rxPhy
+    ) override;
+
+    void onPhyUpdateComplete(
+        ble_error_t status,
+        ble::connection_handle_t connectionHandle,
+        ble::phy_t txPhy,
+        ble::phy_t rxPhy
+    ) override;
+
+    void onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event) override;
+
+    // ble::GattServer::EventHandler implementation
+
+    void onAttMtuChange(ble::connection_handle_t connectionHandle, uint16_t attMtuSize) override;
+
+private:
+    ConnectionStatistics(const ConnectionStatistics&);
+    ConnectionStatistics& operator=(const ConnectionStatistics&);
+
+    Record* find(ble::connection_handle_t handle);
+    Record* allocate();
+
+    void registerGattCallbacks();
+    void whenShutdown(const ble::GattServer*);
+    void whenClientDataRead(const GattReadCallbackParams* params);
+    void whenClientDataWritten(const GattWriteCallbackParams* params);
+    void whenClientHVX(const GattHVXCallbackParams* params);
+    void whenServerDataWritten(const GattWriteCallbackParams* params);
+
+    Record records[CONNECTION_STATISTICS_MAX_RECORDS];
+    uint32_t dropped;
+    bool gattCallbacksRegistered;
+    mbed::Timer clock;
+};
+
+#endif //BLE_CLIAPP_UTIL_CONNECTION_STATISTICS_H_
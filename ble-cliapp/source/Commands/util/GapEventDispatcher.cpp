@@ -0,0 +1,231 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "GapEventDispatcher.h"
+
+GapEventDispatcher::GapEventDispatcher() :
+    free_head(0), default_handler(NULL)
+{
+    for (subscription_t i = 0; i < GAP_EVENT_DISPATCHER_MAX_SUBSCRIBERS; ++i) {
+        slots[i].handler = NULL;
+        slots[i].events = 0;
+        slots[i].mode = OBSERVE;
+        next_free[i] = (i + 1 < GAP_EVENT_DISPATCHER_MAX_SUBSCRIBERS) ? i + 1 : INVALID_SUBSCRIPTION;
+    }
+
+    for (size_t i = 0; i < EVENT_COUNT; ++i) {
+        capture_count[i] = 0;
+    }
+}
+
+void GapEventDispatcher::setDefaultHandler(ble::Gap::EventHandler* handler)
+{
+    default_handler = handler;
+}
+
+GapEventDispatcher::subscription_t GapEventDispatcher::subscribe(
+    ble::Gap::EventHandler* handler,
+    event_mask_t events,
+    mode_t mode
+) {
+    if (free_head == INVALID_SUBSCRIPTION || handler == NULL) {
+        return INVALID_SUBSCRIPTION;
+    }
+
+    subscription_t subscription = free_head;
+    free_head = next_free[subscription];
+
+    Slot& slot = slots[subscription];
+    slot.handler = handler;
+    slot.events = events;
+    slot.mode = mode;
+
+    if (mode == CAPTURE) {
+        for (size_t i = 0; i < EVENT_COUNT; ++i) {
+            if (events & mask((event_t) i)) {
+                ++capture_count[i];
+            }
+        }
+    }
+
+    return subscription;
+}
+
+void GapEventDispatcher::unsubscribe(subscription_t subscription)
+{
+    if (subscription < 0 || subscription >= GAP_EVENT_DISPATCHER_MAX_SUBSCRIBERS) {
+        return;
+    }
+
+    Slot& slot = slots[subscription];
+    if (slot.handler == NULL) {
+        return;
+    }
+
+    if (slot.mode == CAPTURE) {
+        for (size_t i = 0; i < EVENT_COUNT; ++i) {
+            if (slot.events & mask((event_t) i)) {
+                --capture_count[i];
+            }
+        }
+    }
+
+    slot.handler = NULL;
+    slot.events = 0;
+    next_free[subscription] = free_head;
+    free_head = subscription;
+}
+
+template<typename Fn>
+void GapEventDispatcher::dispatch(event_t event, Fn fn)
+{
+    if (capture_count[event] == 0 && default_handler) {
+        fn(default_handler);
+    }
+
+    // The slot is read at each iteration: a handler may release its own
+    // subscription or another one while the event is dispatched.
+    for (subscription_t i = 0; i < GAP_EVENT_DISPATCHER_MAX_SUBSCRIBERS; ++i) {
+        if (slots[i].handler && (slots[i].events & mask(event))) {
+            fn(slots[i].handler);
+        }
+    }
+}
+
+void GapEventDispatcher::onScanRequestReceived(const ble::ScanRequestEvent &event)
+{
+    dispatch(SCAN_REQUEST_RECEIVED, [&](ble::Gap::EventHandler* handler) {
+        handler->onScanRequestReceived(event);
+    });
+}
+
+void GapEventDispatcher::onAdvertisingStart(const ble::AdvertisingStartEvent &event)
+{
+    dispatch(ADVERTISING_START, [&](ble::Gap::EventHandler* handler) {
+        handler->onAdvertisingStart(event);
+    });
+}
+
+void GapEventDispatcher::onAdvertisingEnd(const ble::AdvertisingEndEvent &event)
+{
+    dispatch(ADVERTISING_END, [&](ble::Gap::EventHandler* handler) {
+        handler->onAdvertisingEnd(event);
+    });
+}
+
+void GapEventDispatcher::onAdvertisingReport(const ble::AdvertisingReportEvent &event)
+{
+    dispatch(ADVERTISING_REPORT, [&](ble::Gap::EventHandler* handler) {
+        handler->onAdvertisingReport(event);
+    });
+}
+
+void GapEventDispatcher::onScanTimeout(const ble::ScanTimeoutEvent &event)
+{
+    dispatch(SCAN_TIMEOUT, [&](ble::Gap::EventHandler* handler) {
+        handler->onScanTimeout(event);
+    });
+}
+
+void GapEventDispatcher::onPeriodicAdvertisingSyncEstablished(
+    const ble::PeriodicAdvertisingSyncEstablishedEvent &event
+) {
+    dispatch(PERIODIC_ADVERTISING_SYNC_ESTABLISHED, [&](ble::Gap::EventHandler* handler) {
+        handler->onPeriodicAdvertisingSyncEstablished(event);
+    });
+}
+
+void GapEventDispatcher::onPeriodicAdvertisingReport(
+    const ble::PeriodicAdvertisingReportEvent &event
+) {
+    dispatch(PERIODIC_ADVERTISING_REPORT, [&](ble::Gap::EventHandler* handler) {
+        handler->onPeriodicAdvertisingReport(event);
+    });
+}
+
+void GapEventDispatcher::onPeriodicAdvertisingSyncLoss(
+    const ble::PeriodicAdvertisingSyncLoss &event
+) {
+    dispatch(PERIODIC_ADVERTISING_SYNC_LOSS, [&](ble::Gap::EventHandler* handler) {
+        handler->onPeriodicAdvertisingSyncLoss(event);
+    });
+}
+
+void GapEventDispatcher::onConnectionComplete(const ble::ConnectionCompleteEvent &event)
+{
+    dispatch(CONNECTION_COMPLETE, [&](ble::Gap::EventHandler* handler) {
+        handler->onConnectionComplete(event);
+    });
+}
+
+void GapEventDispatcher::onUpdateConnectionParametersRequest(
+    const ble::UpdateConnectionParametersRequestEvent &event
+) {
+    dispatch(UPDATE_CONNECTION_PARAMETERS_REQUEST, [&](ble::Gap::EventHandler* handler) {
+        handler->onUpdateConnectionParametersRequest(event);
+    });
+}
+
+void GapEventDispatcher::onConnectionParametersUpdateComplete(
+    const ble::ConnectionParametersUpdateCompleteEvent &event
+) {
+    dispatch(CONNECTION_PARAMETERS_UPDATE_COMPLETE, [&](ble::Gap::EventHandler* handler) {
+        handler->onConnectionParametersUpdateComplete(event);
+    });
+}
+
+void GapEventDispatcher::onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event)
+{
+    dispatch(DISCONNECTION_COMPLETE, [&](ble::Gap::EventHandler* handler) {
+        handler->onDisconnectionComplete(event);
+    });
+}
+
+void GapEventDispatcher::onReadPhy(
+    ble_error_t status,
+    ble::connection_handle_t connectionHandle,
+    ble::phy_t txPhy,
+    ble::phy_t rxPhy
+) {
+    dispatch(READ_PHY, [&](ble::Gap::EventHandler* handler) {
+        handler->onReadPhy(status, connectionHandle, txPhy, rxPhy);
+    });
+}
+
+void GapEventDispatcher::onPhyUpdateComplete(
+    ble_error_t status,
+    ble::connection_handle_t connectionHandle,
+    ble::phy_t txPhy,
+    ble::phy_t rxPhy
+) {
+    dispatch(PHY_UPDATE_COMPLETE, [&](ble::Gap::EventHandler* handler) {
+        handler->onPhyUpdateComplete(status, connectionHandle, txPhy, rxPhy);
+    });
+}
+
+void GapEventDispatcher::onDataLengthChange(
+    ble::connection_handle_t connectionHandle,
+    uint16_t txNumberOfBytes,
+    uint16_t rxNumberOfBytes
+) {
+    dispatch(DATA_LENGTH_CHANGE, [&](ble::Gap::EventHandler* handler) {
+        handler->onDataLengthChange(connectionHandle, txNumberOfBytes, rxNumberOfBytes);
+    });
+}
+
+void GapEventDispatcher::onPrivacyEnabled()
+{
+    dispatch(PRIVACY_ENABLED, [&](ble::Gap::EventHandler* handler) {
+        handler->onPrivacyEnabled();
+    });
+}
@@ -0,0 +1,200 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_GAP_EVENT_DISPATCHER_H_
+#define BLE_CLIAPP_UTIL_GAP_EVENT_DISPATCHER_H_
+
+#include <stdint.h>
+#include "ble/Gap.h"
+
+#ifndef GAP_EVENT_DISPATCHER_MAX_SUBSCRIBERS
+#define GAP_EVENT_DISPATCHER_MAX_SUBSCRIBERS 8
+#endif
+
+/**
+ * @brief Gap event handler which fans out events to several handlers.
+ * @details The dispatcher is installed once as the Gap event handler.
+ * Handlers subscribe to the event types they are interested in and are stored
+ * in a fixed slot table; subscribe and unsubscribe do not allocate and run in
+ * constant time.
+ *
+ * A subscription either captures or observes its events. An event type
+ * captured by at least one subscription is not forwarded to the default
+ * handler; this is how a procedure silences the default output of the events
+ * it consumes.
+ *
+ * A subscriber can unsubscribe while an event is dispatched, including from
+ * the handler of that event.
+ */
+class GapEventDispatcher : public ble::Gap::EventHandler {
+public:
+    /**
+     * @brief Type of the events which can be subscribed.
+     */
+    enum event_t {
+        SCAN_REQUEST_RECEIVED,
+        ADVERTISING_START,
+        ADVERTISING_END,
+        ADVERTISING_REPORT,
+        SCAN_TIMEOUT,
+        PERIODIC_ADVERTISING_SYNC_ESTABLISHED,
+        PERIODIC_ADVERTISING_REPORT,
+        PERIODIC_ADVERTISING_SYNC_LOSS,
+        CONNECTION_COMPLETE,
+        UPDATE_CONNECTION_PARAMETERS_REQUEST,
+        CONNECTION_PARAMETERS_UPDATE_COMPLETE,
+        DISCONNECTION_COMPLETE,
+        READ_PHY,
+        PHY_UPDATE_COMPLETE,
+        DATA_LENGTH_CHANGE,
+        PRIVACY_ENABLED,
+        EVENT_COUNT
+    };
+
+    typedef uint32_t event_mask_t;
+
+    /**
+     * @brief Way a subscription receives its events.
+     */
+    enum mode_t {
+        CAPTURE,
+        OBSERVE
+    };
+
+    /**
+     * @brief Identifier of a subscription.
+     */
+    typedef int8_t subscription_t;
+
+    static const subscription_t INVALID_SUBSCRIPTION = -1;
+
+    /**
+     * @brief Return the mask of a single event type.
+     */
+    static event_mask_t mask(event_t event) {
+        return 1 << event;
+    }
+
+    GapEventDispatcher();
+
+    /**
+     * @brief Set the handler receiving the events not captured by a
+     * subscription.
+     */
+    void setDefaultHandler(ble::Gap::EventHandler* handler);
+
+    /**
+     * @brief Subscribe a handler to a set of events.
+     * @param handler The handler to forward the events to.
+     * @param events Mask of the events to forward.
+     * @param mode Capture or observe the events.
+     * @return The subscription or INVALID_SUBSCRIPTION if all the slots are
+     * in use.
+     */
+    subscription_t subscribe(
+        ble::Gap::EventHandler* handler,
+        event_mask_t events,
+        mode_t mode = CAPTURE
+    );
+
+    /**
+     * @brief Release a subscription. Releasing INVALID_SUBSCRIPTION has no
+     * effect.
+     */
+    void unsubscribe(subscription_t subscription);
+
+    // ble::Gap::EventHandler implementation
+
+    void onScanRequestReceived(const ble::ScanRequestEvent &event) override;
+
+    void onAdvertisingStart(const ble::AdvertisingStartEvent &event) override;
+
+    void onAdvertisingEnd(const ble::AdvertisingEndEvent &event) override;
+
+    void onAdvertisingReport(const ble::AdvertisingReportEvent &event) override;
+
+    void onScanTimeout(const ble::ScanTimeoutEvent &event) override;
+
+    void onPeriodicAdvertisingSyncEstablished(
+        const ble::PeriodicAdvertisingSyncEstablishedEvent &event
+    ) override;
+
+    void onPeriodicAdvertisingReport(
+        const ble::PeriodicAdvertisingReportEvent &event
+    ) override;
+
+    void onPeriodicAdvertisingSyncLoss(
+        const ble::PeriodicAdvertisingSyncLoss &event
+    ) override;
+
+    void onConnectionComplete(const ble::ConnectionCompleteEvent &event) override;
+
+    void onUpdateConnectionParametersRequest(
+        const ble::UpdateConnectionParametersRequestEvent &event
+    ) override;
+
+    void onConnectionParametersUpdateComplete(
+        const ble::ConnectionParametersUpdateCompleteEvent &event
+    ) override;
+
+    void onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event) override;
+
+    void onReadPhy(
+        ble_error_t status,
+        ble::connection_handle_t connectionHandle,
+        ble::phy_t txPhy,
+        ble::phy_t rxPhy
+    ) override;
+
+    void onPhyUpdateComplete(
+        ble_error_t status,
+        ble::connection_handle_t connectionHandle,
+        ble::phy_t txPhy,
+        ble::phy_t rxPhy
+    ) override;
+
+    void onDataLengthChange(
+        ble::connection_handle_t connectionHandle,
+        uint16_t txNumberOfBytes,
+        uint16_t rxNumberOfBytes
+    ) override;
+
+    void onPrivacyEnabled() override;
+
+private:
+    GapEventDispatcher(const GapEventDispatcher&);
+    GapEventDispatcher& operator=(const GapEventDispatcher&);
+
+    struct Slot {
+        ble::Gap::EventHandler* handler;
+        event_mask_t events;
+        mode_t mode;
+    };
+
+    /*
+     * Call fn on the default handler if the event is not captured then on
+     * every handler subscribed to the event.
+     */
+    template<typename Fn>
+    void dispatch(event_t event, Fn fn);
+
+    Slot slots[GAP_EVENT_DISPATCHER_MAX_SUBSCRIBERS];
+    // next free slot for each free slot; the list starts at free_head
+    subscription_t next_free[GAP_EVENT_DISPATCHER_MAX_SUBSCRIBERS];
+    subscription_t free_head;
+    // number of capturing subscriptions for each event type
+    uint8_t capture_count[EVENT_COUNT];
+    ble::Gap::EventHandler* default_handler;
+};
+
+#endif //BLE_CLIAPP_UTIL_GAP_EVENT_DISPATCHER_H_
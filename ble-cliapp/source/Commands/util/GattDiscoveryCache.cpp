@@ -0,0 +1,368 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "GattDiscoveryCache.h"
+#include "Commands/Common.h"
+#include "Commands/GapCommands.h"
+
+// Length of the attribute handle and of the end group handle of a service in
+// a Read By Group Type response.
+static const uint8_t SERVICE_ENTRY_HEADER = 4;
+// Length of the attribute handle, properties and value handle of a
+// characteristic declaration in a Read By Type response.
+static const uint8_t CHARACTERISTIC_ENTRY_HEADER = 5;
+// Length of the attribute handle of a descriptor in a Find Information
+// response.
+static const uint8_t DESCRIPTOR_ENTRY_HEADER = 2;
+// Opcode and length (or format) field of Read By Type, Read By Group Type and
+// Find Information responses.
+static const uint8_t RESPONSE_HEADER = 2;
+
+static const uint16_t SERVICE_CHANGED_UUID = 0x2A05;
+
+// Value of the CCCD enabling indications.
+static const uint8_t INDICATION_ENABLED[] = { 0x02, 0x00 };
+
+AttRequestEstimator::AttRequestEstimator(uint16_t attMtu) :
+    _attMtu(attMtu), _serviceRequests(0), _characteristicRequests(0), _descriptorRequests(0),
+    _serviceLength(0), _servicesInResponse(0), _lastServiceEnd(0), _hasService(false),
+    _characteristicLength(0), _characteristicsInResponse(0), _lastValueHandle(0),
+    _descriptorLength(0), _descriptorsInResponse(0), _lastDescriptorHandle(0)
+{
+}
+
+void AttRequestEstimator::addService(const UUID& uuid, GattAttribute::Handle_t endHandle)
+{
+    if (_hasService) {
+        finishService();
+    }
+
+    const uint8_t length = SERVICE_ENTRY_HEADER + uuid.getLen();
+    const uint16_t capacity = (_attMtu - RESPONSE_HEADER) / length;
+
+    // a response only carries entries of the same length
+    if (length != _serviceLength || _servicesInResponse >= capacity) {
+        ++_serviceRequests;
+        _serviceLength = length;
+        _servicesInResponse = 0;
+    }
+    ++_servicesInResponse;
+
+    _lastServiceEnd = endHandle;
+    _hasService = true;
+    _characteristicLength = 0;
+    _characteristicsInResponse = 0;
+    _lastValueHandle = 0;
+}
+
+void AttRequestEstimator::addCharacteristic(const UUID& uuid, GattAttribute::Handle_t valueHandle)
+{
+    const uint8_t length = CHARACTERISTIC_ENTRY_HEADER + uuid.getLen();
+    const uint16_t capacity = (_attMtu - RESPONSE_HEADER) / length;
+
+    if (length != _characteristicLength || _characteristicsInResponse >= capacity) {
+        ++_characteristicRequests;
+        _characteristicLength = length;
+        _characteristicsInResponse = 0;
+    }
+    ++_characteristicsInResponse;
+    _lastValueHandle = valueHandle;
+}
+
+void AttRequestEstimator::addDescriptor(const UUID& uuid, GattAttribute::Handle_t handle)
+{
+    const uint8_t length = DESCRIPTOR_ENTRY_HEADER + uuid.getLen();
+    const uint16_t capacity = (_attMtu - RESPONSE_HEADER) / length;
+
+    // a Find Information response carries either 16 bit or 128 bit UUIDs
+    if (length != _descriptorLength || _descriptorsInResponse >= capacity) {
+        ++_descriptorRequests;
+        _descriptorLength = length;
+        _descriptorsInResponse = 0;
+    }
+    ++_descriptorsInResponse;
+    _lastDescriptorHandle = handle;
+}
+
+uint16_t AttRequestEstimator::finish(bool characteristics)
+{
+    if (_hasService && characteristics) {
+        finishService();
+    }
+
+    // the last request is answered by an error unless the last service ends
+    // the handle range
+    if (!_hasService || _lastServiceEnd != 0xFFFF) {
+        ++_serviceRequests;
+    }
+
+    _hasService = false;
+    return _serviceRequests + _characteristicRequests;
+}
+
+uint16_t AttRequestEstimator::finishDescriptors(GattAttribute::Handle_t endHandle)
+{
+    // the discovery ends with an error unless the last descriptor ends the
+    // characteristic
+    if (_lastDescriptorHandle == 0 || _lastDescriptorHandle < endHandle) {
+        ++_descriptorRequests;
+    }
+
+    _descriptorLength = 0;
+    _descriptorsInResponse = 0;
+    _lastDescriptorHandle = 0;
+    return _descriptorRequests;
+}
+
+void AttRequestEstimator::finishService()
+{
+    // the characteristics discovery of a service ends with an error unless
+    // the last value handle ends the service
+    if (_lastValueHandle == 0 || _lastValueHandle < _lastServiceEnd) {
+        ++_characteristicRequests;
+    }
+}
+
+GattDiscoveryCache::Entry::Entry() :
+    used(false),
+    recording(false),
+    overflow(false),
+    peer_address_type(ble::peer_address_type_t::PUBLIC),
+    peer_address(),
+    service_count(0),
+    characteristic_count(0),
+    service_changed_handle(0),
+    service_changed_cccd_handle(0),
+    service_changed_subscribed(false),
+    connection(0),
+    discovery_duration(0),
+    att_requests(0),
+    hits(0),
+    last_used(0)
+{
+}
+
+GattDiscoveryCache::GattDiscoveryCache() :
+    statistics(), clock(0), callbacksRegistered(false)
+{
+}
+
+const GattDiscoveryCache::Entry* GattDiscoveryCache::lookup(ble::connection_handle_t connection)
+{
+    Entry* entry = find(connection);
+    if (!entry) {
+        ++statistics.misses;
+        return NULL;
+    }
+
+    ++statistics.hits;
+    ++entry->hits;
+    entry->last_used = ++clock;
+    return entry;
+}
+
+GattDiscoveryCache::Entry* GattDiscoveryCache::startRecording(ble::connection_handle_t connection)
+{
+    const ConnectionStatistics::Record* record = GapCommandSuiteDescription::get_connection(connection);
+    if (!record) {
+        return NULL;
+    }
+
+    registerCallbacks();
+
+    // reuse the entry of the peer, then a free entry, then the least recently used
+    Entry* selected = NULL;
+    for (size_t i = 0; i < GATT_DISCOVERY_CACHE_MAX_PEERS; ++i) {
+        Entry& entry = entries[i];
+        if (entry.recording) {
+            continue;
+        }
+
+        if (entry.used &&
+            entry.peer_address_type == record->peer_address_type &&
+            entry.peer_address == record->peer_address) {
+            selected = &entry;
+            break;
+        }
+
+        if (!selected ||
+            (selected->used && (!entry.used || entry.last_used < selected->last_used))) {
+            selected = &entry;
+        }
+    }
+
+    if (!selected) {
+        return NULL;
+    }
+
+    *selected = Entry();
+    selected->recording = true;
+    selected->peer_address_type = record->peer_address_type;
+    selected->peer_address = record->peer_address;
+    selected->connection = connection;
+    return selected;
+}
+
+void GattDiscoveryCache::recordService(Entry* entry, const DiscoveredService* service)
+{
+    if (entry->overflow) {
+        return;
+    }
+
+    if (entry->service_count == GATT_DISCOVERY_CACHE_MAX_SERVICES) {
+        entry->overflow = true;
+        return;
+    }
+
+    Service& cached = entry->services[entry->service_count++];
+    cached.uuid = service->getUUID();
+    cached.start_handle = service->getStartHandle();
+    cached.end_handle = service->getEndHandle();
+    cached.characteristics_begin = entry->characteristic_count;
+    cached.characteristics_end = entry->characteristic_count;
+}
+
+void GattDiscoveryCache::recordCharacteristic(Entry* entry, const DiscoveredCharacteristic* characteristic)
+{
+    if (entry->overflow) {
+        return;
+    }
+
+    if (entry->service_count == 0 ||
+        entry->characteristic_count == GATT_DISCOVERY_CACHE_MAX_CHARACTERISTICS) {
+        entry->overflow = true;
+        return;
+    }
+
+    Characteristic& cached = entry->characteristics[entry->characteristic_count++];
+    cached.uuid = characteristic->getUUID();
+    cached.properties = characteristic->getProperties();
+    cached.decl_handle = characteristic->getDeclHandle();
+    cached.value_handle = characteristic->getValueHandle();
+    cached.last_handle = characteristic->getLastHandle();
+
+    // characteristics are reported after the service containing them
+    entry->services[entry->service_count - 1].characteristics_end = entry->characteristic_count;
+
+    if (cached.uuid == UUID(SERVICE_CHANGED_UUID)) {
+        entry->service_changed_handle = cached.value_handle;
+        // the CCCD is the only descriptor of the Service Changed characteristic
+        if (cached.last_handle > cached.value_handle) {
+            entry->service_changed_cccd_handle = cached.value_handle + 1;
+        }
+    }
+}
+
+void GattDiscoveryCache::endRecording(Entry* entry, bool success, uint32_t duration, uint16_t attRequests)
+{
+    entry->recording = false;
+    entry->used = success && !entry->overflow;
+    entry->discovery_duration = duration;
+    entry->att_requests = attRequests;
+    entry->last_used = ++clock;
+
+    if (entry->used) {
+        subscribeServiceChanged(entry);
+    }
+}
+
+size_t GattDiscoveryCache::flush()
+{
+    size_t count = 0;
+    for (size_t i = 0; i < GATT_DISCOVERY_CACHE_MAX_PEERS; ++i) {
+        if (entries[i].used) {
+            entries[i].used = false;
+            ++count;
+        }
+    }
+    statistics.invalidations += count;
+    return count;
+}
+
+void GattDiscoveryCache::reset()
+{
+    for (size_t i = 0; i < GATT_DISCOVERY_CACHE_MAX_PEERS; ++i) {
+        entries[i] = Entry();
+    }
+    statistics = Statistics();
+    clock = 0;
+}
+
+GattDiscoveryCache::Entry* GattDiscoveryCache::find(ble::connection_handle_t connection)
+{
+    const ConnectionStatistics::Record* record = GapCommandSuiteDescription::get_connection(connection);
+    if (!record) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < GATT_DISCOVERY_CACHE_MAX_PEERS; ++i) {
+        Entry& entry = entries[i];
+        if (entry.used &&
+            entry.peer_address_type == record->peer_address_type &&
+            entry.peer_address == record->peer_address) {
+            return &entry;
+        }
+    }
+    return NULL;
+}
+
+void GattDiscoveryCache::registerCallbacks()
+{
+    if (callbacksRegistered) {
+        return;
+    }
+
+    client().onHVX().add(makeFunctionPointer(this, &GattDiscoveryCache::whenHVX));
+    client().onShutdown(this, &GattDiscoveryCache::whenShutdown);
+    callbacksRegistered = true;
+}
+
+void GattDiscoveryCache::subscribeServiceChanged(Entry* entry)
+{
+    if (!entry->service_changed_cccd_handle) {
+        return;
+    }
+
+    // the write response is not awaited, write procedures of the application
+    // ignore it as they are bound to another handle
+    ble_error_t err = client().write(
+        GattClient::GATT_OP_WRITE_REQ,
+        entry->connection,
+        entry->service_changed_cccd_handle,
+        sizeof(INDICATION_ENABLED),
+        INDICATION_ENABLED
+    );
+    entry->service_changed_subscribed = (err == BLE_ERROR_NONE);
+}
+
+void GattDiscoveryCache::whenHVX(const GattHVXCallbackParams* params)
+{
+    if (params->type != BLE_HVX_INDICATION) {
+        return;
+    }
+
+    Entry* entry = find(params->connHandle);
+    if (entry && entry->service_changed_handle &&
+        params->handle == entry->service_changed_handle) {
+        entry->used = false;
+        ++statistics.invalidations;
+    }
+}
+
+void GattDiscoveryCache::whenShutdown(const ble::GattClient*)
+{
+    client().onHVX().detach(makeFunctionPointer(this, &GattDiscoveryCache::whenHVX));
+    client().onShutdown().detach(makeFunctionPointer(this, &GattDiscoveryCache::whenShutdown));
+    callbacksRegistered = false;
+    reset();
+}
@@ -0,0 +1,244 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_GATT_DISCOVERY_CACHE_H_
+#define BLE_CLIAPP_UTIL_GATT_DISCOVERY_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ble/Gap.h"
+#include "ble/GattClient.h"
+#include "ble/gatt/DiscoveredService.h"
+#include "ble/gatt/DiscoveredCharacteristic.h"
+
+#ifndef GATT_DISCOVERY_CACHE_MAX_PEERS
+#define GATT_DISCOVERY_CACHE_MAX_PEERS 2
+#endif
+
+#ifndef GATT_DISCOVERY_CACHE_MAX_SERVICES
+#define GATT_DISCOVERY_CACHE_MAX_SERVICES 12
+#endif
+
+#ifndef GATT_DISCOVERY_CACHE_MAX_CHARACTERISTICS
+#define GATT_DISCOVERY_CACHE_MAX_CHARACTERISTICS 32
+#endif
+
+/**
+ * @brief Estimation of the number of ATT requests issued by a discovery.
+ * @details The discovery procedures do not expose the ATT traffic. The number
+ * of requests is derived from the attributes discovered and the ATT_MTU: a
+ * response carries as many entries of the same length as the ATT_MTU allows
+ * and each procedure ends with a request answered by an error once the end of
+ * the handle range has not been reached.
+ *
+ * Services must be fed in handle order, each service followed by its
+ * characteristics. Descriptors of a characteristic are fed in handle order
+ * then closed by finishDescriptors().
+ */
+class AttRequestEstimator {
+public:
+    AttRequestEstimator(uint16_t attMtu);
+
+    void addService(const UUID& uuid, GattAttribute::Handle_t endHandle);
+
+    void addCharacteristic(const UUID& uuid, GattAttribute::Handle_t valueHandle);
+
+    void addDescriptor(const UUID& uuid, GattAttribute::Handle_t handle);
+
+    /**
+     * @brief Number of requests once the discovery has terminated.
+     * @param characteristics true if the characteristics have been discovered.
+     * @return The number of requests of the services and characteristics
+     * phases.
+     */
+    uint16_t finish(bool characteristics);
+
+    /**
+     * @brief Number of requests once the descriptors discovery of a
+     * characteristic has terminated.
+     * @param endHandle Last handle of the characteristic.
+     * @return The number of requests of the descriptors phase.
+     */
+    uint16_t finishDescriptors(GattAttribute::Handle_t endHandle);
+
+    uint16_t serviceRequests() const {
+        return _serviceRequests;
+    }
+
+    uint16_t characteristicRequests() const {
+        return _characteristicRequests;
+    }
+
+    uint16_t descriptorRequests() const {
+        return _descriptorRequests;
+    }
+
+private:
+    void finishService();
+
+    uint16_t _attMtu;
+    uint16_t _serviceRequests;
+    uint16_t _characteristicRequests;
+    uint16_t _descriptorRequests;
+
+    // response being filled by services
+    uint8_t _serviceLength;
+    uint8_t _servicesInResponse;
+    GattAttribute::Handle_t _lastServiceEnd;
+    bool _hasService;
+
+    // response being filled by the characteristics of the current service
+    uint8_t _characteristicLength;
+    uint8_t _characteristicsInResponse;
+    GattAttribute::Handle_t _lastValueHandle;
+
+    // response being filled by the descriptors of the current characteristic
+    uint8_t _descriptorLength;
+    uint8_t _descriptorsInResponse;
+    GattAttribute::Handle_t _lastDescriptorHandle;
+};
+
+/**
+ * @brief Bounded cache of the attribute database of peers.
+ * @details Entries are keyed by the identity address of the peer, they are
+ * recorded during the discovery of all services and characteristics and can
+ * be served to the next discoveries of the same peer, even across
+ * connections.
+ *
+ * An entry is invalidated when a Service Changed indication is received from
+ * the peer or when the cache is flushed. Indications of Service Changed are
+ * enabled on the peer once its entry is recorded. Entries of peers with more services
+ * or characteristics than the cache can hold are not kept. When the cache is
+ * full, the least recently used entry is replaced.
+ */
+class GattDiscoveryCache {
+public:
+    struct Service {
+        UUID uuid;
+        GattAttribute::Handle_t start_handle;
+        GattAttribute::Handle_t end_handle;
+        // range of the characteristics of the service in Entry::characteristics
+        uint8_t characteristics_begin;
+        uint8_t characteristics_end;
+    };
+
+    struct Characteristic {
+        UUID uuid;
+        DiscoveredCharacteristic::Properties_t properties;
+        GattAttribute::Handle_t decl_handle;
+        GattAttribute::Handle_t value_handle;
+        GattAttribute::Handle_t last_handle;
+    };
+
+    struct Entry {
+        Entry();
+
+        bool used;
+        bool recording;
+        bool overflow;
+        ble::peer_address_type_t peer_address_type;
+        ble::address_t peer_address;
+        uint8_t service_count;
+        uint8_t characteristic_count;
+        Service services[GATT_DISCOVERY_CACHE_MAX_SERVICES];
+        Characteristic characteristics[GATT_DISCOVERY_CACHE_MAX_CHARACTERISTICS];
+        // value handle of the Service Changed characteristic, 0 if absent
+        GattAttribute::Handle_t service_changed_handle;
+        // handle of the CCCD of the Service Changed characteristic, 0 if absent
+        GattAttribute::Handle_t service_changed_cccd_handle;
+        // true once indications of Service Changed have been requested
+        bool service_changed_subscribed;
+        // connection of the discovery recording the entry
+        ble::connection_handle_t connection;
+        // duration, in µs, of the discovery which has filled the entry
+        uint32_t discovery_duration;
+        uint16_t att_requests;
+        uint32_t hits;
+        uint32_t last_used;
+    };
+
+    struct Statistics {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t invalidations;
+    };
+
+    GattDiscoveryCache();
+
+    /**
+     * @brief Get the entry of the peer of a connection.
+     * @return The entry or NULL if the peer is not in the cache.
+     */
+    const Entry* lookup(ble::connection_handle_t connection);
+
+    /**
+     * @brief Start the recording of the discovery of the peer of a connection.
+     * @return The entry to record or NULL if the peer is unknown or if all the
+     * entries are being recorded.
+     */
+    Entry* startRecording(ble::connection_handle_t connection);
+
+    void recordService(Entry* entry, const DiscoveredService* service);
+
+    void recordCharacteristic(Entry* entry, const DiscoveredCharacteristic* characteristic);
+
+    /**
+     * @brief End the recording of an entry.
+     * @param entry The entry recorded.
+     * @param success true if the discovery has completed.
+     * @param duration Duration, in µs, of the discovery.
+     * @param attRequests Number of ATT requests of the discovery.
+     */
+    void endRecording(Entry* entry, bool success, uint32_t duration, uint16_t attRequests);
+
+    /**
+     * @brief Invalidate all the entries.
+     * @return The number of entries invalidated.
+     */
+    size_t flush();
+
+    /**
+     * @brief Clear the entries and the statistics.
+     */
+    void reset();
+
+    size_t capacity() const {
+        return GATT_DISCOVERY_CACHE_MAX_PEERS;
+    }
+
+    const Entry& operator[](size_t index) const {
+        return entries[index];
+    }
+
+    const Statistics& getStatistics() const {
+        return statistics;
+    }
+
+private:
+    GattDiscoveryCache(const GattDiscoveryCache&);
+    GattDiscoveryCache& operator=(const GattDiscoveryCache&);
+
+    Entry* find(ble::connection_handle_t connection);
+
+    void registerCallbacks();
+    void subscribeServiceChanged(Entry* entry);
+    void whenHVX(const GattHVXCallbackParams* params);
+    void whenShutdown(const ble::GattClient* client);
+
+    Entry entries[GATT_DISCOVERY_CACHE_MAX_PEERS];
+    Statistics statistics;
+    uint32_t clock;
+    bool callbacksRegistered;
+};
+
+#endif //BLE_CLIAPP_UTIL_GATT_DISCOVERY_CACHE_H_
@@ -0,0 +1,123 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#if not defined(NO_FILESYSTEM)
+
+#include "LatencyBlockDevice.h"
+#include "platform/mbed_wait_api.h"
+
+LatencyBlockDevice::LatencyBlockDevice(
+    mbed::BlockDevice* bd,
+    uint32_t erase_latency,
+    uint32_t program_latency
+) : bd(bd), erase_latency(erase_latency), program_latency(program_latency),
+    statistics()
+{
+}
+
+void LatencyBlockDevice::setLatency(uint32_t erase_latency, uint32_t program_latency)
+{
+    this->erase_latency = erase_latency;
+    this->program_latency = program_latency;
+}
+
+int LatencyBlockDevice::init()
+{
+    return bd->init();
+}
+
+int LatencyBlockDevice::deinit()
+{
+    return bd->deinit();
+}
+
+int LatencyBlockDevice::sync()
+{
+    return bd->sync();
+}
+
+int LatencyBlockDevice::read(void *buffer, mbed::bd_addr_t addr, mbed::bd_size_t size)
+{
+    ++statistics.reads;
+    return bd->read(buffer, addr, size);
+}
+
+int LatencyBlockDevice::program(const void *buffer, mbed::bd_addr_t addr, mbed::bd_size_t size)
+{
+    ++statistics.programs;
+    int err = bd->program(buffer, addr, size);
+    delay(size / bd->get_program_size(), program_latency);
+    return err;
+}
+
+int LatencyBlockDevice::erase(mbed::bd_addr_t addr, mbed::bd_size_t size)
+{
+    ++statistics.erases;
+    int err = bd->erase(addr, size);
+    delay(size / bd->get_erase_size(addr), erase_latency);
+    return err;
+}
+
+int LatencyBlockDevice::trim(mbed::bd_addr_t addr, mbed::bd_size_t size)
+{
+    return bd->trim(addr, size);
+}
+
+mbed::bd_size_t LatencyBlockDevice::get_read_size() const
+{
+    return bd->get_read_size();
+}
+
+mbed::bd_size_t LatencyBlockDevice::get_program_size() const
+{
+    return bd->get_program_size();
+}
+
+mbed::bd_size_t LatencyBlockDevice::get_erase_size() const
+{
+    return bd->get_erase_size();
+}
+
+mbed::bd_size_t LatencyBlockDevice::get_erase_size(mbed::bd_addr_t addr) const
+{
+    return bd->get_erase_size(addr);
+}
+
+int LatencyBlockDevice::get_erase_value() const
+{
+    return bd->get_erase_value();
+}
+
+mbed::bd_size_t LatencyBlockDevice::size() const
+{
+    return bd->size();
+}
+
+const char *LatencyBlockDevice::get_type() const
+{
+    return bd->get_type();
+}
+
+void LatencyBlockDevice::delay(uint32_t units, uint32_t latency)
+{
+    if (units == 0 || latency == 0) {
+        return;
+    }
+
+    // the latency is paid per unit, as a flash device processes one unit at a time
+    const uint32_t duration = units * latency;
+    wait_us(duration);
+    statistics.delay += duration;
+}
+
+#endif //not defined(NO_FILESYSTEM)
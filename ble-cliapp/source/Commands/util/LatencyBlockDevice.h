@@ -0,0 +1,102 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_LATENCY_BLOCK_DEVICE_H_
+#define BLE_CLIAPP_UTIL_LATENCY_BLOCK_DEVICE_H_
+
+#if not defined(NO_FILESYSTEM)
+
+#include <stdint.h>
+#include "BlockDevice.h"
+
+/**
+ * @brief Block device adaptor which emulates the erase and program latency of
+ * a flash device.
+ * @details Operations are forwarded to the underlying block device, usually a
+ * HeapBlockDevice, then the caller is blocked for the latency configured per
+ * erase unit or program unit. Operations are counted to measure the load of a
+ * filesystem on the storage.
+ */
+class LatencyBlockDevice : public mbed::BlockDevice {
+public:
+    struct Statistics {
+        uint32_t reads;
+        uint32_t programs;
+        uint32_t erases;
+        // time, in µs, spent emulating latency
+        uint32_t delay;
+    };
+
+    /**
+     * @param bd The block device to forward the operations to.
+     * @param erase_latency Latency, in µs, of the erase of an erase unit.
+     * @param program_latency Latency, in µs, of the programming of a program
+     * unit.
+     */
+    LatencyBlockDevice(
+        mbed::BlockDevice* bd,
+        uint32_t erase_latency = 0,
+        uint32_t program_latency = 0
+    );
+
+    void setLatency(uint32_t erase_latency, uint32_t program_latency);
+
+    const Statistics& getStatistics() const {
+        return statistics;
+    }
+
+    // mbed::BlockDevice implementation
+
+    int init() override;
+
+    int deinit() override;
+
+    int sync() override;
+
+    int read(void *buffer, mbed::bd_addr_t addr, mbed::bd_size_t size) override;
+
+    int program(const void *buffer, mbed::bd_addr_t addr, mbed::bd_size_t size) override;
+
+    int erase(mbed::bd_addr_t addr, mbed::bd_size_t size) override;
+
+    int trim(mbed::bd_addr_t addr, mbed::bd_size_t size) override;
+
+    mbed::bd_size_t get_read_size() const override;
+
+    mbed::bd_size_t get_program_size() const override;
+
+    mbed::bd_size_t get_erase_size() const override;
+
+    mbed::bd_size_t get_erase_size(mbed::bd_addr_t addr) const override;
+
+    int get_erase_value() const override;
+
+    mbed::bd_size_t size() const override;
+
+    const char *get_type() const override;
+
+private:
+    LatencyBlockDevice(const LatencyBlockDevice&);
+    LatencyBlockDevice& operator=(const LatencyBlockDevice&);
+
+    void delay(uint32_t units, uint32_t latency);
+
+    mbed::BlockDevice* bd;
+    uint32_t erase_latency;
+    uint32_t program_latency;
+    Statistics statistics;
+};
+
+#endif //not defined(NO_FILESYSTEM)
+
+#endif //BLE_CLIAPP_UTIL_LATENCY_BLOCK_DEVICE_H_
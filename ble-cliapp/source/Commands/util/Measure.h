@@ -0,0 +1,117 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_MEASURE_H_
+#define BLE_CLIAPP_UTIL_MEASURE_H_
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+/**
+ * @brief Minimum, maximum, mean and standard deviation of a series of values.
+ * @tparam T Type of the values.
+ * @tparam Sum Type of the sum of the values.
+ */
+template<typename T, typename Sum>
+struct BasicMeasure {
+    BasicMeasure() :
+        min(std::numeric_limits<T>::max()), max(std::numeric_limits<T>::min()),
+        sum(0), sum_squares(0), count(0) { }
+
+    void add(T value) {
+        min = std::min(min, value);
+        max = std::max(max, value);
+        sum += value;
+        sum_squares += (double) value * value;
+        ++count;
+    }
+
+    /**
+     * @brief Mean of the values, rounded toward zero; 0 if there is no value.
+     */
+    T mean() const {
+        return count ? (T) (sum / (Sum) count) : 0;
+    }
+
+    /**
+     * @brief Population standard deviation of the values, rounded.
+     */
+    uint32_t stddev() const {
+        if (!count) {
+            return 0;
+        }
+        const double mean = (double) sum / count;
+        const double variance = (sum_squares / count) - (mean * mean);
+        return variance > 0 ? (uint32_t) (sqrt(variance) + 0.5) : 0;
+    }
+
+    T min;
+    T max;
+    Sum sum;
+    // the squares of durations in µs overflow 64 bit integers
+    double sum_squares;
+    uint32_t count;
+};
+
+// Measure of the durations of an operation, in µs
+typedef BasicMeasure<uint32_t, uint64_t> Measure;
+
+// Measure of signed 8 bit values, like RSSI in dBm
+typedef BasicMeasure<int8_t, int64_t> Int8Measure;
+
+/**
+ * @brief Distribution of the durations of an operation, in µs unless stated
+ * otherwise by the command reporting it.
+ * @details Durations are counted in buckets of power of two: the bucket i
+ * holds the durations in [2^i, 2^(i + 1)), the first bucket also holds 0 and
+ * the last one every duration above 2^(BUCKETS - 1), about 8s.
+ */
+struct Histogram {
+    static const uint8_t BUCKETS = 24;
+
+    Histogram() : measure(), buckets() { }
+
+    void add(uint32_t duration) {
+        measure.add(duration);
+
+        uint8_t bucket = 0;
+        while (duration > 1 && bucket < (BUCKETS - 1)) {
+            duration >>= 1;
+            ++bucket;
+        }
+        ++buckets[bucket];
+    }
+
+    /**
+     * @brief Upper bound of the bucket containing a percentile of the
+     * durations.
+     */
+    uint32_t percentile(uint8_t percent) const {
+        uint32_t rank = ((uint64_t) measure.count * percent + 99) / 100;
+        uint32_t cumulated = 0;
+        for (uint8_t i = 0; i < BUCKETS; ++i) {
+            cumulated += buckets[i];
+            if (cumulated >= rank) {
+                return std::min(measure.max, (uint32_t) ((2UL << i) - 1));
+            }
+        }
+        return measure.max;
+    }
+
+    Measure measure;
+    uint32_t buckets[BUCKETS];
+};
+
+#endif //BLE_CLIAPP_UTIL_MEASURE_H_
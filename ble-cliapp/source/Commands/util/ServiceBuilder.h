@@ -14,138 +14,154 @@
 #ifndef BLE_CLIAPP_UTIL_SERVICE_BUILDER_
 #define BLE_CLIAPP_UTIL_SERVICE_BUILDER_
 
-#include "ble/gatt/GattService.h"
 #include "ble/gatt/GattCharacteristic.h"
-#include "ble/gatt/GattAttribute.h"
 #include "ble/common/UUID.h"
-#include "ble/GattServer.h"
-#include "detail/RAIIGattAttribute.h"
-#include "detail/RAIIGattCharacteristic.h"
-#include "detail/RAIIGattService.h"
-
+#include "util/Vector.h"
+#include "detail/ServiceDeclaration.h"
+
+/**
+ * @brief Record the declaration of a service command after command.
+ * @details Characteristics, descriptors and values are appended to the flat
+ * records of a ServiceDeclaration; the service tree is built in a single
+ * memory block once the declaration is committed (see GattServiceArena).
+ */
 class ServiceBuilder {
 
 public:
-    ServiceBuilder(const UUID& uuid) :
-        service(new ::detail::RAIIGattService(uuid)), currentCharacteristic(NULL), currentDescriptor(NULL) {
-    }
-
-    ~ServiceBuilder() {
-        delete service;
-        delete currentCharacteristic;
-        delete currentDescriptor;
+    ServiceBuilder(const UUID& uuid) : declaration(uuid) {
     }
 
     void declareCharacteristic(const UUID& characteristicUUID) {
-        commit();
-        currentCharacteristic = new ::detail::RAIIGattCharacteristic(characteristicUUID);
+        declaration.characteristics.push_back(
+            ::detail::CharacteristicDeclaration(characteristicUUID, declaration.descriptors.size())
+        );
     }
 
     bool setCharacteristicValue(const container::Vector<uint8_t>& characteristicValue) {
-        if(!currentCharacteristic) {
+        ::detail::CharacteristicDeclaration* characteristic = currentCharacteristic();
+        if(!characteristic) {
             return false;
         }
-        currentCharacteristic->setValue(characteristicValue);
+        setValue(characteristic->value, characteristicValue);
         return true;
     }
 
     bool setCharacteristicProperties(uint8_t properties) {
-        if(!currentCharacteristic) {
+        ::detail::CharacteristicDeclaration* characteristic = currentCharacteristic();
+        if(!characteristic) {
             return false;
         }
-        currentCharacteristic->setProperties(properties);
+        characteristic->properties = properties;
         return true;
     }
 
     bool setCharacteristicSecurity(GattCharacteristic::SecurityRequirement_t::type read_security,
         GattCharacteristic::SecurityRequirement_t::type write_security,
         GattCharacteristic::SecurityRequirement_t::type update_security) {
-        if(!currentCharacteristic) {
+        ::detail::CharacteristicDeclaration* characteristic = currentCharacteristic();
+        if(!characteristic) {
             return false;
         }
-        currentCharacteristic->setSecurity(read_security, write_security, update_security);
+        characteristic->readSecurity = read_security;
+        characteristic->writeSecurity = write_security;
+        characteristic->updateSecurity = update_security;
         return true;
     }
 
     bool setCharacteristicVariableLength(bool variableLen) {
-        if(!currentCharacteristic) {
+        ::detail::CharacteristicDeclaration* characteristic = currentCharacteristic();
+        if(!characteristic) {
             return false;
         }
-        currentCharacteristic->setVariableLength(variableLen);
+        characteristic->value.variableLength = variableLen;
         return true;
     }
 
     bool setCharacteristicMaxLength(uint16_t maxLen) {
-        if(!currentCharacteristic) {
+        ::detail::CharacteristicDeclaration* characteristic = currentCharacteristic();
+        if(!characteristic || maxLen < characteristic->value.maxLength) {
             return false;
         }
-        return currentCharacteristic->setMaxLength(maxLen);
+        characteristic->value.maxLength = maxLen;
+        return true;
     }
 
     bool declareDescriptor(const UUID& descriptorUUID) {
-        if(!currentCharacteristic) {
+        ::detail::CharacteristicDeclaration* characteristic = currentCharacteristic();
+        if(!characteristic) {
             return false;
         }
 
-        if(currentDescriptor) {
-            currentCharacteristic->addDescriptor(currentDescriptor);
-        }
-
-        currentDescriptor = new ::detail::RAIIGattAttribute(descriptorUUID);
+        declaration.descriptors.push_back(::detail::AttributeDeclaration(descriptorUUID));
+        characteristic->descriptorCount += 1;
         return true;
     }
 
     bool setDescriptorValue(const container::Vector<uint8_t>& descriptorValue) {
-        if(!currentCharacteristic || !currentDescriptor) {
+        ::detail::AttributeDeclaration* descriptor = currentDescriptor();
+        if(!descriptor) {
             return false;
         }
 
-        currentDescriptor->setValue(descriptorValue);
+        setValue(*descriptor, descriptorValue);
         return true;
     }
 
     bool setDescriptorVariableLength(bool variableLen) {
-        if(!currentCharacteristic || !currentDescriptor) {
+        ::detail::AttributeDeclaration* descriptor = currentDescriptor();
+        if(!descriptor) {
             return false;
         }
 
-        currentDescriptor->setVariableLength(variableLen);
+        descriptor->variableLength = variableLen;
         return true;
     }
 
     bool setDescriptorMaxLength(uint16_t maxLen) {
-        if(!currentCharacteristic || !currentDescriptor) {
+        ::detail::AttributeDeclaration* descriptor = currentDescriptor();
+        if(!descriptor || maxLen < descriptor->length) {
             return false;
         }
 
-        return currentDescriptor->setMaxLength(maxLen);
-    }
-
-    ::detail::RAIIGattService* release() {
-        ::detail::RAIIGattService* toReturn = service;
-        service = NULL;
-        return toReturn;
+        descriptor->maxLength = maxLen;
+        return true;
     }
 
-    void commit() {
-        if(currentCharacteristic) {
-            if(currentDescriptor) {
-                currentCharacteristic->addDescriptor(currentDescriptor);
-                currentDescriptor = NULL;
-            }
-            service->addCharacteristic(currentCharacteristic);
-            currentCharacteristic = NULL;
-        }
+    const ::detail::ServiceDeclaration& getDeclaration() const {
+        return declaration;
     }
 
 private:
     ServiceBuilder(const ServiceBuilder&);
     ServiceBuilder& operator=(const ServiceBuilder&);
 
-    ::detail::RAIIGattService* service;
-    ::detail::RAIIGattCharacteristic* currentCharacteristic;
-    ::detail::RAIIGattAttribute* currentDescriptor;
+    ::detail::CharacteristicDeclaration* currentCharacteristic() {
+        const size_t count = declaration.characteristics.size();
+        return count ? &declaration.characteristics[count - 1] : NULL;
+    }
+
+    // the last descriptor declared in the current characteristic
+    ::detail::AttributeDeclaration* currentDescriptor() {
+        ::detail::CharacteristicDeclaration* characteristic = currentCharacteristic();
+        if(!characteristic || !characteristic->descriptorCount) {
+            return NULL;
+        }
+        return &declaration.descriptors[declaration.descriptors.size() - 1];
+    }
+
+    void setValue(::detail::AttributeDeclaration& attribute, const container::Vector<uint8_t>& value) {
+        attribute.valueOffset = declaration.values.size();
+        attribute.length = value.size();
+        for(size_t i = 0; i < value.size(); ++i) {
+            declaration.values.push_back(value[i]);
+        }
+
+        if(attribute.maxLength < attribute.length) {
+            attribute.maxLength = attribute.length;
+        }
+    }
 
+    ::detail::ServiceDeclaration declaration;
 };
 
 
@@ -0,0 +1,98 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "StackWatermark.h"
+#include "platform/mbed_toolchain.h"
+
+#if MBED_CONF_RTOS_PRESENT
+#include "rtx_os.h"
+#else
+// bounds of the stack shared by main and the interrupt handlers, see mbed_boot.c
+extern "C" {
+extern unsigned char* mbed_stack_isr_start;
+extern uint32_t mbed_stack_isr_size;
+}
+#endif
+
+static const uint32_t STACK_PATTERN = 0xDEADC0DE;
+// The first words of the stack are left untouched: RTX checks its stack
+// overflow magic word there.
+static const uint32_t RESERVED_WORDS = 2;
+// Bytes left untouched below the frame of paint()
+static const uint32_t PAINT_GUARD = 64;
+
+static bool stack_painted = false;
+
+static bool get_bounds(uint32_t*& bottom, uint8_t*& top)
+{
+#if MBED_CONF_RTOS_PRESENT
+    const osRtxThread_t* thread = (const osRtxThread_t*) osThreadGetId();
+    if (!thread || !thread->stack_mem) {
+        return false;
+    }
+    bottom = (uint32_t*) thread->stack_mem;
+    top = (uint8_t*) thread->stack_mem + thread->stack_size;
+#else
+    bottom = (uint32_t*) mbed_stack_isr_start;
+    top = mbed_stack_isr_start + mbed_stack_isr_size;
+#endif
+    bottom += RESERVED_WORDS;
+    return true;
+}
+
+MBED_NOINLINE bool StackWatermark::paint()
+{
+    uint32_t* bottom;
+    uint8_t* top;
+    if (!get_bounds(bottom, top)) {
+        return false;
+    }
+
+    volatile uint32_t marker = 0;
+    volatile uint32_t* end = (volatile uint32_t*) (((uintptr_t) &marker - PAINT_GUARD) & ~((uintptr_t) 3));
+    for (volatile uint32_t* it = bottom; it < end; ++it) {
+        *it = STACK_PATTERN;
+    }
+
+    stack_painted = true;
+    return true;
+}
+
+bool StackWatermark::painted()
+{
+    return stack_painted;
+}
+
+MBED_NOINLINE StackWatermark::Usage StackWatermark::usage()
+{
+    Usage usage = { 0, 0, 0 };
+    uint32_t* bottom;
+    uint8_t* top;
+    if (!get_bounds(bottom, top)) {
+        return usage;
+    }
+
+    volatile uint32_t marker = 0;
+    usage.size = top - (uint8_t*) bottom;
+    usage.current = top - (uint8_t*) &marker;
+
+    if (stack_painted) {
+        const uint32_t* it = bottom;
+        while (it < (const uint32_t*) top && *it == STACK_PATTERN) {
+            ++it;
+        }
+        usage.peak = top - (const uint8_t*) it;
+    }
+
+    return usage;
+}
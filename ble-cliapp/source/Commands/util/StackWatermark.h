@@ -0,0 +1,53 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_STACK_WATERMARK_H_
+#define BLE_CLIAPP_UTIL_STACK_WATERMARK_H_
+
+#include <stdint.h>
+
+/**
+ * @brief High watermark of the stack of the main loop.
+ * @details The free part of the stack is painted with a pattern; the deepest
+ * word overwritten since gives the peak usage. Commands and BLE events run from
+ * the main loop. Interrupt handlers run on that stack in bare metal builds
+ * only.
+ *
+ * paint() and usage() must be called from the main loop.
+ */
+class StackWatermark {
+public:
+    struct Usage {
+        // size, in bytes, of the stack
+        uint32_t size;
+        // bytes used by the caller of usage()
+        uint32_t current;
+        // bytes used at the deepest point since the stack has been painted
+        uint32_t peak;
+    };
+
+    /**
+     * @brief Paint the part of the stack below the caller.
+     * @return false if the bounds of the stack are not known.
+     */
+    static bool paint();
+
+    /**
+     * @brief true once the stack has been painted.
+     */
+    static bool painted();
+
+    static Usage usage();
+};
+
+#endif //BLE_CLIAPP_UTIL_STACK_WATERMARK_H_
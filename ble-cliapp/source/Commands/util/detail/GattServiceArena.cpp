@@ -0,0 +1,175 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "GattServiceArena.h"
+
+namespace detail {
+
+namespace {
+
+size_t align(size_t size) {
+    const size_t alignment = alignof(std::max_align_t);
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// Bump allocator over the memory block of the arena
+struct Cursor {
+    Cursor(uint8_t* start) : position(start) { }
+
+    template<typename T>
+    T* take(size_t count = 1) {
+        T* result = reinterpret_cast<T*>(position);
+        position += align(sizeof(T) * count);
+        return result;
+    }
+
+    uint8_t* position;
+};
+
+// Copy of the values, packed at the end of the memory block
+struct ValueCursor {
+    ValueCursor(uint8_t* start) : position(start) { }
+
+    uint8_t* take(const ServiceDeclaration& declaration, const AttributeDeclaration& attribute) {
+        if(!attribute.length) {
+            return NULL;
+        }
+        uint8_t* value = position;
+        std::memcpy(value, declaration.getValue(attribute), attribute.length);
+        position += attribute.length;
+        return value;
+    }
+
+    uint8_t* position;
+};
+
+// Return the size of the memory block; values is set to the size of the values
+size_t measure(const ServiceDeclaration& declaration, size_t& values) {
+    const size_t characteristicCount = declaration.characteristics.size();
+
+    size_t size = align(sizeof(GattServiceArena)) +
+        align(sizeof(GattService)) +
+        align(sizeof(GattCharacteristic*) * characteristicCount) +
+        align(sizeof(GattCharacteristic) * characteristicCount);
+
+    values = 0;
+    for(size_t i = 0; i < characteristicCount; ++i) {
+        const CharacteristicDeclaration& characteristic = declaration.characteristics[i];
+        size += align(sizeof(GattAttribute*) * characteristic.descriptorCount) +
+            align(sizeof(GattAttribute) * characteristic.descriptorCount);
+
+        values += characteristic.value.length;
+        for(uint8_t j = 0; j < characteristic.descriptorCount; ++j) {
+            values += declaration.descriptors[characteristic.descriptorsBegin + j].length;
+        }
+    }
+
+    return size + values;
+}
+
+}
+
+GattServiceArena* GattServiceArena::create(const ServiceDeclaration& declaration) {
+    size_t valuesSize = 0;
+    const size_t size = measure(declaration, valuesSize);
+    uint8_t* block = static_cast<uint8_t*>(std::malloc(size));
+    if(!block) {
+        return NULL;
+    }
+
+    Cursor cursor(block);
+    ValueCursor values(block + size - valuesSize);
+    GattServiceArena* arena = cursor.take<GattServiceArena>();
+    GattService* service = cursor.take<GattService>();
+
+    const uint8_t characteristicCount = declaration.characteristics.size();
+    GattCharacteristic** characteristics = cursor.take<GattCharacteristic*>(characteristicCount);
+    GattCharacteristic* characteristicsStorage = cursor.take<GattCharacteristic>(characteristicCount);
+
+    for(uint8_t i = 0; i < characteristicCount; ++i) {
+        const CharacteristicDeclaration& characteristic = declaration.characteristics[i];
+        GattAttribute** descriptors = cursor.take<GattAttribute*>(characteristic.descriptorCount);
+        GattAttribute* descriptorsStorage = cursor.take<GattAttribute>(characteristic.descriptorCount);
+
+        for(uint8_t j = 0; j < characteristic.descriptorCount; ++j) {
+            const AttributeDeclaration& descriptor =
+                declaration.descriptors[characteristic.descriptorsBegin + j];
+            descriptors[j] = new (&descriptorsStorage[j]) GattAttribute(
+                descriptor.uuid,
+                values.take(declaration, descriptor),
+                descriptor.length,
+                descriptor.maxLength,
+                descriptor.variableLength
+            );
+        }
+
+        const AttributeDeclaration& value = characteristic.value;
+        characteristics[i] = new (&characteristicsStorage[i]) GattCharacteristic(
+            value.uuid,
+            values.take(declaration, value),
+            value.length,
+            value.maxLength,
+            characteristic.properties,
+            characteristic.descriptorCount ? descriptors : NULL,
+            characteristic.descriptorCount,
+            value.variableLength
+        );
+        characteristics[i]->setSecurityRequirements(
+            characteristic.readSecurity,
+            characteristic.writeSecurity,
+            characteristic.updateSecurity
+        );
+    }
+
+    new (service) GattService(declaration.uuid, characteristicCount ? characteristics : NULL, characteristicCount);
+
+    return new (arena) GattServiceArena(service, size);
+}
+
+void GattServiceArena::destroy(GattServiceArena* arena) {
+    if(!arena) {
+        return;
+    }
+
+    arena->~GattServiceArena();
+    std::free(arena);
+}
+
+GattServiceArena::GattServiceArena(GattService* s, size_t sz) :
+    service(s), size(sz) {
+}
+
+GattServiceArena::~GattServiceArena() {
+    for(uint8_t i = 0; i < service->getCharacteristicCount(); ++i) {
+        GattCharacteristic* characteristic = service->getCharacteristic(i);
+        for(uint8_t j = 0; j < characteristic->getDescriptorCount(); ++j) {
+            characteristic->getDescriptor(j)->~GattAttribute();
+        }
+        characteristic->~GattCharacteristic();
+    }
+    service->~GattService();
+}
+
+GattService& GattServiceArena::getService() {
+    return *service;
+}
+
+size_t GattServiceArena::getSize() const {
+    return size;
+}
+
+} // namespace detail
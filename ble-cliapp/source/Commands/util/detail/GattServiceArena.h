@@ -0,0 +1,63 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_DETAIL_GATT_SERVICE_ARENA_H_
+#define BLE_CLIAPP_UTIL_DETAIL_GATT_SERVICE_ARENA_H_
+
+#include <stddef.h>
+#include "ble/gatt/GattService.h"
+#include "ServiceDeclaration.h"
+
+namespace detail {
+
+/**
+ * @brief Storage of a service committed in the GattServer.
+ * @details The service, its characteristics, their descriptors, the arrays
+ * linking them and the attribute values are placed in a single memory block
+ * which is allocated and released in one call.
+ */
+class GattServiceArena {
+public:
+    /**
+     * @brief Measure the tree of a service declaration then construct it in a
+     * single memory block.
+     * @return The arena created or NULL if the memory block cannot be allocated.
+     */
+    static GattServiceArena* create(const ServiceDeclaration& declaration);
+
+    /**
+     * @brief Destroy the objects of an arena and release its memory block.
+     */
+    static void destroy(GattServiceArena* arena);
+
+    GattService& getService();
+
+    /**
+     * @brief Size in bytes of the memory block.
+     */
+    size_t getSize() const;
+
+private:
+    GattServiceArena(GattService* service, size_t size);
+    ~GattServiceArena();
+
+    GattServiceArena(const GattServiceArena&);
+    GattServiceArena& operator=(const GattServiceArena&);
+
+    GattService* service;
+    size_t size;
+};
+
+}
+
+#endif //BLE_CLIAPP_UTIL_DETAIL_GATT_SERVICE_ARENA_H_
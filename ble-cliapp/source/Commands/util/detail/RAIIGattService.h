@@ -1,42 +0,0 @@
-/* Copyright (c) 2015-2020 ARM Limited
- * SPDX-License-Identifier: Apache-2.0
- *
- * Licensed under the Apache License, Version 2.0 (the "License");
- * you may not use this file except in compliance with the License.
- * You may obtain a copy of the License at
- * http://www.apache.org/licenses/LICENSE-2.0
- * Unless required by applicable law or agreed to in writing, software
- * distributed under the License is distributed on an "AS IS" BASIS,
- * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
- * See the License for the specific language governing permissions and
- * limitations under the License.
- */
-#ifndef BLE_CLIAPP_UTIL_DETAIL_RAII_GATT_SERVICE_H_
-#define BLE_CLIAPP_UTIL_DETAIL_RAII_GATT_SERVICE_H_
-
-#include <stdint.h>
-#include "ble/gatt/GattService.h"
-#include "util/Vector.h"
-#include "RAIIGattCharacteristic.h"
-
-namespace detail {
-
-class RAIIGattService : public GattService {
-public:
-    RAIIGattService(const UUID& uuid);
-
-    ~RAIIGattService();
-
-    // note: the characteristic will be moved and owned by this data structure ...
-    void addCharacteristic(RAIIGattCharacteristic* characteristic);
-
-    void releaseAttributesValue();
-
-private:
-    RAIIGattService(const RAIIGattService&);
-    RAIIGattService& operator=(const RAIIGattService&);
-};
-
-}
-
-#endif //BLE_CLIAPP_UTIL_DETAIL_RAII_GATT_SERVICE_H_
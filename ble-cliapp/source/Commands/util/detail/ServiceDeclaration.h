@@ -0,0 +1,84 @@
+/* Copyright (c) 2015-2020 ARM Limited
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLE_CLIAPP_UTIL_DETAIL_SERVICE_DECLARATION_H_
+#define BLE_CLIAPP_UTIL_DETAIL_SERVICE_DECLARATION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ble/gatt/GattCharacteristic.h"
+#include "ble/common/UUID.h"
+#include "util/Vector.h"
+
+namespace detail {
+
+/**
+ * @brief Declaration of an attribute; its value is stored in the values of the
+ * service declaration.
+ */
+struct AttributeDeclaration {
+    AttributeDeclaration(const UUID& u) :
+        uuid(u), valueOffset(0), length(0), maxLength(0), variableLength(true) { }
+
+    UUID uuid;
+    size_t valueOffset;
+    uint16_t length;
+    uint16_t maxLength;
+    bool variableLength;
+};
+
+struct CharacteristicDeclaration {
+    CharacteristicDeclaration(const UUID& uuid, uint16_t firstDescriptor) :
+        value(uuid),
+        properties(GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NONE),
+        readSecurity(GattCharacteristic::SecurityRequirement_t::NONE),
+        writeSecurity(GattCharacteristic::SecurityRequirement_t::NONE),
+        updateSecurity(GattCharacteristic::SecurityRequirement_t::NONE),
+        descriptorsBegin(firstDescriptor),
+        descriptorCount(0) { }
+
+    AttributeDeclaration value;
+    uint8_t properties;
+    GattCharacteristic::SecurityRequirement_t readSecurity;
+    GattCharacteristic::SecurityRequirement_t writeSecurity;
+    GattCharacteristic::SecurityRequirement_t updateSecurity;
+    // range of the descriptors of the characteristic in ServiceDeclaration::descriptors
+    uint16_t descriptorsBegin;
+    uint8_t descriptorCount;
+};
+
+/**
+ * @brief Flat declaration of a service: records of the characteristics and
+ * descriptors in declaration order and a single pool of values.
+ * @details The records and the pool grow geometrically; the GattService tree
+ * is only built once the declaration is complete (see GattServiceArena).
+ */
+struct ServiceDeclaration {
+    ServiceDeclaration(const UUID& u) : uuid(u) { }
+
+    const uint8_t* getValue(const AttributeDeclaration& attribute) const {
+        return attribute.length ? values.cbegin() + attribute.valueOffset : NULL;
+    }
+
+    UUID uuid;
+    container::Vector<CharacteristicDeclaration> characteristics;
+    // descriptors of all the characteristics, in declaration order
+    container::Vector<AttributeDeclaration> descriptors;
+    // values of the attributes; a value replaced stays in the pool until the
+    // declaration ends
+    container::Vector<uint8_t> values;
+};
+
+}
+
+#endif //BLE_CLIAPP_UTIL_DETAIL_SERVICE_DECLARATION_H_
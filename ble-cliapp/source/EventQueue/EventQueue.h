@@ -36,6 +36,18 @@ public:
 	/// type used for time
 	typedef std::size_t ms_time_t;
 
+	/// Occupancy of the queue.
+	struct Statistics {
+		/// number of events pending
+		std::size_t size;
+		/// number of events the queue can hold, 0 if unbounded
+		std::size_t capacity;
+		/// highest number of events pending since the last reset
+		std::size_t peak;
+		/// number of posts rejected because the queue was full
+		std::size_t failed_posts;
+	};
+
 	/// Construct an empty event queue
 	EventQueue() { }
 
@@ -116,6 +128,20 @@ public:
 
 	virtual bool cancel(event_handle_t event_handle) = 0;
 
+	/**
+	 * Return the occupancy of the queue.
+	 * Queues which do not track it report zeros.
+	 */
+	virtual Statistics get_statistics() const {
+		Statistics statistics = { 0, 0, 0, 0 };
+		return statistics;
+	}
+
+	/**
+	 * Reset the peak and the failed posts of the queue statistics.
+	 */
+	virtual void reset_statistics() { }
+
 private:
 	virtual event_handle_t do_post(const function_t& fn, ms_time_t ms_delay = 0, bool repeat = false) = 0;
 };
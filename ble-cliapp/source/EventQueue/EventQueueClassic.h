@@ -97,7 +97,8 @@ class EventQueueClassic: public EventQueue {
 public:
 	/// Construct an empty event queue
 	EventQueueClassic() :
-		_events_queue(), _ticker(), _timer(), _timed_event_pending(false) {
+		_events_queue(), _ticker(), _timer(), _timed_event_pending(false),
+		_peak_size(0), _failed_posts(0) {
 	}
 
 	virtual ~EventQueueClassic() { }
@@ -112,6 +113,20 @@ public:
 		return success;
 	}
 
+	virtual Statistics get_statistics() const {
+		CriticalSection critical_section;
+		Statistics statistics = {
+			_events_queue.size(), _events_queue.capacity(), _peak_size, _failed_posts
+		};
+		return statistics;
+	}
+
+	virtual void reset_statistics() {
+		CriticalSection critical_section;
+		_peak_size = _events_queue.size();
+		_failed_posts = 0;
+	}
+
 	void dispatch() {
 		while(true) {
 			function_t f;
@@ -213,9 +228,14 @@ private:
 
 		CriticalSection critical_section;
 		if (_events_queue.full()) {
+			++_failed_posts;
 			return NULL;
 		}
 
+		if (_events_queue.size() + 1 > _peak_size) {
+			_peak_size = _events_queue.size() + 1;
+		}
+
 		// there is no need to update timings if ms_delay == 0
 		if (!ms_delay) {
 			return _events_queue.push(event).get_node();
@@ -249,6 +269,8 @@ private:
 	mbed::Ticker _ticker;
 	mbed::Timer _timer;
 	bool _timed_event_pending;
+	std::size_t _peak_size;
+	std::size_t _failed_posts;
 };
 
 } // namespace eq
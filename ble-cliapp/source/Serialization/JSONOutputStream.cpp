@@ -94,6 +94,12 @@ JSONOutputStream& endObject(JSONOutputStream& os) {
     return os;
 }
 
+JSONOutputStream& lineBreak(JSONOutputStream& os) {
+    const char str[] = "\r\n";
+    os.out.write(str, strlen(str));
+    return os;
+}
+
 JSONOutputStream& nil(JSONOutputStream& os) {
     os.write("null");
     os.commitValue();
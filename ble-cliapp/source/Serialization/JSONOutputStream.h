@@ -39,6 +39,7 @@ class JSONOutputStream {
     friend JSONOutputStream& endArray(JSONOutputStream& os);
     friend JSONOutputStream& startObject(JSONOutputStream& os);
     friend JSONOutputStream& endObject(JSONOutputStream& os);
+    friend JSONOutputStream& lineBreak(JSONOutputStream& os);
 
 public:
     /**
@@ -267,6 +268,17 @@ JSONOutputStream& startObject(JSONOutputStream& os);
  */
 JSONOutputStream& endObject(JSONOutputStream& os);
 
+/**
+ * @brief Start a new line in the output stream.
+ * @details The line break is not a JSON value, it does not affect the separation
+ * of values. It is used to frame the elements of arrays which grow over time
+ * (scan reports, notifications, ...) on their own line; the host can then decode
+ * them as soon as they are received.
+ * @param os The output stream to operate on
+ * @return os
+ */
+JSONOutputStream& lineBreak(JSONOutputStream& os);
+
 /**
  * @brief Inser a null value in the output stream
  * @param os The output stream to operate on
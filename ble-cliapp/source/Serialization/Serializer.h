@@ -17,6 +17,13 @@
 
 #include "util/ConstArray.h"
 #include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#ifndef SERIALIZER_INDEX_POOL_SIZE
+#define SERIALIZER_INDEX_POOL_SIZE 384
+#endif
 
 /**
  * @brief simple POD object which map a value to a string
@@ -84,34 +91,191 @@ struct ValueToStringMapping {
 template<typename T>
 struct SerializerDescription;
 
+namespace serializer_detail {
+
+template<typename T>
+struct void_type {
+    typedef void type;
+};
+
+/*
+ * Integer key of a serialized value. It is available for enums and for types
+ * exposing their enum through a value() member, like SafeEnum.
+ */
+template<typename T, typename Enable = void>
+struct Key {
+    static const bool available = false;
+
+    static int32_t get(const T&) {
+        return 0;
+    }
+};
+
+template<typename T>
+struct Key<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+    static const bool available = true;
+
+    static int32_t get(const T& value) {
+        return static_cast<int32_t>(value);
+    }
+};
+
+template<typename T>
+struct Key<T, typename void_type<decltype(std::declval<const T&>().value())>::type> {
+    static const bool available = true;
+
+    static int32_t get(const T& value) {
+        return static_cast<int32_t>(value.value());
+    }
+};
+
+/*
+ * Indexes of a mapping, built once at the first use of the serializer. They
+ * are stored in the pool shared by all the serializers (see takeIndexStorage):
+ *   - positions: position in the mapping of each key in [min, min + range),
+ *   used by toString when the keys are dense.
+ *   - sorted: positions in the mapping sorted by string, used by fromString.
+ */
+struct Index {
+    static const uint8_t NO_POSITION = 0xFF;
+    // mappings shorter than this are searched linearly, which is as fast as
+    // an index
+    static const std::size_t MIN_ENTRIES = 8;
+    // maximum ratio between the range of keys and the number of entries for a
+    // dense index
+    static const std::size_t MAX_DENSITY_RATIO = 2;
+
+    Index() : min(0), range(0), positions(NULL), sorted(NULL) { }
+
+    int32_t min;
+    std::size_t range;
+    uint8_t* positions;
+    uint8_t* sorted;
+};
+
+/*
+ * Take storage for an index from the static pool shared by the serializers.
+ * Indexes live as long as the application, storage is never returned to the
+ * pool. Return NULL if the pool is exhausted; the mapping is then searched
+ * linearly.
+ */
+inline uint8_t* takeIndexStorage(std::size_t size) {
+    static uint8_t pool[SERIALIZER_INDEX_POOL_SIZE];
+    static std::size_t used = 0;
+
+    if (size > sizeof(pool) - used) {
+        return NULL;
+    }
+    uint8_t* storage = pool + used;
+    used += size;
+    return storage;
+}
+
+} // namespace serializer_detail
+
 /**
  * @brief simple serializer logic.
  *
+ * @details The mapping of the description is indexed at the first use of the
+ * serializer: toString is a direct lookup when the values mapped are dense and
+ * fromString is a binary search in the strings sorted. Short mappings and
+ * mappings which cannot be indexed are searched linearly. The indexes are
+ * stored in a static pool of SERIALIZER_INDEX_POOL_SIZE bytes.
+ *
  * @tparam T The type of the serialization. It require that SerializerDescription<T> exist
  */
 template<typename T>
 struct Serializer {
     typedef SerializerDescription<T> description;
     typedef typename SerializerDescription<T>::type serialized_type;
+    typedef serializer_detail::Key<serialized_type> key;
 
     static const char* toString(const serialized_type& val) {
-        return toString(
-            val,
-            description::mapping(),
-            description::errorMessage()
-        );
+        const ConstArray<ValueToStringMapping<serialized_type> > map = description::mapping();
+        const serializer_detail::Index& idx = index();
+
+        if (!idx.positions) {
+            return linearToString(val, map, description::errorMessage());
+        }
+
+        const int32_t offset = key::get(val) - idx.min;
+        if (offset < 0 || (std::size_t) offset >= idx.range ||
+            idx.positions[offset] == serializer_detail::Index::NO_POSITION) {
+            return description::errorMessage();
+        }
+        return map[idx.positions[offset]].str;
     }
 
     static bool fromString(const char* str, serialized_type& val) {
-        return fromString(
-            str,
-            val,
-            description::mapping()
-        );
+        const ConstArray<ValueToStringMapping<serialized_type> > map = description::mapping();
+        const serializer_detail::Index& idx = index();
+
+        if (!idx.sorted) {
+            return linearFromString(str, val, map);
+        }
+
+        // lower bound, the first of equal strings is found like in a linear search
+        std::size_t first = 0;
+        std::size_t last = map.count();
+        while (first < last) {
+            const std::size_t middle = first + ((last - first) / 2);
+            if (std::strcmp(map[idx.sorted[middle]].str, str) < 0) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+
+        if (first == map.count() || std::strcmp(map[idx.sorted[first]].str, str) != 0) {
+            return false;
+        }
+        val = map[idx.sorted[first]].value;
+        return true;
     }
 
-private:
-    static const char* toString(serialized_type value, const ConstArray<ValueToStringMapping<serialized_type> >& map, const char* error_message) {
+    /**
+     * @brief Return true if toString is a direct lookup.
+     */
+    static bool hasDenseIndex() {
+        return index().positions != NULL;
+    }
+
+    /**
+     * @brief Return true if fromString is a binary search.
+     */
+    static bool hasSortedIndex() {
+        return index().sorted != NULL;
+    }
+
+    /**
+     * @brief Return true if the indexed toString and fromString give the same
+     * results as a linear search for every entry of the mapping.
+     */
+    static bool checkIndex() {
+        const ConstArray<ValueToStringMapping<serialized_type> > map = description::mapping();
+        const char* error = description::errorMessage();
+
+        for (std::size_t i = 0; i < map.count(); ++i) {
+            if (std::strcmp(toString(map[i].value), linearToString(map[i].value, map, error)) != 0) {
+                return false;
+            }
+
+            serialized_type indexed = map[0].value;
+            serialized_type linear = map[0].value;
+            if (fromString(map[i].str, indexed) != linearFromString(map[i].str, linear, map) ||
+                !(indexed == linear)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Serialize a value with a linear search of the mapping.
+     * @note Used when the mapping cannot be indexed and as a reference for
+     * benchmarks.
+     */
+    static const char* linearToString(serialized_type value, const ConstArray<ValueToStringMapping<serialized_type> >& map, const char* error_message) {
         for(std::size_t i = 0; i < map.count(); ++i) {
             if(map[i].value == value) {
                 return map[i].str;
@@ -120,7 +284,12 @@ private:
         return error_message;
     }
 
-    static bool fromString(const char* str, serialized_type& value, const ConstArray<ValueToStringMapping<serialized_type> >& map) {
+    /**
+     * @brief Deserialize a value with a linear search of the mapping.
+     * @note Used when the mapping cannot be indexed and as a reference for
+     * benchmarks.
+     */
+    static bool linearFromString(const char* str, serialized_type& value, const ConstArray<ValueToStringMapping<serialized_type> >& map) {
         for(std::size_t i = 0; i < map.count(); ++i) {
             if(std::strcmp(map[i].str, str) == 0) {
                 value = map[i].value;
@@ -129,6 +298,67 @@ private:
         }
         return false;
     }
+
+private:
+    static const serializer_detail::Index& index() {
+        static const serializer_detail::Index idx = buildIndex(description::mapping());
+        return idx;
+    }
+
+    static serializer_detail::Index buildIndex(const ConstArray<ValueToStringMapping<serialized_type> >& map) {
+        using serializer_detail::Index;
+        Index idx;
+
+        // positions are stored on a byte
+        if (map.count() < Index::MIN_ENTRIES || map.count() >= Index::NO_POSITION) {
+            return idx;
+        }
+
+        // strings sorted with an insertion sort, stable to keep the first of
+        // equal strings first
+        idx.sorted = serializer_detail::takeIndexStorage(map.count());
+        if (!idx.sorted) {
+            return idx;
+        }
+        for (std::size_t i = 0; i < map.count(); ++i) {
+            std::size_t j = i;
+            while (j > 0 && std::strcmp(map[idx.sorted[j - 1]].str, map[i].str) > 0) {
+                idx.sorted[j] = idx.sorted[j - 1];
+                --j;
+            }
+            idx.sorted[j] = i;
+        }
+
+        if (!key::available) {
+            return idx;
+        }
+
+        int32_t min = key::get(map[0].value);
+        int32_t max = min;
+        for (std::size_t i = 1; i < map.count(); ++i) {
+            min = std::min(min, key::get(map[i].value));
+            max = std::max(max, key::get(map[i].value));
+        }
+
+        const std::size_t range = (std::size_t) (max - min) + 1;
+        if (range > map.count() * Index::MAX_DENSITY_RATIO) {
+            return idx;
+        }
+
+        idx.positions = serializer_detail::takeIndexStorage(range);
+        if (!idx.positions) {
+            return idx;
+        }
+        idx.min = min;
+        idx.range = range;
+        std::memset(idx.positions, Index::NO_POSITION, range);
+        // the first entry of a value wins, like in a linear search
+        for (std::size_t i = map.count(); i > 0; --i) {
+            idx.positions[key::get(map[i - 1].value) - min] = i - 1;
+        }
+
+        return idx;
+    }
 };
 
 /**
@@ -28,14 +28,36 @@
 #include "Commands/parameters/AdvDataBuilder.h"
 #include "Commands/parameters/ScanParameters.h"
 #include "Commands/parameters/ConnectionParameters.h"
+#include "Commands/util/StackWatermark.h"
 
+#include "CLICommand/util/AsyncProcedure.h"
 #include "util/CriticalSectionLock.h"
 #include "util/CircularBuffer.h"
 #include "EventQueue/EventQueueClassic.h"
 
+#ifndef ENABLE_GATT_SERVER_COMMANDS
+#define ENABLE_GATT_SERVER_COMMANDS 1
+#endif
+
+#ifndef ENABLE_GATT_CLIENT_COMMANDS
+#define ENABLE_GATT_CLIENT_COMMANDS 1
+#endif
+
+#ifndef ENABLE_SECURITY_MANAGER_COMMANDS
+#define ENABLE_SECURITY_MANAGER_COMMANDS 1
+#endif
+
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 10
+#endif
+
+#ifndef RX_BUFFER_SIZE
+#define RX_BUFFER_SIZE 768
+#endif
+
 typedef mbed::util::CriticalSectionLock CriticalSection;
 
-static eq::EventQueueClassic<10> _taskQueue;
+static eq::EventQueueClassic<EVENT_QUEUE_SIZE> _taskQueue;
 
 /**
  * Macros for setting console flow control.
@@ -72,8 +94,11 @@ UnbufferedSerial& get_serial() {
     return serial;
 }
 // constants
-static const size_t CIRCULAR_BUFFER_LENGTH = 768;
+static const size_t CIRCULAR_BUFFER_LENGTH = RX_BUFFER_SIZE;
 static const size_t CONSUMER_BUFFER_LENGTH = 32;
+// character (CTRL+C) which ends the procedures running; commands are executed
+// one after the other and could not reach the board otherwise.
+static const uint8_t ABORT_CHARACTER = 0x03;
 
 // circular buffer used by serial port interrupt to store characters
 // It will be use in a single producer, single consumer setup:
@@ -123,7 +148,13 @@ static void consumeSerialBytes(void) {
             shouldExit = rxBuffer.empty();
         }
 
-        std::for_each(data, data + dataAvailable, cmd_char_input);
+        for (uint32_t i = 0; i < dataAvailable; ++i) {
+            if (data[i] == ABORT_CHARACTER) {
+                AsyncProcedure::abortAll();
+            } else {
+                cmd_char_input(data[i]);
+            }
+        }
     } while(shouldExit == false);
 }
 
@@ -160,9 +191,15 @@ void initialize_app_commands(void) {
     // register command suite in the system
     registerCommandSuite<BLECommandSuiteDescription>();
     registerCommandSuite<GapCommandSuiteDescription>();
+#if ENABLE_GATT_SERVER_COMMANDS
     registerCommandSuite<GattServerCommandSuiteDescription>();
+#endif
+#if ENABLE_GATT_CLIENT_COMMANDS
     registerCommandSuite<GattClientCommandSuiteDescription>();
+#endif
+#if ENABLE_SECURITY_MANAGER_COMMANDS
     registerCommandSuite<SecurityManagerCommandSuiteDescription>();
+#endif
     registerCommandSuite<AdvertisingParametersCommandSuiteDescription>();
     registerCommandSuite<AdvertisingDataBuilderCommandSuiteDescription>();
     registerCommandSuite<ScanParametersCommandSuiteDescription>();
@@ -194,6 +231,9 @@ void app_start(int, char*[])
 
 int main(void)
 {
+    // the high watermark of the stack is reported by ble getDiagnostics
+    StackWatermark::paint();
+
     app_start(0, NULL);
 
     while (true) {
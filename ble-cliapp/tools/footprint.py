@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Report the flash and RAM footprint of ble-cliapp per command suite and per
+command from the map file produced by the GCC_ARM linker.
+
+usage: footprint.py [--source <dir>] [--commands] [--json] <map file>
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+# object file of each command suite
+SUITES = {
+    "Commands/BLECommands": "ble",
+    "Commands/GapCommands": "gap",
+    "Commands/GattServerCommands": "gattServer",
+    "Commands/GattClientCommands": "gattClient",
+    "Commands/SecurityManagerCommands": "securityManager",
+    "Commands/parameters/AdvertisingParameters": "advParams",
+    "Commands/parameters/AdvDataBuilder": "advDataBuilder",
+    "Commands/parameters/ScanParameters": "scanParams",
+    "Commands/parameters/ConnectionParameters": "connectionParams",
+}
+
+# sections which are not loaded on the target
+IGNORED_SECTIONS = (".debug", ".comment", ".ARM.attributes", ".stab")
+
+SECTION_RE = re.compile(r"^ (?P<section>[.\w][^\s]*)(?:\s+(?P<address>0x[0-9a-fA-F]+)\s+(?P<size>0x[0-9a-fA-F]+)\s+(?P<object>.+))?$")
+SIZE_RE = re.compile(r"^\s+(?P<address>0x[0-9a-fA-F]+)\s+(?P<size>0x[0-9a-fA-F]+)\s+(?P<object>.+)$")
+DECLARE_CMD_RE = re.compile(r"DECLARE_CMD\((?P<cls>\w+)\)\s*\{\s*CMD_NAME\(\"(?P<name>\w+)\"\)")
+# In a mangled name, the command class is a source name nested in the
+# anonymous namespace of the suite (N12_GLOBAL__N_1), possibly cv or ref
+# qualified (NK...); the anchor prevents 7Connect from matching inside
+# 13ConnectToMany.
+MANGLED_CLASS_ANCHOR = r"N[rVKRO]*(?:12_GLOBAL__N_1)?"
+
+
+def memory_of(section):
+    """Return the flash and RAM consumed by an input section of a given size
+    as a pair of factors."""
+    if section.startswith((".text", ".rodata", ".ARM.extab", ".ARM.exidx", ".init", ".fini")):
+        return 1, 0
+    if section.startswith(".data"):
+        # initial values of .data are stored in flash
+        return 1, 1
+    if section.startswith((".bss", "COMMON", ".heap", ".stack")):
+        return 0, 1
+    return 0, 0
+
+
+def parse_map(path):
+    """Yield the input sections of the map file as (section, size, object)."""
+    with open(path) as f:
+        lines = f.read().splitlines()
+
+    try:
+        start = lines.index("Linker script and memory map")
+    except ValueError:
+        sys.exit("%s is not a GNU ld map file" % path)
+
+    pending = None
+    for line in lines[start + 1:]:
+        if pending:
+            section, pending = pending, None
+            match = SIZE_RE.match(line)
+            if match:
+                yield section, int(match.group("size"), 16), match.group("object").strip()
+                continue
+
+        match = SECTION_RE.match(line)
+        if not match:
+            continue
+
+        section = match.group("section")
+        if section.startswith(IGNORED_SECTIONS):
+            continue
+        if match.group("size") is None:
+            # long section names are followed by their size on the next line
+            pending = section
+            continue
+        yield section, int(match.group("size"), 16), match.group("object").strip()
+
+
+def suite_of(obj):
+    """Return the name of the group owning an object file."""
+    path = obj.replace("\\", "/")
+    for suite_object, suite in SUITES.items():
+        if path.endswith(suite_object + ".o"):
+            return suite
+    if "/mbed-os/" in path or "/mbed-os(" in path:
+        return "mbed-os"
+    if "/source/" in path or "/core-util/" in path:
+        return "cliapp"
+    return "toolchain"
+
+
+def load_commands(source):
+    """Return, for each suite, the commands declared in its source file as a
+    list of (mangled class name pattern, command name)."""
+    commands = {}
+    for suite_object, suite in SUITES.items():
+        path = os.path.join(source, suite_object + ".cpp")
+        if not os.path.exists(path):
+            continue
+        with open(path) as f:
+            content = f.read()
+        commands[suite] = [
+            (re.compile(MANGLED_CLASS_ANCHOR + "%d%s" % (len(m.group("cls")), m.group("cls"))), m.group("name"))
+            for m in DECLARE_CMD_RE.finditer(content)
+        ]
+    return commands
+
+
+def command_of(section, commands):
+    """Return the command owning a function or data section, symbols are
+    matched on the class name of the command in the mangled section name."""
+    for pattern, name in commands:
+        if pattern.search(section):
+            return name
+    return None
+
+
+def analyze(map_file, source):
+    commands = load_commands(source)
+    suites = {}
+    per_command = {}
+
+    for section, size, obj in parse_map(map_file):
+        flash, ram = memory_of(section)
+        if not flash and not ram:
+            continue
+
+        suite = suite_of(obj)
+        entry = suites.setdefault(suite, {"flash": 0, "ram": 0})
+        entry["flash"] += flash * size
+        entry["ram"] += ram * size
+
+        if suite in commands:
+            command = command_of(section, commands[suite]) or "<suite>"
+            entry = per_command.setdefault(suite, {}).setdefault(command, {"flash": 0, "ram": 0})
+            entry["flash"] += flash * size
+            entry["ram"] += ram * size
+
+    return suites, per_command
+
+
+def print_table(title, rows):
+    print(title)
+    print("%-45s %10s %10s" % ("", "flash", "ram"))
+    for name, entry in sorted(rows.items(), key=lambda item: -item[1]["flash"]):
+        print("%-45s %10d %10d" % (name, entry["flash"], entry["ram"]))
+    print("%-45s %10d %10d" % (
+        "total",
+        sum(entry["flash"] for entry in rows.values()),
+        sum(entry["ram"] for entry in rows.values())
+    ))
+    print("")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map_file", help="map file of the application, e.g. BUILD/<target>/GCC_ARM-TOOLCHAINS_PROFILE/ble-cliapp.map")
+    parser.add_argument("--source", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "source"),
+                        help="source directory of ble-cliapp, used to find the commands of each suite")
+    parser.add_argument("--commands", action="store_true", help="report the footprint of each command")
+    parser.add_argument("--json", action="store_true", help="print the report as a JSON document")
+    args = parser.parse_args()
+
+    suites, per_command = analyze(args.map_file, args.source)
+
+    if args.json:
+        report = {"suites": suites}
+        if args.commands:
+            report["commands"] = per_command
+        print(json.dumps(report, indent=4, sort_keys=True))
+        return
+
+    print_table("Footprint per suite", suites)
+    if args.commands:
+        for suite in sorted(per_command):
+            print_table("Footprint of the %s commands" % suite, per_command[suite])
+
+
+if __name__ == "__main__":
+    main()
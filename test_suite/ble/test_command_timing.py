@@ -0,0 +1,54 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+import pytest
+
+
+def enable_timing(ble, enable):
+    result = ble.enableCommandTiming(enable)
+    if not result.success():
+        pytest.skip("ble-cliapp compiled without command timing")
+    # the responses of enableCommandTiming are never timed
+    assert result.timing is None
+
+
+@pytest.mark.ble41
+def test_command_timing(device, request):
+    """responses received while the timing is enabled report ordered phase times"""
+    ble = device.ble
+    # the session may have enabled the timing already (--command_timing)
+    enable_timing(ble, False)
+    assert ble.getVersion().timing is None
+
+    enable_timing(ble, True)
+    try:
+        version = ble.getVersion()
+        assert version.success()
+        timing = version.timing
+        assert timing is not None
+        assert "procedure" not in timing
+        assert 0 <= timing["handler"] <= timing["result"] <= timing["close"]
+
+        init = ble.init()
+        assert init.success()
+        timing = init.timing
+        assert timing is not None
+        assert 0 <= timing["handler"] <= timing["procedure"] <= timing["close"]
+    finally:
+        if not request.config.getoption('command_timing'):
+            enable_timing(ble, False)
+
+    ble.shutdown()
@@ -0,0 +1,44 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+import pytest
+
+
+@pytest.mark.ble41
+def test_diagnostics(device):
+    """getDiagnostics reports a painted stack, an event queue within its capacity and the heap used by init"""
+    ble = device.ble
+    assert ble.resetDiagnostics().success()
+    before = ble.getDiagnostics().result
+
+    stack = before["stack"]
+    assert stack["painted"]
+    assert 0 < stack["current"] <= stack["peak"] <= stack["size"]
+    assert stack["free"] == stack["size"] - stack["peak"]
+
+    queue = before["event_queue"]
+    assert queue["size"] <= queue["peak"] <= queue["capacity"]
+    assert queue["failed_posts"] == 0
+
+    ble.init()
+    after = ble.getDiagnostics().result
+    ble.shutdown()
+
+    assert after["stack"]["peak"] >= stack["peak"]
+    if before["heap"]["enabled"]:
+        assert after["heap"]["peak"] >= after["heap"]["current"]
+        assert after["heap"]["allocated"] >= before["heap"]["allocated"]
+        assert after["heap"]["failed_allocations"] == before["heap"]["failed_allocations"]
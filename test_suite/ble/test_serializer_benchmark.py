@@ -0,0 +1,37 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+import json
+
+import pytest
+
+NOT_IMPLEMENTED = -3
+
+
+@pytest.mark.ble41
+def test_serializer_indexes_match_linear_search(device):
+    """the indexed toString and fromString of every enum serializer match a linear search of its mapping"""
+    # the command is not implemented unless compiled with ENABLE_SERIALIZER_BENCHMARK,
+    # accept any retcode
+    lines = device.send('ble benchmarkSerializers 1', 'retcode: ')
+    response = json.loads("".join(lines[:-1]))
+    if response['status'] == NOT_IMPLEMENTED:
+        pytest.skip("ble-cliapp compiled without the serializer benchmark")
+
+    serializers = response['result']
+    assert len(serializers) > 0
+    for serializer in serializers:
+        assert serializer["consistent"], serializer["type"]
@@ -0,0 +1,375 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+"""Store of benchmark results and detection of performance regressions.
+
+Tests publish their measurements with record_property. When pytest is invoked
+with --baseline_store=<file>, the numeric values recorded by the tests which
+pass are flattened into metrics. With --baseline_record, they are appended to
+the store as JSON lines keyed by target, firmware and test.
+
+With --baseline_check, the metrics of the run are compared against the latest
+runs of the same target and test held in the store. Throughput metrics must not
+drop, latency, duration and memory metrics must not rise, by more than the
+tolerance. When the baseline holds several runs, the change must also exceed
+the noise of the baseline: z sample standard deviations from its mean.
+Regressions are printed at the end of the run and fail it.
+
+Firmwares already in the store can be compared offline:
+
+    python -m common.baseline --store baseline.jsonl --firmware <new> --reference <old>
+"""
+
+import argparse
+import fnmatch
+import hashlib
+import json
+import math
+import sys
+import time
+from collections import OrderedDict
+from typing import Any, Iterable, List, Mapping, Optional
+
+import pytest
+from prettytable import PrettyTable
+
+# Direction of the metrics whose name does not tell it, as glob patterns of the
+# metric name; checked first, 0 excludes a metric from the comparison.
+DIRECTIONS = OrderedDict([
+    # durations, in µs, of the phases of the pairing
+    ('pairing_benchmark.authentication.*', -1),
+    ('pairing_benchmark.encryption.*', -1),
+    ('pairing_benchmark.key_distribution.*', -1),
+    ('pairing_benchmark.total.*', -1),
+    ('pairing_benchmark.failures', -1),
+    # durations, in µs, of the restoration of the bond table and of the
+    # generation of the whitelist, then the accesses to the block device
+    ('bond_table_scaling.*.restore.*', -1),
+    ('bond_table_scaling.*.whitelist.*', -1),
+    ('bond_table_scaling.*.block_device.*', -1),
+    # counters of the throughput probe which are not a throughput
+    ('perf_sweep.*.throughput.lost', -1),
+    ('perf_sweep.*.throughput.retries', -1),
+    ('perf_sweep.*.throughput.backoff', -1),
+    ('perf_sweep.*.throughput.server_interval.*', -1),
+    ('perf_sweep.*.throughput.sent', 0),
+    ('perf_sweep.*.throughput.received', 0),
+])
+# Otherwise the direction of a metric is given by the first of these words
+# found in the components of its name, from the last one; the words of a
+# component are separated by '_'. Metrics which match none are stored but not
+# compared.
+HIGHER_IS_BETTER = ('throughput', 'goodput')
+LOWER_IS_BETTER = ('latency', 'duration', 'round', 'heap', 'stack', 'memory', 'ram', 'flash')
+# Components of distributions which are not measurements
+IGNORED_COMPONENTS = ('count', 'buckets')
+# Fields identifying the configuration of the rows of a benchmark recorded as a
+# list; a row is keyed by their values rather than its position, so a row added
+# or skipped does not shift the metrics of the others.
+ROW_KEYS = {
+    'perf_sweep': ('phy', 'att_mtu', 'interval', 'payload'),
+    'bond_table_scaling': ('bonds',),
+}
+
+DEFAULT_PLATFORMS = 'DISCO_L475VG_IOT01A,NRF52840_DK'
+DEFAULT_TOLERANCE = 10.0
+DEFAULT_Z = 3.0
+# Number of the latest runs of a test forming its baseline
+DEFAULT_WINDOW = 10
+
+
+def flatten_metrics(value: Any, prefix: str = '') -> Mapping[str, float]:
+    """Numeric values of a recorded property keyed by their dotted path. The
+    rows of the properties listed in ROW_KEYS are keyed by their configuration,
+    e.g. perf_sweep.phy=LE_2M,att_mtu=247,interval=6,payload=244.latency.mean"""
+    metrics = OrderedDict()  # type: OrderedDict[str, float]
+    if isinstance(value, bool):
+        return metrics
+    if isinstance(value, (int, float)):
+        metrics[prefix] = value
+    elif isinstance(value, Mapping):
+        for key, child in value.items():
+            if key not in IGNORED_COMPONENTS:
+                metrics.update(flatten_metrics(child, '{}.{}'.format(prefix, key) if prefix else str(key)))
+    elif isinstance(value, (list, tuple)):
+        keys = ROW_KEYS.get(prefix, ())
+        for index, child in enumerate(value):
+            row = str(index)
+            if keys and isinstance(child, Mapping) and all(key in child for key in keys):
+                row = ','.join('{}={}'.format(key, child[key]) for key in keys)
+                child = OrderedDict((key, field) for key, field in child.items() if key not in keys)
+            metrics.update(flatten_metrics(child, '{}.{}'.format(prefix, row) if prefix else row))
+    return metrics
+
+
+def direction_of(metric: str) -> int:
+    """1 if a metric should not decrease, -1 if it should not increase and 0 if
+    it is not compared."""
+    metric = metric.lower()
+    for pattern, direction in DIRECTIONS.items():
+        if fnmatch.fnmatchcase(metric, pattern):
+            return direction
+
+    for component in reversed(metric.split('.')):
+        words = component.split('_')
+        if any(word in HIGHER_IS_BETTER for word in words):
+            return 1
+        if any(word in LOWER_IS_BETTER for word in words):
+            return -1
+    return 0
+
+
+def firmware_id(binaries: Mapping[str, str]) -> str:
+    """Short hash of the binaries flashed on the boards."""
+    if not binaries:
+        return 'unknown'
+    digest = hashlib.sha256()
+    for platform in sorted(binaries):
+        digest.update(platform.encode())
+        with open(binaries[platform], 'rb') as f:
+            digest.update(f.read())
+    return digest.hexdigest()[:12]
+
+
+def mean(samples: List[float]) -> float:
+    return sum(samples) / len(samples)
+
+
+class BaselineStore:
+    """Results of the benchmark runs, one JSON document per test and run."""
+
+    def __init__(self, path: str):
+        self.path = path
+
+    def load(self) -> List[Mapping[str, Any]]:
+        try:
+            with open(self.path) as f:
+                return [json.loads(line, object_pairs_hook=OrderedDict) for line in f if line.strip()]
+        except FileNotFoundError:
+            return []
+
+    def append(self, records: Iterable[Mapping[str, Any]]):
+        with open(self.path, 'a') as f:
+            for record in records:
+                f.write(json.dumps(record) + '\n')
+
+
+def select(records: Iterable[Mapping[str, Any]], target: Optional[str] = None, firmware: Optional[str] = None,
+           test: Optional[str] = None) -> List[Mapping[str, Any]]:
+    """Records matching the keys given, in the order of the store."""
+    return [
+        record for record in records
+        if (target is None or record['target'] == target) and
+           (firmware is None or record['firmware'] == firmware) and
+           (test is None or record['test'] == test)
+    ]
+
+
+class Regression:
+    def __init__(self, test: str, metric: str, value: float, baseline: List[float], change: float):
+        self.test = test
+        self.metric = metric
+        self.value = value
+        self.baseline = baseline
+        # relative change in percent, positive when the metric gets worse
+        self.change = change
+
+
+def compare(test: str, metrics: Mapping[str, float], baseline: List[Mapping[str, Any]],
+            tolerance: float = DEFAULT_TOLERANCE, z: float = DEFAULT_Z) -> List[Regression]:
+    """Metrics of a run which regressed against the runs of a baseline."""
+    regressions = []
+    for metric, value in metrics.items():
+        direction = direction_of(metric)
+        if not direction:
+            continue
+
+        samples = [record['metrics'][metric] for record in baseline if metric in record['metrics']]
+        if not samples or mean(samples) == 0:
+            continue
+
+        reference = mean(samples)
+        change = (reference - value) / abs(reference) * 100 * direction
+        if change <= tolerance:
+            continue
+
+        if len(samples) > 1:
+            deviation = math.sqrt(sum((sample - reference) ** 2 for sample in samples) / (len(samples) - 1))
+            if abs(value - reference) <= z * deviation:
+                continue
+
+        regressions.append(Regression(test, metric, value, samples, change))
+    return regressions
+
+
+def regressions_table(regressions: List[Regression]) -> PrettyTable:
+    table = PrettyTable(['test', 'metric', 'runs', 'baseline', 'value', 'change %'])
+    table.align = 'r'
+    table.align['test'] = 'l'
+    table.align['metric'] = 'l'
+    for regression in regressions:
+        table.add_row([
+            regression.test, regression.metric, len(regression.baseline),
+            '{:.1f}'.format(mean(regression.baseline)), '{:.1f}'.format(regression.value),
+            '{:+.1f}'.format(regression.change)
+        ])
+    return table
+
+
+class BaselineRecorder:
+    """Collect the metrics of the tests of a run."""
+
+    def __init__(self, store: BaselineStore, target: str, firmware: str):
+        self.store = store
+        self.target = target
+        self.firmware = firmware
+        self.records = []  # type: List[Mapping[str, Any]]
+
+    def add(self, test: str, properties: Iterable[Any]):
+        metrics = OrderedDict()  # type: OrderedDict[str, float]
+        for name, value in properties:
+            metrics.update(flatten_metrics(value, name))
+        if not metrics:
+            return
+        self.records.append(OrderedDict([
+            ('target', self.target),
+            ('firmware', self.firmware),
+            ('test', test),
+            ('date', time.strftime('%Y-%m-%dT%H:%M:%S')),
+            ('metrics', metrics),
+        ]))
+
+    def check(self, reference: Optional[str], tolerance: float, z: float,
+              window: int = DEFAULT_WINDOW) -> List[Regression]:
+        """Compare the run to the latest runs stored, of the reference firmware if given."""
+        stored = select(self.store.load(), target=self.target, firmware=reference)
+        regressions = []
+        for record in self.records:
+            baseline = select(stored, test=record['test'])[-window:]
+            regressions += compare(record['test'], record['metrics'], baseline, tolerance, z)
+        return regressions
+
+
+def _recorder(config) -> Optional[BaselineRecorder]:
+    return getattr(config, 'baseline_recorder', None)
+
+
+def pytest_configure(config):
+    path = config.getoption('baseline_store')
+    if not path:
+        return
+
+    binaries = {}
+    if config.getoption('binaries'):
+        binaries = dict(pb.split('=') for pb in config.getoption('binaries').split(','))
+    platforms = (config.getoption('platforms') or DEFAULT_PLATFORMS).split(',')
+
+    config.baseline_recorder = BaselineRecorder(
+        BaselineStore(path),
+        target='+'.join(sorted(platforms)),
+        firmware=config.getoption('baseline_firmware') or firmware_id(binaries)
+    )
+    config.baseline_regressions = []
+
+
+@pytest.hookimpl(hookwrapper=True)
+def pytest_runtest_makereport(item, call):
+    outcome = yield
+    recorder = _recorder(item.config)
+    report = outcome.get_result()
+    if recorder is not None and report.when == 'call' and report.passed:
+        recorder.add(item.nodeid, item.user_properties)
+
+
+def pytest_sessionfinish(session, exitstatus):
+    config = session.config
+    recorder = _recorder(config)
+    if recorder is None:
+        return
+
+    # the run is compared before it is stored so it is not part of its own baseline
+    if config.getoption('baseline_check'):
+        config.baseline_regressions = recorder.check(
+            config.getoption('baseline_reference'),
+            float(config.getoption('baseline_tolerance')),
+            float(config.getoption('baseline_z'))
+        )
+        if config.baseline_regressions and session.exitstatus == 0:
+            session.exitstatus = 1
+
+    if config.getoption('baseline_record'):
+        recorder.store.append(recorder.records)
+
+
+def pytest_terminal_summary(terminalreporter, exitstatus, config):
+    recorder = _recorder(config)
+    if recorder is None:
+        return
+    terminalreporter.write_sep('=', 'baseline of {} on {}: {} tests measured'.format(
+        recorder.firmware, recorder.target, len(recorder.records)
+    ))
+    if config.baseline_regressions:
+        terminalreporter.write_line('Performance regressions:', red=True)
+        terminalreporter.write_line(regressions_table(config.baseline_regressions).get_string())
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare the runs of a firmware stored in a baseline to the runs of '
+                                                 'another firmware')
+    parser.add_argument('--store', required=True, help='baseline store, a JSON lines file')
+    parser.add_argument('--firmware', required=True, help='firmware to check')
+    parser.add_argument('--reference', help='firmware of the baseline, every other firmware by default')
+    parser.add_argument('--target', help='target of the runs, every target by default')
+    parser.add_argument('--tolerance', type=float, default=DEFAULT_TOLERANCE,
+                        help='change tolerated, in percent, default %(default)s')
+    parser.add_argument('--z', type=float, default=DEFAULT_Z,
+                        help='standard deviations of the baseline a change must exceed, default %(default)s')
+    parser.add_argument('--window', type=int, default=DEFAULT_WINDOW,
+                        help='number of the latest runs compared, default %(default)s')
+    args = parser.parse_args()
+
+    records = select(BaselineStore(args.store).load(), target=args.target)
+    checked = select(records, firmware=args.firmware)
+    if not checked:
+        sys.exit('no run of firmware {} in {}'.format(args.firmware, args.store))
+
+    regressions = []
+    keys = OrderedDict(((record['target'], record['test']), None) for record in checked)
+    for target, test in keys:
+        runs = select(checked, target=target, test=test)[-args.window:]
+        baseline = [
+            record for record in select(records, target=target, firmware=args.reference, test=test)
+            if record['firmware'] != args.firmware
+        ][-args.window:]
+
+        # the metrics of the runs checked are averaged
+        metrics = OrderedDict()  # type: OrderedDict[str, List[float]]
+        for run in runs:
+            for metric, value in run['metrics'].items():
+                metrics.setdefault(metric, []).append(value)
+        metrics = OrderedDict((metric, mean(values)) for metric, values in metrics.items())
+
+        regressions += compare('{} [{}]'.format(test, target), metrics, baseline, args.tolerance, args.z)
+
+    if not regressions:
+        print('No regression of {} in {} tests'.format(args.firmware, len(keys)))
+        return
+    print(regressions_table(regressions).get_string())
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -14,9 +14,9 @@
 # limitations under the License.
 
 import json
-import queue
+import weakref
 from time import sleep
-from typing import List, Optional
+from typing import Any, Iterator, List, Optional
 
 from .device import Device
 
@@ -24,6 +24,8 @@ from .device import Device
 LEGACY_ADVERTISING_HANDLE = 0
 ADV_DURATION_FOREVER = 0
 ADV_MAX_EVENTS_UNLIMITED = 0
+# Time allowed to a procedure to end once its response is abandoned, in seconds
+ABORT_TIMEOUT = 5
 
 
 class CommandResult:
@@ -43,11 +45,19 @@ class CommandResult:
     is accessed then the process block until a response is available or timeout.
     The lazy initialization prevent this behaviour and allow the application to
     launch several commands on multiple DUT before blocking.
+
+    If the board reports command timings (ble enableCommandTiming) then they
+    are available in the timing attribute and forwarded to the callables
+    registered in timing_listeners along with the command.
     """
 
-    def __init__(self, response):
+    # Callables invoked with the command and its timing when a result is parsed
+    timing_listeners = []
+
+    def __init__(self, response, command: Optional[str] = None):
         """Initialize the instance with a response issued from a command. """
         self.__response = response
+        self.__command = command
         self.__initialized = False
 
     # pylint: disable=W0201,I0011
@@ -65,8 +75,68 @@ class CommandResult:
         self.status = json_response['status']
         self.error = json_response.get('error')
         self.result = json_response.get('result')
+        self.timing = json_response.get('timing')
         self.__initialized = True
 
+        if self.timing is not None:
+            for listener in CommandResult.timing_listeners:
+                listener(self.__command, self.timing)
+
+    def stream(self) -> Iterator[Any]:
+        """Iterate over the elements of an array result as soon as they are
+        received.
+        ble-cliapp prints each element of long running procedures results
+        (scanForAddress, scanForData, listenHVX, ...) on its own line; these
+        lines are decoded individually. This allows user code to act on an
+        element - and stop the iteration - before the end of the command:
+
+            res = dev.gap.scanForAddress.setAsync()(address, 30000)
+            for report in res.stream():
+                if report['scan_response']:
+                    break
+
+        The command result remains available once the command completes.
+        If the result is not framed per element, the elements are yielded once
+        the whole result has been received.
+
+        Stopping the iteration early - on break or when the generator is
+        collected - ends the procedure on the board (see
+        Device.abort_commands) then the rest of the response is read until
+        its retcode, so the iteration returns without waiting for the timeout
+        of the command. The result then holds what the procedure reported
+        when it was ended.
+        """
+        if self.__initialized is False and hasattr(self.__response, 'stream'):
+            streamed = False
+            lines = self.__response.stream()
+            try:
+                for line in lines:
+                    element = CommandResult.__decode_element(line)
+                    if element is not None:
+                        streamed = True
+                        yield element
+            finally:
+                # drain the response if the iteration has been stopped
+                lines.close()
+            if streamed:
+                return
+
+        if isinstance(self.result, list):
+            yield from self.result
+
+    @staticmethod
+    def __decode_element(line: str) -> Optional[Any]:
+        """Decode the array element contained in a line or return None if the
+        line doesn't contain a complete element."""
+        line = line.strip().lstrip(',')
+        if not line.startswith('{') and not line.startswith('['):
+            return None
+        try:
+            return json.loads(line)
+        except ValueError:
+            # the response header or a partial line
+            return None
+
     def success(self):
         """Returns true if the command succeed and false otherwise.
         Warning: will block the process until a response is available or the
@@ -269,34 +339,37 @@ class BleDevice(Device):
     # Modules and their command
     COMMAND_MODULES = {
         "ble": [
-            "shutdown", "init", "reset", "getVersion", "createFilesystem"
+            "shutdown", "init", "reset", "resetState", "getVersion", "enableCommandTiming", "benchmarkSerializers",
+            "createFilesystem", "getDiagnostics", "resetDiagnostics"
         ],
         "gap": [
-            "getAddress", "getMaxWhitelistSize", "getWhitelist", "setWhitelist",
+            "getAddress", "setRandomStaticAddress", "getMaxWhitelistSize", "getWhitelist", "setWhitelist",
             "enablePrivacy", "setPeripheralPrivacyConfiguration", "getPeripheralPrivacyConfiguration",
             "setCentralPrivacyConfiguration", "setPhy", "setPreferredPhys", "readPhy", "getMaxAdvertisingSetNumber",
             "getMaxAdvertisingDataLength", "createAdvertisingSet", "destroyAdvertisingSet",
-            "setAdvertisingParameters", "setAdvertisingPayload", "applyAdvPayloadFromBuilder", "setAdvertisingScanResponse",
-            "applyScanRespFromBuilder", "startAdvertising", "stopAdvertising", "isAdvertisingActive",
-            "setPeriodicAdvertisingParameters", "setPeriodicAdvertisingPayload", "startPeriodicAdvertising",
+            "setAdvertisingParameters", "setAdvertisingPayload", "applyAdvPayloadFromBuilder", "applyAdvPayloadToSets",
+            "setAdvertisingScanResponse", "applyScanRespFromBuilder", "startAdvertising", "stopAdvertising", "provisionAdvertisingSets",
+            "isAdvertisingActive", "setPeriodicAdvertisingParameters", "setPeriodicAdvertisingPayload", "startPeriodicAdvertising",
             "stopPeriodicAdvertising", "isPeriodicAdvertisingActive", "setScanParameters",
-            "startScan", "scanForAddress", "scanForData", "stopScan", "createSync", "createSyncFromList",
-            "cancelCreateSync", "terminateSync", "addDeviceToPeriodicAdvertiserList",
+            "startScan", "scanForAddress", "scanForData", "analyzeAdvertisingInterval", "stopScan", "createSync", "createSyncFromList",
+            "cancelCreateSync", "terminateSync", "monitorPeriodicSync",
+            "addDeviceToPeriodicAdvertiserList",
             "removeDeviceFromPeriodicAdvertiserList", "clearPeriodicAdvertiserList",
             "getMaxPeriodicAdvertiserListSize", "connect", "waitForConnection",
-            "startConnecting", "cancelConnect", "waitForDisconnection",
+            "startConnecting", "cancelConnect", "waitForDisconnection", "connectToMany",
             "updateConnectionParameters", "manageConnectionParametersUpdateRequest",
             "acceptConnectionParametersUpdate", "rejectConnectionParametersUpdate",
-            "disconnect", "isFeatureSupported", "isRadioActive"
+            "disconnect", "getConnectionStatistics", "isFeatureSupported", "isRadioActive"
         ],
         "gattClient": [
             "discoverAllServicesAndCharacteristics", "discoverAllServices",
-            "discoverPrimaryServicesByUUID", "findIncludedServices",
-            "discoverCharacteristicsOfService", "discoverCharacteristicsByUUID",
-            "discoverAllCharacteristicsDescriptors", "readCharacteristicValue",
-            "readUsingCharacteristicUUID", "readLongCharacteristicValue",
-            "readMultipleCharacteristicValues", "writeWithoutResponse",
-            "signedWriteWithoutResponse", "write", "writeLong", "reliableWrite",
+            "getDiscoveryCache", "flushDiscoveryCache", "discoverPrimaryServicesByUUID",
+            "findIncludedServices", "discoverCharacteristicsOfService",
+            "discoverCharacteristicsByUUID", "discoverAllCharacteristicsDescriptors",
+            "readCharacteristicValue", "readUsingCharacteristicUUID",
+            "readLongCharacteristicValue", "readMultipleCharacteristicValues",
+            "writeWithoutResponse", "signedWriteWithoutResponse",
+            "writeWithoutResponseBurst", "write", "writeLong", "reliableWrite",
             "readCharacteristicDescriptor", "readLongCharacteristicDescriptor",
             "writeCharacteristicDescriptor", "writeLongCharacteristicDescriptor",
             "negotiateAttMtu", "enableUnsolicitedHVX"
@@ -308,14 +381,16 @@ class BleDevice(Device):
             "setCharacteristicMaxLength", "declareDescriptor",
             "setDescriptorValue", "setDescriptorVariableLength",
             "setDescriptorMaxLength", "commitService", "cancelServiceDeclaration",
-            "read", "write", "waitForDataWritten", "setCharacteristicSecurity"
+            "read", "dumpDatabase", "write", "waitForDataWritten", "countWrites",
+            "setCharacteristicSecurity"
         ],
         "securityManager": [
             "init", "preserveBondingStateOnReset", "purgeAllBondingState",
-            "generateWhitelistFromBondTable", "setPairingRequestAuthorisation",
+            "generateWhitelistFromBondTable", "benchmarkBondTable", "setPairingRequestAuthorisation",
             "waitForEvent", "acceptPairingRequestAndWait", "rejectPairingRequest", "enterConfirmationAndWait",
-            "enterPasskeyAndWait", "requestPairingAndWait", "allowLegacyPairing", "getSecureConnectionsSupport",
-            "setIoCapability", "setDisplayPasskey", "setLinkEncryptionAndWait", "setDatabaseFilepath"
+            "enterPasskeyAndWait", "requestPairingAndWait", "setAutoPairing", "benchmarkPairing", "allowLegacyPairing",
+            "getSecureConnectionsSupport", "setIoCapability", "setDisplayPasskey", "setLinkEncryptionAndWait",
+            "setDatabaseFilepath"
         ],
         "advParams": [
             "reset", "setType", "setPrimaryInterval", "setPrimaryChannels", "setOwnAddressType",
@@ -323,6 +398,7 @@ class BleDevice(Device):
             "setUseLegacyPDU", "includeTxPowerInHeader", "setAnonymousAdvertising"
         ],
         "advDataBuilder": [
+            "selectSet", "selectDefault", "getCapacity", "setPayload",
             "getAdvertisingData", "addData", "appendData", "removeData", "addOrReplaceData", "addOrAppendData",
             "clear", "setAppearance", "setFlags", "setTxPowerAdvertised", "setName", "setManufacturerSpecificData",
             "setAdvertisingInterval", "setConnectionIntervalPreference", "setServiceData",
@@ -337,7 +413,8 @@ class BleDevice(Device):
         """Create a new BLEDevice instance."""
         self.device = device
         self.command_delay = command_delay
-        self.events = queue.Queue()
+        # events are routed by the device dispatcher and never flushed
+        self.events = device.events
 
     def command(self, cmd: str, expected_retcode: int = 0, async_command: bool = False) -> CommandResult:
         """Send a command to the device and return a CommandResult.
@@ -351,21 +428,49 @@ class BleDevice(Device):
 
         if async_command:
             sleep(self.command_delay)
-            self.device.send(cmd)
+            command_id = self.device.submit(cmd)
 
             class AsynchronousResponse:
                 def __init__(self, device):
                     self.initialized = False
                     self.device = device
-                    self._lines = None
+                    self._lines = []
+                    self._output = None
+                    # the response is dropped by the device if it is never read
+                    weakref.finalize(self, device.device.release, command_id)
 
                 @property
                 def lines(self):
                     if not self.initialized:
-                        self._lines = self.device.wait_for_output('retcode: ' + str(expected_retcode))
-                        self.initialized = True
+                        for _ in self.stream():
+                            pass
                     return self._lines
 
+                def stream(self):
+                    """Yield the lines of the response as they are received.
+                    If the generator is closed before the retcode, the command
+                    is ended on the board then the rest of the response is read
+                    and kept before it returns."""
+                    if self._output is None:
+                        self._output = self.device.iter_output('retcode: ' + str(expected_retcode),
+                                                               command_id=command_id)
+                    complete = False
+                    try:
+                        for line in self._output:
+                            self._lines.append(line)
+                            yield line
+                        complete = True
+                    finally:
+                        if not complete and not self.initialized:
+                            self._drain()
+                        self.initialized = True
+
+                def _drain(self):
+                    self._output.close()
+                    self.device.device.abort_commands(ABORT_TIMEOUT, command_id)
+                    # the retcode of a procedure ended early may not be the one expected
+                    self._lines.extend(self.device.iter_output('retcode: ', ABORT_TIMEOUT, False, command_id))
+
             response = AsynchronousResponse(self)
 
         else:
@@ -377,7 +482,11 @@ class BleDevice(Device):
                 self.send(cmd, 'retcode: ' + str(expected_retcode))
             )
 
-        return CommandResult(response)
+        result = CommandResult(response, cmd)
+        # synchronous responses are available, parse them so their timing is not lost
+        if CommandResult.timing_listeners and not async_command:
+            result.success()
+        return result
 
     def __getattr__(self, module_name: str) -> BleCommandModule:
         """Dynamically generate attributes of command modules.
@@ -394,24 +503,14 @@ class BleDevice(Device):
     # Add the proxy methods
     def send(self, command, expected_output=None, wait_before_read=None, wait_for_response=30, assert_output=True):
         sleep(self.command_delay)
-        lines = self.device.send(command, expected_output, wait_before_read, wait_for_response, assert_output)
-        return self._filter_events(lines)
+        return self.device.send(command, expected_output, wait_before_read, wait_for_response, assert_output)
 
     def flush(self, timeout: float = 0) -> [str]:
-        lines = self.device.send(timeout)
-        return self._filter_events(lines)
+        return self.device.flush(timeout)
 
     def wait_for_output(self, search: str, timeout: float = 30, assert_timeout: bool = True) -> [str]:
-        lines = self.device.wait_for_output(search, timeout, assert_timeout)
-        return self._filter_events(lines)
+        return self.device.wait_for_output(search, timeout, assert_timeout)
 
-    def _filter_events(self, lines: List[str]) -> Optional[List[str]]:
-        if lines is None:
-            return None
-        unfiltered_lines = []
-        for line in lines:
-            if line.startswith('<<<'):
-                self.events.put(line[len('<<<'):])
-            else:
-                unfiltered_lines.append(line)
-        return unfiltered_lines
+    def iter_output(self, search: str, timeout: float = 30, assert_timeout: bool = True,
+                    command_id: Optional[int] = None) -> Iterator[str]:
+        return self.device.iter_output(search, timeout, assert_timeout, command_id)
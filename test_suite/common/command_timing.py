@@ -0,0 +1,94 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+"""Report the execution time of ble-cliapp commands.
+
+When pytest is invoked with --command_timing, boards report the timing of every
+command (see ble enableCommandTiming). This plugin aggregates them per command
+and prints the 50th, 95th and 99th percentiles of each phase at the end of the
+run.
+"""
+
+from collections import OrderedDict
+from typing import List, Mapping, Optional
+
+from prettytable import PrettyTable
+
+from .ble_device import CommandResult
+
+# Phases reported by the board, in order of occurrence
+PHASES = ['handler', 'result', 'procedure', 'close']
+PERCENTILES = [50, 95, 99]
+
+
+def percentile(samples: List[int], p: int) -> int:
+    """Nearest rank percentile of sorted samples."""
+    rank = max(0, -(-len(samples) * p // 100) - 1)
+    return samples[rank]
+
+
+class CommandTimingRecorder:
+    """Collect command timings reported by the boards.
+    Commands are identified by their module and name, arguments are ignored.
+    """
+
+    def __init__(self):
+        self.samples = OrderedDict()  # type: OrderedDict[str, Mapping[str, List[int]]]
+
+    def __call__(self, command: Optional[str], timing: Mapping[str, int]):
+        if command is None:
+            return
+        name = ' '.join(command.split()[:2])
+        phases = self.samples.setdefault(name, OrderedDict((phase, []) for phase in PHASES))
+        for phase, value in timing.items():
+            phases.setdefault(phase, []).append(value)
+
+    def table(self) -> PrettyTable:
+        columns = ['p{}'.format(p) for p in PERCENTILES]
+        table = PrettyTable(['command', 'phase', 'count'] + columns)
+        table.align = 'r'
+        table.align['command'] = 'l'
+        table.align['phase'] = 'l'
+        for name, phases in sorted(self.samples.items()):
+            for phase, samples in phases.items():
+                if not samples:
+                    continue
+                samples = sorted(samples)
+                table.add_row(
+                    [name, phase, len(samples)] +
+                    ['{:.3f}'.format(percentile(samples, p) / 1000) for p in PERCENTILES]
+                )
+        return table
+
+
+def pytest_configure(config):
+    if config.getoption('command_timing'):
+        config.command_timing_recorder = CommandTimingRecorder()
+        CommandResult.timing_listeners.append(config.command_timing_recorder)
+
+
+def pytest_unconfigure(config):
+    recorder = getattr(config, 'command_timing_recorder', None)
+    if recorder is not None:
+        CommandResult.timing_listeners.remove(recorder)
+
+
+def pytest_terminal_summary(terminalreporter, exitstatus, config):
+    recorder = getattr(config, 'command_timing_recorder', None)
+    if recorder is None or not recorder.samples:
+        return
+    terminalreporter.write_sep('=', 'command timing (ms since the command was received)')
+    terminalreporter.write_line(recorder.table().get_string())
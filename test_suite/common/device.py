@@ -13,27 +13,61 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+
 import logging
 import queue
+import re
+import threading
+from collections import deque
 from time import sleep, time
-from typing import Optional
+from typing import Iterator, Optional, Tuple
 
 log = logging.getLogger(__name__)
 
 
 class Device:
+    # Prefix of the lines carrying asynchronous events
+    EVENT_PREFIX = '<<<'
+    RETCODE_PATTERN = re.compile(r'retcode: (-?\d+)')
+    # Character ending the procedures running on the board (CTRL+C)
+    ABORT = b'\x03'
+
     class BoardCommunicationFailed(Exception):
         pass
 
     def __init__(self, name: Optional[str] = None):
         self.iq = queue.Queue()
         self.oq = queue.Queue()
+        # Events received from the device, never flushed
+        self.events = queue.Queue()
         self.line_read = False
         if name is None:
             self.name = str(hex(id(self)))
         else:
             self.name = name
 
+        # Response lines as (command, line, retcode). The command is the
+        # identifier of the command which printed the line (None if no command
+        # was running) and the retcode is None if the line is not a retcode.
+        self._lines = deque()
+        self._next_command = 0
+        # Commands sent whose retcode hasn't been received, oldest first. The
+        # board runs commands one after the other so the lines received belong
+        # to the oldest one.
+        self._running = deque()
+        # Commands whose response is awaited by a reader
+        self._claimed = set()
+        self._received = threading.Condition()
+        self.dt = threading.Thread(target=self._dispatch_thread, name='<== {}'.format(self.name))
+        self.dt.start()
+
+    def stop(self):
+        """
+        Stop the dispatch of the lines received
+        """
+        self.iq.put(None)
+        self.dt.join()
+
     def send(self, command, expected_output=None, wait_before_read=None, wait_for_response=10, assert_output=True):
         """
         Send command for client
@@ -44,77 +78,206 @@ class Device:
         :param assert_output: Assert the fail situations to end the test run
         :return: If there's expected output then the response line is returned
         """
-        log.debug('{}: Sending command to client: "{}"'.format(self.name, command))
-        self.flush(0)
-        self._write(command)
+        command_id = self.submit(command, claim=expected_output is not None)
         if expected_output is not None:
             if wait_before_read is not None:
                 sleep(wait_before_read)
-            return self.wait_for_output(expected_output, wait_for_response, assert_output)
+            try:
+                return self.wait_for_output(expected_output, wait_for_response, assert_output, command_id)
+            finally:
+                self.release(command_id)
+
+    def submit(self, command, claim: bool = True) -> int:
+        """
+        Send a command without waiting for its response.
+        Response lines nobody claimed are dropped: they belong to commands
+        whose response has been abandoned.
+        :param command: Command
+        :param claim: Keep the response of the command until it is read
+        with the identifier returned or released
+        :return: The identifier of the command
+        """
+        log.debug('{}: Sending command to client: "{}"'.format(self.name, command))
+        with self._received:
+            self._lines = deque(entry for entry in self._lines if entry[0] in self._claimed)
+            command_id = self._next_command
+            self._next_command += 1
+            self._running.append(command_id)
+            if claim:
+                self._claimed.add(command_id)
+        self._write(command)
+        return command_id
+
+    def release(self, command_id: int):
+        """
+        Abandon the response of a command submitted; the lines already
+        received are dropped, the next ones will be dropped by the next command.
+        """
+        with self._received:
+            self._claimed.discard(command_id)
+            self._lines = deque(entry for entry in self._lines if entry[0] != command_id)
+
+    def forget_commands(self):
+        """
+        Forget the commands running, their retcode will never be received
+        (e.g. the board has been reset).
+        """
+        with self._received:
+            self._running.clear()
+            self._lines.clear()
+
+    def abort_commands(self, timeout: float = 5, command_id: Optional[int] = None) -> bool:
+        """
+        End the commands still running on the board and wait for their retcode.
+        :param timeout: Time allowed to the commands to end
+        :param command_id: End only this command; the abort is sent while the
+        board runs it, the commands submitted after it are not affected
+        :return: True if no command (or the command given) is running anymore
+        """
+        deadline = time() + timeout
+        with self._received:
+            while self._running if command_id is None else command_id in self._running:
+                now = time()
+                if now >= deadline:
+                    log.warning('{}: {} command(s) still running'.format(self.name, len(self._running)))
+                    return False
+                if command_id is None or self._running[0] == command_id:
+                    log.debug('{}: Aborting {} running command(s)'.format(self.name, len(self._running)))
+                    self._write(Device.ABORT)
+                self._received.wait(min(deadline - now, 1))
+        return True
 
     def flush(self, timeout: float = 0) -> [str]:
         """
-        Flush the lines in the input queue
+        Flush the response lines received; events are kept.
         :param timeout: The timeout before flushing starts
         :type timeout: float
-        :return: The lines removed from the input queue
+        :return: The lines removed
         :rtype: list of str
         """
         sleep(timeout)
-        lines = []
-        while True:
-            try:
-                lines.append(self._read_line(0))
-            except queue.Empty:
-                return lines
+        with self._received:
+            lines = [line for _, line, _ in self._lines]
+            self._lines.clear()
+        return lines
 
-    def wait_for_output(self, search: str, timeout: float = 10, assert_timeout: bool = True) -> [str]:
+    def wait_for_output(self, search: str, timeout: float = 10, assert_timeout: bool = True,
+                        command_id: Optional[int] = None) -> [str]:
         """
         Wait for expected output response
-        :param search: Expected response string
+        :param search: Expected response string. If it is a retcode line
+        (retcode: <n>) then it is matched against the retcode parsed by the
+        dispatcher.
         :type search: str
         :param timeout: Response waiting time
         :type timeout: float
         :param assert_timeout: Assert on timeout situations
         :type assert_timeout: bool
+        :param command_id: Read only the lines of this command, any line if None
         :return: Line received before a match
         :rtype: list of str
         """
         lines = []
+        for line, matched in self._receive(search, timeout, assert_timeout, command_id):
+            lines.append(line)
+            if matched:
+                return lines
+        return []
+
+    def iter_output(self, search: str, timeout: float = 10, assert_timeout: bool = True,
+                    command_id: Optional[int] = None) -> Iterator[str]:
+        """
+        Same as wait_for_output but yield the lines as soon as they are received.
+        The iteration stops after the line matching search.
+        """
+        for line, _ in self._receive(search, timeout, assert_timeout, command_id):
+            yield line
+
+    def _next_line(self, command_id: Optional[int]) -> Optional[Tuple[Optional[int], str, Optional[int]]]:
+        """Remove and return the first line of a command, or the first line if command_id is None."""
+        if command_id is None:
+            return self._lines.popleft() if self._lines else None
+        for index, entry in enumerate(self._lines):
+            if entry[0] == command_id:
+                del self._lines[index]
+                return entry
+        return None
+
+    def _receive(self, search: str, timeout: float, assert_timeout: bool,
+                 command_id: Optional[int] = None) -> Iterator[Tuple[str, bool]]:
+        """
+        Yield the lines received along with a flag set if the line matches
+        search. The iteration stops after a match or on timeout.
+        """
+        match = Device.RETCODE_PATTERN.fullmatch(search)
+        expected_retcode = int(match.group(1)) if match else None
+
         start = time()
-        now = 0
+        deadline = start + timeout
+        last = start
         timeout_error_msg = '{}: Didn\'t find {} in {} s'.format(self.name, search, timeout)
 
-        while time() - start <= timeout:
-            try:
-                line = self._read_line(1)
-                if line:
-                    # mark the board as communicating so we don't retry
-                    self.line_read = True
-                    lines.append(line)
-                    if search in line:
-                        end = time()
-                        return lines
-
-            except queue.Empty:
-                last = now
-                now = time()
-                if now - start >= timeout:
-                    if assert_timeout:
-                        if self.line_read:
-                            log.error(timeout_error_msg)
-                            assert False, timeout_error_msg
-                        else:
-                            raise Device.BoardCommunicationFailed("Waiting for first reply timed out")
-                    else:
-                        log.warning(timeout_error_msg)
-                        return []
-                if now - last > 1:
-                    log.info('{}: Waiting for "{}" string... Timeout in {:.0f} s'.format(self.name, search,
-                                                                                         abs(now - start - timeout)))
+        while True:
+            with self._received:
+                received = self._next_line(command_id)
+                while received is None:
+                    now = time()
+                    if now >= deadline:
+                        break
+                    if now - last > 1:
+                        last = now
+                        log.info('{}: Waiting for "{}" string... Timeout in {:.0f} s'.format(self.name, search,
+                                                                                             deadline - now))
+                    self._received.wait(min(deadline - now, 1))
+                    received = self._next_line(command_id)
+
+            if received is None:
+                break
+
+            # the line is handed to the consumer outside of the lock
+            _, line, retcode = received
+            if expected_retcode is not None:
+                matched = retcode == expected_retcode
+            else:
+                matched = search in line
+            yield line, matched
+            if matched:
+                return
+
+        if assert_timeout:
+            if self.line_read:
+                log.error(timeout_error_msg)
+                assert False, timeout_error_msg
+            else:
+                raise Device.BoardCommunicationFailed("Waiting for first reply timed out")
+        else:
+            log.warning(timeout_error_msg)
+
+    def _dispatch_thread(self):
+        while True:
+            line = self.iq.get()
+            if line is None:
+                return
+            self._dispatch(line)
+
+    def _dispatch(self, line: str):
+        """
+        Route a line received from the device: events are pushed in the event
+        queue while responses and retcodes wake up the waiters.
+        """
+        with self._received:
+            # mark the board as communicating so we don't retry
+            self.line_read = True
+            if line.startswith(Device.EVENT_PREFIX):
+                self.events.put(line[len(Device.EVENT_PREFIX):])
+                return
+            match = Device.RETCODE_PATTERN.search(line)
+            command_id = self._running[0] if self._running else None
+            if match and self._running:
+                # the retcode ends the output of the command
+                self._running.popleft()
+            self._lines.append((command_id, line, int(match.group(1)) if match else None))
+            self._received.notify_all()
 
     def _write(self, data):
         self.oq.put(data)
-
-    def _read_line(self, timeout):
-        return self.iq.get(timeout=timeout)
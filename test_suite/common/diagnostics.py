@@ -0,0 +1,138 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+"""Memory usage of the boards during each test.
+
+When pytest is invoked with --diagnostics, the boards report their memory usage
+(see ble getDiagnostics) when they are allocated to a test and when they are
+released. The peaks are reset at the allocation and the state of the board is
+reset before the last report, the heap still allocated then has leaked. A
+board is warmed up by an init and resetState cycle before its first report so
+the heap it allocates once and keeps is not a leak. The usage is recorded as a
+property of the test, named diagnostics_<fixture>, and the tests which leaked
+or used the most stack are printed at the end of the run.
+"""
+
+from collections import OrderedDict
+from typing import Any, List, Mapping, Optional, Tuple
+
+from prettytable import PrettyTable
+
+# Number of tests printed in the table of the highest stack peaks
+STACK_PEAKS_REPORTED = 10
+
+
+def usage(before: Mapping[str, Any], after: Mapping[str, Any], retained: Mapping[str, Any]) -> Mapping[str, int]:
+    """Memory usage of a test from the diagnostics of the board taken at its
+    allocation, at its release and once its state has been reset."""
+    result = OrderedDict()  # type: OrderedDict[str, int]
+    if before["heap"]["enabled"]:
+        result["heap_leaked"] = retained["heap"]["current"] - before["heap"]["current"]
+        result["heap_allocations_leaked"] = retained["heap"]["allocations"] - before["heap"]["allocations"]
+        result["heap_allocated"] = after["heap"]["allocated"] - before["heap"]["allocated"]
+        result["heap_failed_allocations"] = after["heap"]["failed_allocations"] - before["heap"]["failed_allocations"]
+        result["heap_peak"] = after["heap"]["peak"]
+    if after["stack"]["painted"]:
+        result["stack_peak"] = after["stack"]["peak"]
+        result["stack_size"] = after["stack"]["size"]
+    result["event_queue_peak"] = after["event_queue"]["peak"]
+    result["event_queue_capacity"] = after["event_queue"]["capacity"]
+    result["event_queue_failed_posts"] = after["event_queue"]["failed_posts"]
+    return result
+
+
+class DiagnosticsRecorder:
+    """Collect the memory usage of the boards per test."""
+
+    def __init__(self):
+        self.usages = []  # type: List[Tuple[str, str, Mapping[str, int]]]
+
+    def add(self, test: str, fixture: str, test_usage: Mapping[str, int]):
+        self.usages.append((test, fixture, test_usage))
+
+    def leaks_table(self) -> Optional[PrettyTable]:
+        """Tests which leaked heap or ran out of heap or of event queue slots."""
+        rows = [
+            (test, fixture, test_usage) for test, fixture, test_usage in self.usages
+            if test_usage.get("heap_leaked", 0) > 0 or test_usage.get("heap_failed_allocations", 0) or
+               test_usage["event_queue_failed_posts"]
+        ]
+        if not rows:
+            return None
+
+        table = PrettyTable(['test', 'board', 'heap leaked', 'allocations leaked', 'failed allocations',
+                             'failed posts'])
+        table.align = 'r'
+        table.align['test'] = 'l'
+        table.align['board'] = 'l'
+        for test, fixture, test_usage in rows:
+            table.add_row([
+                test, fixture, test_usage.get("heap_leaked", '-'), test_usage.get("heap_allocations_leaked", '-'),
+                test_usage.get("heap_failed_allocations", '-'), test_usage["event_queue_failed_posts"]
+            ])
+        return table
+
+    def stack_table(self) -> Optional[PrettyTable]:
+        """Tests with the highest stack peaks."""
+        rows = sorted(
+            (row for row in self.usages if "stack_peak" in row[2]),
+            key=lambda row: -row[2]["stack_peak"]
+        )[:STACK_PEAKS_REPORTED]
+        if not rows:
+            return None
+
+        table = PrettyTable(['test', 'board', 'stack peak', 'stack size', 'heap peak', 'event queue peak'])
+        table.align = 'r'
+        table.align['test'] = 'l'
+        table.align['board'] = 'l'
+        for test, fixture, test_usage in rows:
+            table.add_row([
+                test, fixture, test_usage["stack_peak"], test_usage["stack_size"], test_usage.get("heap_peak", '-'),
+                '{}/{}'.format(test_usage["event_queue_peak"], test_usage["event_queue_capacity"])
+            ])
+        return table
+
+
+def record_usage(request, fixture: str, test_usage: Optional[Mapping[str, int]]):
+    """Record the memory usage of the board of a device fixture."""
+    if test_usage is None:
+        return
+    request.node.user_properties.append(('diagnostics_{}'.format(fixture), test_usage))
+    recorder = getattr(request.config, 'diagnostics_recorder', None)
+    if recorder is not None:
+        recorder.add(request.node.nodeid, fixture, test_usage)
+
+
+def pytest_configure(config):
+    if config.getoption('diagnostics'):
+        config.diagnostics_recorder = DiagnosticsRecorder()
+
+
+def pytest_terminal_summary(terminalreporter, exitstatus, config):
+    recorder = getattr(config, 'diagnostics_recorder', None)
+    if recorder is None or not recorder.usages:
+        return
+    terminalreporter.write_sep('=', 'memory usage of the boards (bytes)')
+    leaks = recorder.leaks_table()
+    if leaks is None:
+        terminalreporter.write_line('No leak detected')
+    else:
+        terminalreporter.write_line('Leaks and exhaustion:')
+        terminalreporter.write_line(leaks.get_string())
+    stack = recorder.stack_table()
+    if stack is not None:
+        terminalreporter.write_line('Highest stack peaks:')
+        terminalreporter.write_line(stack.get_string())
@@ -13,6 +13,7 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import queue
 from typing import List, Optional, Any, Mapping
 
 import mbed_lstools
@@ -21,6 +22,7 @@ from mbed_flasher.flash import Flash
 from device import Device
 
 from .ble_device import BleDevice
+from .diagnostics import record_usage, usage
 from .serial_connection import SerialConnection
 from .serial_device import SerialDevice
 
@@ -72,16 +74,30 @@ def command_delay(request):
     return float(0)
 
 
+@pytest.fixture(scope="session")
+def command_timing(request):
+    return bool(request.config.getoption('command_timing'))
+
+
+@pytest.fixture(scope="session")
+def diagnostics(request):
+    return bool(request.config.getoption('diagnostics'))
+
+
 class BoardAllocation:
     def __init__(self, description: Mapping[str, Any]):
         self.description = description
         self.ble_device = None  # type: Optional[BleDevice]
+        # Configured serial device, kept open between allocations
+        self.serial_device = None  # type: Optional[SerialDevice]
         self.flashed = False
+        # Diagnostics reported when the board was allocated
+        self.diagnostics = None  # type: Optional[Mapping[str, Any]]
 
 
 class BoardAllocator:
     ALLOCATION_RETRIES = 3
-    def __init__(self, platforms_supported: List[str], binaries: Mapping[str, str], serial_inter_byte_delay: float, baudrate: int, command_delay: float):
+    def __init__(self, platforms_supported: List[str], binaries: Mapping[str, str], serial_inter_byte_delay: float, baudrate: int, command_delay: float, command_timing: bool = False, diagnostics: bool = False):
         mbed_ls = mbed_lstools.create()
         boards = mbed_ls.list_mbeds(filter_function=lambda m: m['platform_name'] in platforms_supported)
         self.board_description = boards
@@ -91,6 +107,8 @@ class BoardAllocator:
         self.serial_inter_byte_delay = serial_inter_byte_delay
         self.baudrate = baudrate
         self.command_delay = command_delay
+        self.command_timing = command_timing
+        self.diagnostics = diagnostics
         for desc in boards:
             self.allocation.append(BoardAllocation(desc))
 
@@ -106,6 +124,13 @@ class BoardAllocator:
                     self.flasher.flash(build=binary, target_id=alloc.description["target_id"])
                     alloc.flashed = True
 
+                # Board already configured: bring it back to its baseline state without a reset
+                if alloc.serial_device is not None:
+                    alloc.ble_device = self._restore_baseline(alloc, name)
+                    if alloc.ble_device is not None:
+                        self._start_diagnostics(alloc)
+                        return alloc.ble_device
+
                 # Create the serial connection
                 connection = SerialConnection(
                     port=alloc.description["serial_port"],
@@ -130,34 +155,117 @@ class BoardAllocator:
                         alloc.ble_device.send('set --retcode true', 'retcode: 0', wait_for_response=5)
                         alloc.ble_device.send('echo off', 'retcode: 0')
                         alloc.ble_device.send('set --vt100 off', 'retcode: 0')
+                        if self.command_timing:
+                            alloc.ble_device.send('ble enableCommandTiming true', 'retcode: 0')
 
+                        alloc.serial_device = serial_device
                         break
 
                     except serial_device.BoardCommunicationFailed:
                         if retry:
                             retry -= 1
-                            self.release(serial_device)
+                            serial_device.stop()
                             log.warning("Board failed to allocate, retrying")
                         else:
                             raise
 
+                self._warm_up(alloc)
+                self._start_diagnostics(alloc)
                 return alloc.ble_device
         return None
 
-    def release(self, ble_device: BleDevice) -> None:
+    def release(self, ble_device: BleDevice) -> Optional[Mapping[str, int]]:
+        """
+        Release a board.
+        :return: The memory usage of the board during the allocation if diagnostics are enabled
+        """
         for alloc in self.allocation:
             if alloc.ble_device == ble_device and alloc.ble_device is not None:
-                # Restore the board
-                alloc.ble_device.send('echo on', 'retcode: 0')
-                alloc.ble_device.send('set --vt100 on', 'retcode: 0')
-                alloc.ble_device.send('set retcode false')
+                test_usage = self._stop_diagnostics(alloc)
+                # The board stays configured, it is restored to its baseline state on the next allocation
+                alloc.ble_device = None
+                return test_usage
+        return None
 
-                # Stop activities
-                alloc.ble_device.device.stop()
-                alloc.ble_device.device.serial.close()
+    def close(self) -> None:
+        for alloc in self.allocation:
+            if alloc.serial_device is not None:
+                self._close(alloc)
+
+    def _restore_baseline(self, alloc: BoardAllocation, name: str = None) -> Optional[BleDevice]:
+        """
+        Reuse the serial device of a configured board and reset its state with
+        ble resetState.
+        :return: The BleDevice or None if the board didn't respond
+        """
+        serial_device = alloc.serial_device
+        if name is not None:
+            serial_device.name = name
+        # Procedures left running by the previous allocation would print their
+        # response in the middle of the next one
+        if not serial_device.abort_commands():
+            log.warning("Board failed to end its running procedures, resetting it")
+            self._close(alloc)
+            return None
+        # Output and events of the previous allocation are not relevant anymore
+        serial_device.flush()
+        serial_device.events = queue.Queue()
+
+        ble_device = BleDevice(serial_device, command_delay=self.command_delay)
+        if ble_device.send('ble resetState', 'retcode: 0', wait_for_response=5, assert_output=False):
+            # resetState disables the command timing
+            if self.command_timing:
+                ble_device.send('ble enableCommandTiming true', 'retcode: 0')
+            return ble_device
+
+        log.warning("Board failed to reset its state, resetting it")
+        self._close(alloc)
+        return None
 
-                # Cleanup
-                alloc.ble_device = None
+    def _warm_up(self, alloc: BoardAllocation) -> None:
+        """
+        Bring a board just configured to the state it has after a resetState:
+        the memory the stack and the application allocate at their first use
+        would otherwise be reported as leaked by the first test.
+        """
+        if not self.diagnostics:
+            return
+        alloc.ble_device.ble.init()
+        alloc.ble_device.ble.resetState()
+        if self.command_timing:
+            alloc.ble_device.ble.enableCommandTiming(True)
+
+    def _start_diagnostics(self, alloc: BoardAllocation) -> None:
+        if not self.diagnostics:
+            return
+        alloc.ble_device.ble.resetDiagnostics()
+        alloc.diagnostics = alloc.ble_device.ble.getDiagnostics().result
+
+    def _stop_diagnostics(self, alloc: BoardAllocation) -> Optional[Mapping[str, int]]:
+        if alloc.diagnostics is None:
+            return None
+        before, alloc.diagnostics = alloc.diagnostics, None
+        after = alloc.ble_device.ble.getDiagnostics().result
+        # Memory still allocated once the state is reset has leaked
+        alloc.ble_device.ble.resetState()
+        retained = alloc.ble_device.ble.getDiagnostics().result
+        return usage(before, after, retained)
+
+    def _close(self, alloc: BoardAllocation) -> None:
+        serial_device = alloc.serial_device
+
+        # Restore the board
+        serial_device.send('echo on', 'retcode: 0', assert_output=False)
+        serial_device.send('set --vt100 on', 'retcode: 0', assert_output=False)
+        serial_device.send('set retcode false')
+
+        # Stop activities
+        serial_device.stop()
+        serial_device.serial.close()
+
+        # Cleanup
+        alloc.serial_device = None
+        alloc.ble_device = None
 
 
 @pytest.fixture(scope="session")
@@ -166,57 +274,61 @@ def board_allocator(
         binaries: Mapping[str, str],
         serial_inter_byte_delay: float,
         serial_baudrate: int,
-        command_delay: float
+        command_delay: float,
+        command_timing: bool,
+        diagnostics: bool
 ):
-    yield BoardAllocator(platforms, binaries, serial_inter_byte_delay, serial_baudrate, command_delay)
+    allocator = BoardAllocator(platforms, binaries, serial_inter_byte_delay, serial_baudrate, command_delay, command_timing, diagnostics)
+    yield allocator
+    allocator.close()
 
 
 @pytest.fixture(scope="function")
-def device(board_allocator):
+def device(board_allocator, request):
     device = board_allocator.allocate(name='DUT')
     yield device
-    board_allocator.release(device)
+    record_usage(request, 'device', board_allocator.release(device))
 
 
 @pytest.fixture(scope="function")
-def peripheral(board_allocator: BoardAllocator):
+def peripheral(board_allocator: BoardAllocator, request):
     device = board_allocator.allocate('peripheral')
     assert device is not None
 
     device.ble.init()
     yield device
     device.ble.shutdown()
-    board_allocator.release(device)
+    record_usage(request, 'peripheral', board_allocator.release(device))
 
 
 @pytest.fixture(scope="function")
-def central(board_allocator: BoardAllocator):
+def central(board_allocator: BoardAllocator, request):
     device = board_allocator.allocate('central')
     assert device is not None
 
     device.ble.init()
     yield device
     device.ble.shutdown()
-    board_allocator.release(device)
+    record_usage(request, 'central', board_allocator.release(device))
 
 
 @pytest.fixture(scope="function")
-def central2(board_allocator: BoardAllocator):
+def central2(board_allocator: BoardAllocator, request):
     device = board_allocator.allocate('central')
     assert device is not None
 
     device.ble.init()
     yield device
     device.ble.shutdown()
-    board_allocator.release(device)
+    record_usage(request, 'central2', board_allocator.release(device))
 
 
 @pytest.fixture(scope="function")
-def peripheral2(board_allocator: BoardAllocator):
+def peripheral2(board_allocator: BoardAllocator, request):
     device = board_allocator.allocate('peripheral2')
     assert device is not None
 
     device.ble.init()
     yield device
     device.ble.shutdown()
-    board_allocator.release(device)
+    record_usage(request, 'peripheral2', board_allocator.release(device))
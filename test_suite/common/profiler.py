@@ -0,0 +1,262 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+"""Wall-clock profiler of the test suite.
+
+When pytest is invoked with --profile=<file>, the time spent in the test
+phases (setup, call and teardown), fixtures, Device.send, Device.wait_for_output,
+the waits of Device.iter_output and Device._receive, SerialConnection.write,
+SerialConnection.readline and sleep is recorded for each test. The spans are written in the Chrome trace event format - which can be
+opened with chrome://tracing or speedscope - and summarized in tables at the
+end of the run.
+"""
+
+import json
+import os
+import sys
+import threading
+import time
+from collections import OrderedDict
+from contextlib import contextmanager
+from functools import wraps
+from time import perf_counter
+
+import pytest
+from prettytable import PrettyTable
+
+from .device import Device
+from .serial_connection import SerialConnection
+
+
+class WallClockProfiler:
+    """Record spans of time, per thread, in the Chrome trace event format."""
+
+    def __init__(self):
+        self.origin = perf_counter()
+        self.spans = []
+        self.threads = {}
+        self.test = None
+        self._lock = threading.Lock()
+        self._patches = []
+
+    def now(self) -> float:
+        """Time elapsed since the start of the profiler in microseconds."""
+        return (perf_counter() - self.origin) * 1e6
+
+    def record(self, name: str, category: str, start: float, end: float, args=None):
+        thread = threading.current_thread()
+        span = {
+            'name': name,
+            'cat': category,
+            'ph': 'X',
+            'ts': start,
+            'dur': end - start,
+            'pid': os.getpid(),
+            'tid': thread.ident,
+            'args': dict(args or {}, test=self.test)
+        }
+        with self._lock:
+            self.threads[thread.ident] = thread.name
+            self.spans.append(span)
+
+    @contextmanager
+    def span(self, name: str, category: str, args=None):
+        start = self.now()
+        try:
+            yield
+        finally:
+            self.record(name, category, start, self.now(), args)
+
+    def patch(self, owner, attribute: str, category: str, describe=None, keep=None):
+        """Replace owner.attribute by a function recording its execution.
+        describe: optional function producing the arguments of the span from
+        the arguments of the call.
+        keep: optional predicate on the result; spans are discarded if it
+        returns False.
+        """
+        original = getattr(owner, attribute)
+        name = '{}.{}'.format(owner.__name__, attribute) if isinstance(owner, type) else attribute
+
+        @wraps(original)
+        def wrapper(*args, **kwargs):
+            start = self.now()
+            result = original(*args, **kwargs)
+            if keep is None or keep(result):
+                self.record(name, category, start, self.now(), describe(*args, **kwargs) if describe else None)
+            return result
+
+        setattr(owner, attribute, wrapper)
+        self._patches.append((owner, attribute, original))
+        return wrapper
+
+    def patch_generator(self, owner, attribute: str, category: str, describe=None):
+        """Replace the generator function owner.attribute by one recording each
+        wait for its next item; the time spent by the consumer between two
+        items is not recorded."""
+        original = getattr(owner, attribute)
+        name = '{}.{}'.format(owner.__name__, attribute) if isinstance(owner, type) else attribute
+
+        @wraps(original)
+        def wrapper(*args, **kwargs):
+            args_description = describe(*args, **kwargs) if describe else None
+            generator = original(*args, **kwargs)
+            try:
+                while True:
+                    start = self.now()
+                    try:
+                        item = next(generator)
+                    finally:
+                        self.record(name, category, start, self.now(), args_description)
+                    yield item
+            except StopIteration:
+                return
+            finally:
+                generator.close()
+
+        setattr(owner, attribute, wrapper)
+        self._patches.append((owner, attribute, original))
+        return wrapper
+
+    def install(self):
+        self.patch(Device, 'send', 'command', lambda device, command, *args, **kwargs: {'command': command})
+        self.patch(Device, 'wait_for_output', 'command', lambda device, search, *args, **kwargs: {'search': search})
+        # streamed and asynchronous responses are read through these generators
+        self.patch_generator(Device, 'iter_output', 'command',
+                             lambda device, search, *args, **kwargs: {'search': search})
+        self.patch_generator(Device, '_receive', 'command',
+                             lambda device, search, *args, **kwargs: {'search': search})
+        self.patch(SerialConnection, 'write', 'serial')
+        # the input thread polls the serial port, only reads returning data are meaningful
+        self.patch(SerialConnection, 'readline', 'serial', keep=bool)
+
+        # modules import sleep directly, replace every reference to it
+        original_sleep = time.sleep
+        sleep = self.patch(time, 'sleep', 'sleep', lambda seconds: {'seconds': seconds})
+        for module in list(sys.modules.values()):
+            if module is not time and getattr(module, 'sleep', None) is original_sleep:
+                setattr(module, 'sleep', sleep)
+                self._patches.append((module, 'sleep', original_sleep))
+
+    def uninstall(self):
+        for owner, attribute, original in reversed(self._patches):
+            setattr(owner, attribute, original)
+        self._patches = []
+
+    def write_trace(self, path: str):
+        metadata = [
+            {'name': 'thread_name', 'ph': 'M', 'pid': os.getpid(), 'tid': tid, 'args': {'name': name}}
+            for tid, name in self.threads.items()
+        ]
+        with open(path, 'w') as trace:
+            json.dump({'traceEvents': metadata + self.spans, 'displayTimeUnit': 'ms'}, trace)
+
+    def operations_table(self) -> PrettyTable:
+        totals = OrderedDict()
+        for span in self.spans:
+            if span['cat'] == 'test':
+                continue
+            count, total, longest = totals.get(span['name'], (0, 0, 0))
+            totals[span['name']] = (count + 1, total + span['dur'], max(longest, span['dur']))
+
+        table = PrettyTable(['operation', 'count', 'total (s)', 'mean (ms)', 'max (ms)'])
+        table.align = 'r'
+        table.align['operation'] = 'l'
+        for name, (count, total, longest) in sorted(totals.items(), key=lambda item: -item[1][1]):
+            table.add_row([name, count, '{:.3f}'.format(total / 1e6),
+                           '{:.1f}'.format(total / count / 1e3), '{:.1f}'.format(longest / 1e3)])
+        return table
+
+    def tests_table(self) -> PrettyTable:
+        phases = ['setup', 'call', 'teardown']
+        tests = OrderedDict()
+        for span in self.spans:
+            if span['cat'] == 'test':
+                tests.setdefault(span['args']['test'], dict.fromkeys(phases, 0))[span['name']] += span['dur']
+
+        table = PrettyTable(['test'] + ['{} (s)'.format(phase) for phase in phases] + ['total (s)'])
+        table.align = 'r'
+        table.align['test'] = 'l'
+        for test, durations in tests.items():
+            table.add_row([test] + ['{:.3f}'.format(durations[phase] / 1e6) for phase in phases] +
+                          ['{:.3f}'.format(sum(durations.values()) / 1e6)])
+        return table
+
+
+def _profiler(config):
+    return getattr(config, 'wall_clock_profiler', None)
+
+
+def pytest_configure(config):
+    if config.getoption('profile'):
+        config.wall_clock_profiler = WallClockProfiler()
+
+
+def pytest_collection_finish(session):
+    profiler = _profiler(session.config)
+    if profiler is not None:
+        profiler.install()
+
+
+def pytest_unconfigure(config):
+    profiler = _profiler(config)
+    if profiler is not None:
+        profiler.uninstall()
+
+
+@pytest.hookimpl(hookwrapper=True)
+def pytest_runtest_setup(item):
+    yield from _test_phase(item, 'setup')
+
+
+@pytest.hookimpl(hookwrapper=True)
+def pytest_runtest_call(item):
+    yield from _test_phase(item, 'call')
+
+
+@pytest.hookimpl(hookwrapper=True)
+def pytest_runtest_teardown(item):
+    yield from _test_phase(item, 'teardown')
+
+
+def _test_phase(item, phase: str):
+    profiler = _profiler(item.config)
+    if profiler is None:
+        yield
+        return
+    profiler.test = item.nodeid
+    with profiler.span(phase, 'test'):
+        yield
+
+
+@pytest.hookimpl(hookwrapper=True)
+def pytest_fixture_setup(fixturedef, request):
+    profiler = _profiler(request.config)
+    if profiler is None:
+        yield
+        return
+    with profiler.span('fixture {}'.format(fixturedef.argname), 'fixture'):
+        yield
+
+
+def pytest_terminal_summary(terminalreporter, exitstatus, config):
+    profiler = _profiler(config)
+    if profiler is None:
+        return
+    path = config.getoption('profile')
+    profiler.write_trace(path)
+    terminalreporter.write_sep('=', 'wall clock profile, trace written in {}'.format(path))
+    terminalreporter.write_line(profiler.operations_table().get_string())
+    terminalreporter.write_line(profiler.tests_table().get_string())
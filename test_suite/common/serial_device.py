@@ -68,6 +68,8 @@ class SerialDevice(Device):
         :param duration: Break duration
         """
         self.serial.send_break(duration)
+        # the commands running are lost with the reset
+        self.forget_commands()
 
     def stop(self):
         """
@@ -75,8 +77,11 @@ class SerialDevice(Device):
         """
         log.info('Stopping "{}" runner...'.format(self.name))
         self.run = False
+        # wake up the output thread
+        self.oq.put(None)
         self.it.join()
         self.ot.join()
+        super(SerialDevice, self).stop()
 
     def _input_thread(self):
         while self.run:
@@ -103,7 +108,11 @@ class SerialDevice(Device):
     def _output_thread(self):
         while self.run:
             line = self.oq.get()
-            if line:
+            if isinstance(line, bytes):
+                # control characters are sent as is
+                log.info('-->|{}| {}'.format(self.name, line))
+                self.serial.write(line)
+            elif line:
                 log.info('-->|{}| {}'.format(self.name, line.strip()))
                 data = line + '\n'
                 self.serial.write(data.encode('utf8'))
@@ -15,7 +15,7 @@
 
 import pytest
 
-pytest_plugins = ['common.fixtures']
+pytest_plugins = ['common.fixtures', 'common.command_timing', 'common.profiler', 'common.baseline', 'common.diagnostics']
 
 
 def pytest_addoption(parser):
@@ -28,4 +28,20 @@ def pytest_addoption(parser):
     parser.addoption('--binaries', action='store', help='Platform and associated binary in the form platform:binary. Multiple values are separated by a comma')
     parser.addoption('--serial_inter_byte_delay', action='store', help='Time in second between two bytes sent on the serial line (accepts floats)')
     parser.addoption('--serial_baudrate', action='store', help='Baudrate of the serial port used', default='115200')
-    parser.addoption('--command_delay', action='store', help='Delay in seconds before sending a command', default='0')
\ No newline at end of file
+    parser.addoption('--command_delay', action='store', help='Delay in seconds before sending a command', default='0')
+    parser.addoption('--command_timing', action='store_true', help='Measure the execution time of commands on the boards and report their percentiles')
+    parser.addoption('--diagnostics', action='store_true', help='Measure the heap, stack and event queue usage of the boards during each test')
+    parser.addoption('--profile', action='store', help='Profile the wall clock time of the tests and write a Chrome trace in the file given')
+    parser.addoption('--perf_results', action='store', help='Run the link parameter sweep and write its results in the JSON file given, a CSV file is written next to it')
+    parser.addoption('--perf_phys', action='store', help='PHYs of the sweep separated by a comma (LE_1M, LE_2M, LE_CODED)')
+    parser.addoption('--perf_att_mtus', action='store', help='ATT_MTU of the sweep separated by a comma (default, negotiated)')
+    parser.addoption('--perf_intervals', action='store', help='Connection intervals of the sweep, in units of 1.25ms, separated by a comma')
+    parser.addoption('--perf_payloads', action='store', help='Payload sizes of the sweep, in bytes, separated by a comma')
+    parser.addoption('--perf_packets', action='store', help='Number of packets written at each point of the sweep', default='200')
+    parser.addoption('--baseline_store', action='store', help='Collect the measurements of the benchmarks in the baseline store given, a JSON lines file')
+    parser.addoption('--baseline_record', action='store_true', help='Append the measurements of the run to the baseline store')
+    parser.addoption('--baseline_check', action='store_true', help='Fail the run when a measurement regressed against the baseline store')
+    parser.addoption('--baseline_firmware', action='store', help='Identifier of the firmware tested, the hash of the binaries by default')
+    parser.addoption('--baseline_reference', action='store', help='Firmware the run is compared to, the latest runs stored by default')
+    parser.addoption('--baseline_tolerance', action='store', help='Regression tolerated in percent', default='10')
+    parser.addoption('--baseline_z', action='store', help='Standard deviations of the baseline a regression must exceed', default='3')
\ No newline at end of file
@@ -0,0 +1,67 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+import pytest
+
+# manufacturer specific data element of 200 bytes of data
+ELEMENT_DATA_LENGTH = 200
+ELEMENT = "{:02X}FF".format(ELEMENT_DATA_LENGTH + 1) + "AB" * ELEMENT_DATA_LENGTH
+ELEMENT_LENGTH = len(ELEMENT) // 2
+ELEMENT_COUNT = 3
+INVALID_PARAMETERS = -2
+
+
+@pytest.mark.ble50
+def test_set_payload_in_chunks(device):
+    """A set builder is filled past the command line limit with chunks written at increasing offsets"""
+    device.ble.init()
+    if not device.gap.isFeatureSupported("LE_EXTENDED_ADVERTISING").result:
+        device.ble.shutdown()
+        pytest.skip("extended advertising is not supported")
+
+    handle = device.gap.createAdvertisingSet().result
+    builder = device.advDataBuilder
+    assert builder.selectSet(handle).success()
+    if builder.getCapacity().result < ELEMENT_LENGTH * ELEMENT_COUNT:
+        device.ble.shutdown()
+        pytest.skip("the advertising data of the controller is too short")
+
+    for i in range(ELEMENT_COUNT):
+        assert builder.setPayload(ELEMENT, i * ELEMENT_LENGTH).success()
+
+    payload = ELEMENT * ELEMENT_COUNT
+    # the payload couldn't be written by a single command
+    assert len(payload) > 1000
+    assert builder.getAdvertisingData().result.upper() == payload
+
+    # chunks are written at element boundaries within the current payload
+    assert builder.setPayload.withRetcode(INVALID_PARAMETERS)(ELEMENT, 1).error is not None
+    assert builder.setPayload.withRetcode(INVALID_PARAMETERS)(ELEMENT, len(payload)).error is not None
+    assert builder.getAdvertisingData().result.upper() == payload
+
+    # an offset within the payload replaces its end
+    assert builder.setPayload("0201060709424152424152", ELEMENT_LENGTH).success()
+    assert builder.getAdvertisingData().result.upper() == ELEMENT + "0201060709424152424152"
+
+    assert builder.setPayload(ELEMENT, 0).success()
+    assert builder.getAdvertisingData().result.upper() == ELEMENT
+
+    # the default builder is applied again once selected
+    assert builder.selectDefault().success()
+    assert builder.getAdvertisingData().result.upper() != ELEMENT
+
+    device.gap.destroyAdvertisingSet(handle)
+    device.ble.shutdown()
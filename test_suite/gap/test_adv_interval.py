@@ -37,6 +37,10 @@ MIN_CONN_ADV_INTERVAL = 0x0020
 # might fail if the value is too high.
 MAX_ADV_INTERVAL = 1000
 ADV_INTERVAL_TOLERANCE = 30
+# pseudo random delay added by the link layer to each advertising event
+ADV_DELAY_MAX_MS = 10
+# jitter of the reception time measured by the scanner
+SCANNER_TIMING_TOLERANCE_MS = 2
 ADV_TYPES = [
     "CONNECTABLE_UNDIRECTED",
     # disabled for the moment, it is not yet supported
@@ -145,3 +149,37 @@ def test_advertising_interval(advertiser: BleDevice, scanner: BleDevice, adverti
         # stop advertising
         advertiser.gap.stopAdvertising(LEGACY_ADVERTISING_HANDLE)
         sleep(1)  # wait for advertising to stop
+
+
+@pytest.mark.ble41
+@pytest.mark.parametrize("advertising_type", ["CONNECTABLE_UNDIRECTED", "SCANNABLE_UNDIRECTED", "NON_CONNECTABLE_UNDIRECTED"])
+def test_advertising_interval_analyzed_by_scanner(advertiser: BleDevice, scanner: BleDevice, advertiser_address,
+                                                  advertising_type: str):
+    """test that the shortest advertising interval measured by the scanner matches the interval requested"""
+    advertising_interval, scan_timeout = generate_ran_adv_interval(advertising_type)
+
+    advertiser.advParams.setType(advertising_type)
+    advertiser.advParams.setPrimaryInterval(advertising_interval, advertising_interval)
+    advertiser.gap.setAdvertisingParameters(LEGACY_ADVERTISING_HANDLE)
+    advertiser.gap.applyAdvPayloadFromBuilder(LEGACY_ADVERTISING_HANDLE)
+    advertiser.gap.startAdvertising(LEGACY_ADVERTISING_HANDLE, ADV_DURATION_FOREVER, ADV_MAX_EVENTS_UNLIMITED)
+
+    scanner.scanParams.set1mPhyConfiguration(100, 100, False)
+    scanner.gap.setScanParameters()
+    streams = scanner.gap.analyzeAdvertisingInterval(scan_timeout, advertiser_address).result["streams"]
+
+    assert len(streams) == 1
+    stream = streams[0]
+    intervals = stream["intervals"]
+    assert intervals["count"] > 0
+    # copies of an event on other channels do not produce intervals
+    assert intervals["count"] + stream["duplicates"] < stream["reports"]
+    # intervals are reported in µs. A packet dropped by the scanner doubles an
+    # interval and would skew the mean: the shortest interval is the one of two
+    # consecutive events, the requested interval plus the advertising delay.
+    interval_ms = advertising_interval * INTERVAL_UNIT_MS
+    shortest_ms = intervals["min"] / 1000
+    assert interval_ms - SCANNER_TIMING_TOLERANCE_MS <= shortest_ms
+    assert shortest_ms <= interval_ms + ADV_DELAY_MAX_MS + SCANNER_TIMING_TOLERANCE_MS
+
+    advertiser.gap.stopAdvertising(LEGACY_ADVERTISING_HANDLE)
@@ -73,5 +73,66 @@ def test_cancel_connect_too_late(central, peripheral):
     assert disconnection_cmd.result['reason'] == 'REMOTE_USER_TERMINATED_CONNECTION'
 
 
+@pytest.mark.ble41
+def test_captured_connection_events_are_observed(central, peripheral):
+    """Connection events captured by a procedure still reach the connection statistics observing them"""
+    central_handle, peripheral_handle = gap_connect(central, peripheral)
+
+    def record(device, handle):
+        connections = device.gap.getConnectionStatistics().result["connections"]
+        return next(c for c in connections if c["connection_handle"] == handle)
+
+    # connect and waitForConnection captured the connection complete event
+    assert record(central, central_handle)["connected"]
+    assert record(central, central_handle)["own_role"] == "CENTRAL"
+    assert record(peripheral, peripheral_handle)["connected"]
+    assert record(peripheral, peripheral_handle)["own_role"] == "PERIPHERAL"
+
+    # waitForDisconnection captures the disconnection complete event
+    disconnection_cmd = peripheral.gap.waitForDisconnection.setAsync()(10000)
+    central.gap.disconnect(central_handle, "USER_TERMINATION")
+    assert disconnection_cmd.result['reason'] == 'REMOTE_USER_TERMINATED_CONNECTION'
+
+    assert not record(peripheral, peripheral_handle)["connected"]
+
 
 
+
+
+
+ABSENT_PEER_ADDRESS_TYPE = "PUBLIC"
+ABSENT_PEER_ADDRESS = "12:34:56:78:90:12"
+
+
+@pytest.mark.ble41
+@pytest.mark.parametrize("mode", ["sequential", "pipelined"])
+def test_connect_to_many(central, peripheral, mode):
+    """connectToMany accounts the failure to the absent peer only and restores the whitelist"""
+    peripheral_address = peripheral.gap.getAddress().result
+    start_advertising(peripheral)
+
+    saved_whitelist = [ABSENT_PEER_ADDRESS_TYPE, "21:43:65:87:09:21"]
+    central.gap.setWhitelist(*saved_whitelist)
+
+    report = central.gap.connectToMany(
+        mode, 2000,
+        ABSENT_PEER_ADDRESS_TYPE, ABSENT_PEER_ADDRESS,
+        peripheral_address["address_type"], peripheral_address["address"]
+    ).result
+
+    assert report["mode"] == mode
+    assert report["connected"] == 1
+    assert report["failed"] == 1
+
+    absent, present = report["results"]
+    assert absent["peer_address"] == ABSENT_PEER_ADDRESS
+    assert absent["status"] != "BLE_ERROR_NONE"
+    assert "connection_handle" not in absent
+    assert present["peer_address"] == peripheral_address["address"]
+    assert present["status"] == "BLE_ERROR_NONE"
+    assert present["latency"] <= 2000
+    assert report["latency"]["count"] == 1
+    assert report["latency"]["max"] == present["latency"]
+
+    whitelist = central.gap.getWhitelist().result
+    assert [[entry["address_type"], entry["address"]] for entry in whitelist] == [saved_whitelist]
@@ -0,0 +1,94 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+import json
+import queue
+
+import pytest
+
+INVALID_PARAMETERS = -2
+SYNC_FIELDS = {"sync_handle", "established", "losses", "reports", "events", "missed_events", "max_missed_events",
+               "data_status", "transitions"}
+
+
+@pytest.mark.ble50
+@pytest.mark.parametrize("arguments", [
+    [],
+    [1000],
+    [0, 0],
+    ["duration", 0],
+    [1000, "period"],
+    [1000, 0, "handle"],
+    [1000, 0, 1, 2, 3, 4, 5],
+])
+def test_monitor_periodic_sync_invalid_arguments(device, arguments):
+    """monitorPeriodicSync rejects a missing or null duration, an invalid period, invalid or too many handles"""
+    device.ble.init()
+    result = device.gap.monitorPeriodicSync.withRetcode(INVALID_PARAMETERS)(*arguments)
+    assert result.error is not None
+    device.ble.shutdown()
+
+
+@pytest.mark.ble50
+def test_monitor_periodic_sync_report_without_sync(device):
+    """Without sync, the report is empty and syncs listed are reported with null counters"""
+    device.ble.init()
+
+    report = device.gap.monitorPeriodicSync(500, 0).result
+    assert report["elapsed"] >= 500
+    assert report["dropped_syncs"] == 0
+    assert report["syncs"] == []
+
+    report = device.gap.monitorPeriodicSync(500, 0, 0, 1).result
+    assert [sync["sync_handle"] for sync in report["syncs"]] == [0, 1]
+    for sync in report["syncs"]:
+        assert SYNC_FIELDS <= set(sync.keys())
+        assert sync["reports"] == 0
+        assert sync["events"] == 0
+        assert sync["missed_events"] == 0
+        assert sync["transitions"] == []
+        assert "interval" not in sync
+        assert "rssi" not in sync
+        assert set(sync["data_status"].keys()) == {"complete", "incomplete_more_data", "incomplete_data_truncated"}
+        assert sum(sync["data_status"].values()) == 0
+
+    device.ble.shutdown()
+
+
+@pytest.mark.ble50
+def test_monitor_periodic_sync_periodic_events(device):
+    """The aggregates are reported as events every period"""
+    device.ble.init()
+
+    report = device.gap.monitorPeriodicSync(1000, 200, 0).result
+    assert len(report["syncs"]) == 1
+
+    monitors = []
+    while True:
+        try:
+            event = json.loads(device.events.get_nowait())
+        except queue.Empty:
+            break
+        if event.get("name") == "periodic_sync_monitor":
+            monitors.append(event["value"])
+
+    assert 3 <= len(monitors) <= 5
+    elapsed = [monitor["elapsed"] for monitor in monitors]
+    assert elapsed == sorted(elapsed)
+    for monitor in monitors:
+        assert [sync["sync_handle"] for sync in monitor["syncs"]] == [0]
+
+    device.ble.shutdown()
@@ -0,0 +1,78 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+import pytest
+
+# manufacturer specific data too long for legacy advertising
+EXTENDED_PAYLOAD = "41FF" + "AB" * 64
+
+
+def start_extended_advertising_device(device):
+    device.ble.init()
+    if not device.gap.isFeatureSupported("LE_EXTENDED_ADVERTISING").result:
+        device.ble.shutdown()
+        pytest.skip("extended advertising is not supported")
+
+    device.advParams.setType("NON_CONNECTABLE_UNDIRECTED")
+    device.advParams.setUseLegacyPDU(False)
+    assert device.advDataBuilder.setPayload(EXTENDED_PAYLOAD).success()
+
+
+@pytest.mark.ble50
+def test_failed_sets_are_destroyed(device):
+    """Sets which cannot be configured are destroyed and all the sets remain available"""
+    start_extended_advertising_device(device)
+
+    # a legacy set cannot hold the payload
+    report = device.gap.provisionAdvertisingSets(2, "0:legacy=true", "1:legacy=true").result
+    assert report["count"] == 2
+    assert report["started"] == 0
+    assert len(report["sets"]) == 2
+    for result in report["sets"]:
+        assert result["stage"] == "set_payload"
+        assert result["status"] != "BLE_ERROR_NONE"
+        assert "handle" in result
+        assert "setup" not in result
+
+    # the failed sets have been released: every set but the legacy one can be provisioned
+    available = device.gap.getMaxAdvertisingSetNumber().result - 1
+    report = device.gap.provisionAdvertisingSets(available).result
+    assert report["started"] == available
+    assert [result["stage"] for result in report["sets"]] == ["started"] * available
+
+    for result in report["sets"]:
+        device.gap.stopAdvertising(result["handle"])
+        device.gap.destroyAdvertisingSet(result["handle"])
+    device.ble.shutdown()
+
+
+@pytest.mark.ble50
+def test_every_set_is_reported(device):
+    """Sets which cannot be created are reported with the create stage and no handle"""
+    start_extended_advertising_device(device)
+
+    available = device.gap.getMaxAdvertisingSetNumber().result - 1
+    report = device.gap.provisionAdvertisingSets(available + 1).result
+    assert report["started"] == available
+    assert len(report["sets"]) == available + 1
+    last = report["sets"][-1]
+    assert last["stage"] == "create"
+    assert "handle" not in last
+
+    for result in report["sets"][:-1]:
+        device.gap.stopAdvertising(result["handle"])
+        device.gap.destroyAdvertisingSet(result["handle"])
+    device.ble.shutdown()
@@ -12,7 +12,7 @@
 # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 # See the License for the specific language governing permissions and
 # limitations under the License.
-from time import sleep
+from time import sleep, time
 
 import pytest
 
@@ -95,6 +95,28 @@ def test_start_scan_when_peer_advertising(advertiser: BleDevice, scanner: BleDev
         assert scan['payload'] == payload
 
 
+@pytest.mark.ble41
+def test_scan_stream_break_ends_scan(advertiser: BleDevice, scanner: BleDevice, advertiser_address: str):
+    """Breaking out of the stream of a scan ends it without waiting for its timeout"""
+    advertiser.gap.startAdvertising(LEGACY_ADVERTISING_HANDLE, ADV_DURATION_FOREVER, ADV_MAX_EVENTS_UNLIMITED)
+
+    scan_timeout = 20000
+    scanner.scanParams.set1mPhyConfiguration(100, 100, True)
+    scanner.gap.setScanParameters()
+
+    start = time()
+    scan = scanner.gap.scanForAddress.setAsync()(advertiser_address, scan_timeout)
+    report = None
+    for report in scan.stream():
+        break
+    elapsed = time() - start
+
+    assert report is not None
+    assert elapsed < scan_timeout / 1000 / 4
+    # the board is ready for the next command
+    assert scanner.gap.getAddress().success()
+
+
 @pytest.mark.ble41
 def test_scan_should_not_report_advertisement_when_peer_inactive(scanner: BleDevice, advertiser_address: str):
     """startScan should not report scan results when there is no device advertising"""
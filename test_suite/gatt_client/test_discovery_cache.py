@@ -0,0 +1,176 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import pytest
+
+from common.ble_device import BleDevice
+from common.ble_device import LEGACY_ADVERTISING_HANDLE, ADV_DURATION_FOREVER, ADV_MAX_EVENTS_UNLIMITED
+from common.fixtures import BoardAllocator
+
+
+@pytest.fixture(scope="function")
+def server(board_allocator: BoardAllocator) -> BleDevice:
+    device = board_allocator.allocate("server")
+    assert device
+    device.ble.init()
+
+    device.advDataBuilder.clear()
+    # add flags data into advertising payload
+    advertising_flags = ["LE_GENERAL_DISCOVERABLE", "BREDR_NOT_SUPPORTED"]
+    for f in advertising_flags:
+        device.advDataBuilder.setFlags(f)
+    device.gap.applyAdvPayloadFromBuilder(LEGACY_ADVERTISING_HANDLE)
+
+    # set the advertising type
+    device.advParams.setType("CONNECTABLE_UNDIRECTED")
+    device.gap.setAdvertisingParameters(LEGACY_ADVERTISING_HANDLE)
+
+    yield device
+
+    device.ble.shutdown()
+    board_allocator.release(device)
+
+
+@pytest.fixture(scope="function")
+def client(board_allocator: BoardAllocator) -> BleDevice:
+    device = board_allocator.allocate('client')
+    assert device
+    device.ble.init()
+    yield device
+    device.ble.shutdown()
+    board_allocator.release(device)
+
+
+def connect(server, client):
+    server_address = server.gap.getAddress().result
+    server.gap.startAdvertising(LEGACY_ADVERTISING_HANDLE, ADV_DURATION_FOREVER, ADV_MAX_EVENTS_UNLIMITED)
+
+    connection_server = server.gap.waitForConnection.setAsync()(2000)
+    connection = client.gap.connect(
+        server_address["address_type"], server_address["address"]
+    ).result
+    connection_server.result  # Wait for the completion of the operation on the server
+    return connection["connection_handle"]
+
+
+def disconnect(server, client, connection_handle):
+    disconnection = server.gap.waitForDisconnection.setAsync()(10000)
+    client.gap.disconnect(connection_handle, "USER_TERMINATION")
+    disconnection.result
+
+
+@pytest.mark.ble41
+def test_discovery_cache(server, client, record_property):
+    client.gattClient.flushDiscoveryCache()
+    initial_hits = client.gattClient.getDiscoveryCache().result["hits"]
+    connection_handle = connect(server, client)
+
+    # the result of the discovery without cache is unchanged
+    reference = client.gattClient.discoverAllServicesAndCharacteristics(connection_handle).result
+
+    # first discovery fills the cache
+    miss = client.gattClient.discoverAllServicesAndCharacteristics(connection_handle, True).result
+    assert miss["cached"] is False
+    assert miss["services"] == reference
+    assert miss["att_requests"] > 0
+
+    hit = client.gattClient.discoverAllServicesAndCharacteristics(connection_handle, True).result
+    assert hit["cached"] is True
+    assert hit["services"] == reference
+    assert hit["att_requests"] == 0
+    assert hit["discovery_att_requests"] == miss["att_requests"]
+
+    # entries survive the connection
+    disconnect(server, client, connection_handle)
+    connection_handle = connect(server, client)
+
+    services = client.gattClient.discoverAllServices(connection_handle, True).result
+    assert services["cached"] is True
+    assert services["services"] == [
+        {key: service[key] for key in ("UUID", "start_handle", "end_handle")} for service in reference
+    ]
+
+    cache = client.gattClient.getDiscoveryCache().result
+    assert cache["hits"] - initial_hits == 2
+    assert len(cache["entries"]) == 1
+    assert cache["entries"][0]["hits"] == 2
+    if cache["entries"][0]["service_changed_handle"]:
+        assert cache["entries"][0]["service_changed_subscribed"] is True
+
+    record_property("discovery_cache", dict(
+        att_requests=miss["att_requests"],
+        discovery_duration=miss["duration"],
+        cached_duration=hit["duration"]
+    ))
+
+    # flushed entries are not served
+    assert client.gattClient.flushDiscoveryCache().result == 1
+    miss = client.gattClient.discoverAllServicesAndCharacteristics(connection_handle, True).result
+    assert miss["cached"] is False
+    assert miss["services"] == reference
+
+
+@pytest.mark.ble41
+def test_discovery_cache_cleared_on_shutdown(server, client):
+    connection_handle = connect(server, client)
+    client.gattClient.discoverAllServicesAndCharacteristics(connection_handle, True)
+    client.gattClient.discoverAllServicesAndCharacteristics(connection_handle, True)
+    disconnect(server, client, connection_handle)
+
+    client.ble.shutdown()
+    client.ble.init()
+
+    cache = client.gattClient.getDiscoveryCache().result
+    assert cache["hits"] == 0
+    assert cache["misses"] == 0
+    assert cache["invalidations"] == 0
+    assert cache["entries"] == []
+
+
+@pytest.mark.ble41
+def test_discovery_profile(server, client, record_property):
+    connection_handle = connect(server, client)
+
+    discovery = client.gattClient.discoverAllServicesAndCharacteristics(connection_handle, False, True).result
+    assert discovery["cached"] is False
+    profile = discovery["profile"]
+    assert profile["att_mtu"] >= 23
+    assert "connection_interval" in profile
+    assert profile["services_phase"]["duration"] + profile["characteristics_phase"]["duration"] == \
+        discovery["duration"]
+    assert profile["services_phase"]["att_requests"] + profile["characteristics_phase"]["att_requests"] == \
+        discovery["att_requests"]
+
+    descriptors_duration = 0
+    descriptors_requests = 0
+    for service in discovery["services"]:
+        assert service["discovered_at"] <= discovery["duration"]
+        for characteristic in service["characteristics"]:
+            assert characteristic["discovered_at"] >= service["discovered_at"]
+            if characteristic["value_handle"] == characteristic["end_handle"]:
+                continue
+            descriptors = client.gattClient.discoverAllCharacteristicsDescriptors(
+                connection_handle, characteristic["start_handle"], characteristic["end_handle"], True
+            ).result
+            assert descriptors["profile"]["att_mtu"] == profile["att_mtu"]
+            descriptors_duration += descriptors["duration"]
+            descriptors_requests += descriptors["att_requests"]
+
+    record_property("discovery_profile", dict(
+        profile,
+        duration=discovery["duration"],
+        att_requests=discovery["att_requests"],
+        descriptors_phase=dict(duration=descriptors_duration, att_requests=descriptors_requests)
+    ))
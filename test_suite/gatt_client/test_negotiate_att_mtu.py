@@ -76,3 +76,28 @@ def test_att_mtu_change(server, client):
     assert mtu_res.result["handle"] == connection_handle
     # no specific attMtuSize is expected, other than different than default
     assert mtu_res.result["attMtuSize"] > 23
+
+
+@pytest.mark.ble42
+def test_att_mtu_change_recorded_in_statistics(server, client):
+    """The ATT_MTU negotiated reaches the connection statistics through the chain of GattServer event handlers"""
+    server_address = server.gap.getAddress().result
+    server.gap.startAdvertising(LEGACY_ADVERTISING_HANDLE, ADV_DURATION_FOREVER, ADV_MAX_EVENTS_UNLIMITED)
+
+    connection_server = server.gap.waitForConnection.setAsync()(2000)
+    connection_handle = client.gap.connect(
+        server_address["address_type"], server_address["address"]
+    ).result["connection_handle"]
+    server_handle = connection_server.result["connection_handle"]
+
+    def recorded_mtu(device, handle):
+        connections = device.gap.getConnectionStatistics().result["connections"]
+        return next(c["att_mtu"] for c in connections if c["connected"] and c["connection_handle"] == handle)
+
+    assert recorded_mtu(server, server_handle) == 23
+
+    mtu = client.gattClient.negotiateAttMtu(connection_handle, 3000).result["attMtuSize"]
+    assert mtu > 23
+
+    # the server is notified once the exchange completes
+    assert recorded_mtu(server, server_handle) == mtu
@@ -0,0 +1,91 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import pytest
+from time import sleep
+from common.gap_utils import gap_connect
+from common.sm_utils import SecuritySession, init_security_sessions
+
+BURST_COUNT = 200
+COUNT_TIMEOUT = 20000
+
+
+def instantiate_service(server, properties, size):
+    """Create a variable length characteristic receiving the burst and return its value handle"""
+    server.declareService(0xFFFB)
+    server.declareCharacteristic(0xDEAF)
+    server.setCharacteristicProperties(*properties)
+    server.setCharacteristicValue("00" * size)
+    server.setCharacteristicVariableLength(True)
+    server.setCharacteristicMaxLength(size)
+    if "authSignedWrite" in properties:
+        server.setCharacteristicSecurity("UNAUTHENTICATED", "UNAUTHENTICATED", "UNAUTHENTICATED")
+    return server.commitService().result["characteristics"][0]["value_handle"]
+
+
+def run_burst(central, peripheral, client_handle, server_handle, value_handle, size, signed):
+    counter = peripheral.gattServer.countWrites.setAsync()(server_handle, value_handle, BURST_COUNT, COUNT_TIMEOUT)
+    # let the server attach its handler before the first write
+    sleep(0.5)
+    burst = central.gattClient.writeWithoutResponseBurst(client_handle, value_handle, BURST_COUNT, size, signed)
+    assert burst.success()
+    assert counter.success()
+    return burst.result, counter.result
+
+
+@pytest.mark.ble41
+@pytest.mark.parametrize("size", [2, 20])
+def test_write_without_response_burst(central, peripheral, size, record_property):
+    """All the packets of a burst accepted by the client stack should be received by the server in order"""
+    value_handle = instantiate_service(peripheral.gattServer, ["read", "writeWoResp"], size)
+    client_handle, server_handle = gap_connect(central, peripheral)
+
+    burst, received = run_burst(central, peripheral, client_handle, server_handle, value_handle, size, False)
+    record_property("write_burst", dict(size=size, signed=False, client=burst, server=received))
+
+    assert burst["sent"] == BURST_COUNT
+    assert burst["bytes"] == BURST_COUNT * size
+    assert burst["latency"]["count"] == BURST_COUNT
+    assert received["packets"] == BURST_COUNT
+    assert received["bytes"] == BURST_COUNT * size
+    assert received["lost"] == 0
+    assert received["out_of_order"] == 0
+    assert received["signed"] == 0
+
+
+@pytest.mark.ble41
+def test_signed_write_without_response_burst(central, peripheral, record_property):
+    """Signed bursts should be received and authenticated by the server, the signature takes 12 bytes of the ATT_MTU"""
+    size = 8
+    central_ss, peripheral_ss = init_security_sessions(central, peripheral)
+    value_handle = instantiate_service(peripheral.gattServer, ["read", "writeWoResp", "authSignedWrite"], size)
+
+    # pair to exchange the signing keys then reconnect without encryption
+    central_ss.connect(peripheral_ss)
+    central_ss.request_encryption(SecuritySession.ENCRYPTION_ENCRYPTED)
+    central_ss.expect_encryption_changed(SecuritySession.ENCRYPTION_ENCRYPTED)
+    sleep(1)
+    central.gap.disconnect(central_ss.connection_handle, "USER_TERMINATION")
+    central_ss.connect(peripheral_ss)
+
+    burst, received = run_burst(
+        central, peripheral, central_ss.connection_handle, peripheral_ss.connection_handle, value_handle, size, True
+    )
+    record_property("write_burst", dict(size=size, signed=True, client=burst, server=received))
+
+    assert burst["sent"] == BURST_COUNT
+    assert received["packets"] == BURST_COUNT
+    assert received["signed"] == BURST_COUNT
+    assert received["lost"] == 0
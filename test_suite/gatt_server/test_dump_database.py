@@ -0,0 +1,89 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+import pytest
+from common.gap_utils import make_uuid, assert_uuid_equals
+
+SERVICES = [
+    (0xFFE0, [
+        (0xFFE1, ["read", "write"], "0102", []),
+        (0xFFE2, ["read", "notify"], "AABBCCDD", [(0xFF01, "11"), (0xFF02, "2233")]),
+    ]),
+    (make_uuid(), [
+        (make_uuid(), ["read"], "00", [(0xFF03, "44")]),
+    ])
+]
+
+
+def commit_services(peripheral):
+    """Declare and commit SERVICES then return the attributes they should have in the database"""
+    expected = []
+    for service_uuid, characteristics in SERVICES:
+        peripheral.gattServer.declareService(service_uuid)
+        for uuid, properties, value, descriptors in characteristics:
+            peripheral.gattServer.declareCharacteristic(uuid)
+            peripheral.gattServer.setCharacteristicProperties(*properties)
+            peripheral.gattServer.setCharacteristicValue(value)
+            for descriptor_uuid, descriptor_value in descriptors:
+                peripheral.gattServer.declareDescriptor(descriptor_uuid)
+                peripheral.gattServer.setDescriptorValue(descriptor_value)
+        service = peripheral.gattServer.commitService().result
+
+        expected.append(("service", service["handle"], service_uuid, None, None))
+        for characteristic, (uuid, properties, value, descriptors) in zip(service["characteristics"], characteristics):
+            expected.append(("characteristic", characteristic["value_handle"], uuid, properties, value))
+            for descriptor, (descriptor_uuid, descriptor_value) in zip(characteristic["descriptors"], descriptors):
+                expected.append(("descriptor", descriptor["handle"], descriptor_uuid, None, descriptor_value))
+    return expected
+
+
+def assert_database(database, expected):
+    assert len(database) == len(expected)
+    handles = [attribute["handle"] for attribute in database]
+    assert handles == sorted(handles)
+
+    for attribute, (kind, handle, uuid, properties, value) in zip(database, expected):
+        assert attribute["type"] == kind
+        assert attribute["handle"] == handle
+        assert_uuid_equals(uuid, attribute["UUID"])
+        if properties is not None:
+            assert sorted(attribute["properties"]) == sorted(properties)
+        if value is not None:
+            assert attribute["value"] == value
+            assert attribute["length"] == len(value) // 2
+
+
+@pytest.mark.ble41
+def test_dump_empty_database(peripheral):
+    """dumpDatabase reports no attribute if no service has been committed"""
+    assert peripheral.gattServer.dumpDatabase().result == []
+
+
+@pytest.mark.ble41
+def test_dump_database(peripheral):
+    """dumpDatabase reports the handles, UUIDs, properties and values of the services committed"""
+    expected = commit_services(peripheral)
+    assert_database(peripheral.gattServer.dumpDatabase().result, expected)
+
+
+@pytest.mark.ble41
+def test_dump_database_after_write(peripheral):
+    """dumpDatabase reads the current values of the attributes"""
+    expected = commit_services(peripheral)
+    kind, handle, uuid, properties, _ = expected[1]
+    peripheral.gattServer.write(handle, "0A0B")
+    expected[1] = (kind, handle, uuid, properties, "0A0B")
+    assert_database(peripheral.gattServer.dumpDatabase().result, expected)
@@ -100,3 +100,35 @@ def test_no_services(central, peripheral):
     central_connection_handle, _ = gap_connect(central, peripheral)
     discovered_services = discover_user_services(central, central_connection_handle)
     assert 0 == len(discovered_services)
+
+
+@pytest.mark.ble41
+def test_service_arena_size(peripheral):
+    """Each committed service reports the size of its arena, which grows with its characteristics, descriptors and values"""
+    def commit(characteristic_count, descriptor_count, value="AABBCCDD"):
+        peripheral.gattServer.declareService(SERVICE_16BIT_UUID)
+        for i in range(characteristic_count):
+            peripheral.gattServer.declareCharacteristic(CHARACTERISTIC_16BIT_UUID + i)
+            peripheral.gattServer.setCharacteristicValue(value)
+            for j in range(descriptor_count):
+                peripheral.gattServer.declareDescriptor(0xFF00 + j)
+                peripheral.gattServer.setDescriptorValue("0102")
+        service = peripheral.gattServer.commitService().result
+        # values are still reported once moved into the arena
+        for characteristic in service["characteristics"]:
+            assert characteristic["value"] == value
+            assert [d["value"] for d in characteristic["descriptors"]] == ["0102"] * descriptor_count
+        log.info('arena of {} characteristics with {} descriptors: {} bytes'.format(
+            characteristic_count, descriptor_count, service["arena_size"]))
+        return service["arena_size"]
+
+    empty = commit(0, 0)
+    single = commit(1, 0)
+    several = commit(4, 0)
+    with_descriptors = commit(4, 2)
+
+    assert 0 < empty < single < several < with_descriptors
+    # the same layout always takes the same room
+    assert commit(4, 2) == with_descriptors
+    # values are stored in the arena
+    assert commit(4, 2, "AABBCCDD" * 8) > with_descriptors
@@ -0,0 +1,77 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import os
+
+import pytest
+
+from .results import PerfResults
+from .sweep import PHYS
+
+DEFAULT_PHYS = ','.join(PHYS)
+DEFAULT_ATT_MTUS = 'default,negotiated'
+# connection intervals in units of 1.25ms: 7.5ms, 30ms and 100ms
+DEFAULT_INTERVALS = '6,24,80'
+# payload sizes fitting the default ATT_MTU (23) and the ATT_MTU negotiated by
+# ble-cliapp (cordio.desired-att-mtu is 80 in mbed_app.json)
+DEFAULT_PAYLOADS = '20,50,77'
+
+
+def _option_list(config, name: str, default: str):
+    return [value.strip() for value in (config.getoption(name) or default).split(',') if value.strip()]
+
+
+def pytest_generate_tests(metafunc):
+    """Parametrize the sweep with every combination of PHY, ATT_MTU and connection interval selected."""
+    if 'link' not in metafunc.fixturenames:
+        return
+
+    config = metafunc.config
+    phys = _option_list(config, 'perf_phys', DEFAULT_PHYS)
+    att_mtus = _option_list(config, 'perf_att_mtus', DEFAULT_ATT_MTUS)
+    intervals = [int(interval) for interval in _option_list(config, 'perf_intervals', DEFAULT_INTERVALS)]
+
+    for phy in phys:
+        assert phy in PHYS, 'unknown PHY {}'.format(phy)
+    for att_mtu in att_mtus:
+        assert att_mtu in ('default', 'negotiated'), 'unknown ATT_MTU {}'.format(att_mtu)
+
+    links = [(phy, att_mtu, interval) for phy in phys for att_mtu in att_mtus for interval in intervals]
+    metafunc.parametrize('link', links, ids=['{}-{}-{}'.format(*link) for link in links])
+
+
+@pytest.fixture(scope='session')
+def perf_results(request):
+    """Results matrix of the sweep, written at the end of the session in the
+    JSON file given by --perf_results and in a CSV file next to it."""
+    path = request.config.getoption('perf_results')
+    if not path:
+        pytest.skip('performance sweep runs only with --perf_results')
+
+    results = PerfResults()
+    yield results
+
+    results.write_json(path)
+    results.write_csv(os.path.splitext(path)[0] + '.csv')
+
+
+@pytest.fixture(scope='session')
+def payload_sizes(request):
+    return [int(size) for size in _option_list(request.config, 'perf_payloads', DEFAULT_PAYLOADS)]
+
+
+@pytest.fixture(scope='session')
+def perf_packets(request):
+    return int(request.config.getoption('perf_packets'))
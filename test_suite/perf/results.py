@@ -0,0 +1,82 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+"""Results matrix of the performance sweep.
+
+Every point of the sweep is a row: the link configuration (PHY, ATT_MTU,
+connection interval and payload size) followed by the measures of the probes.
+Nested measures are flattened with a dot separator, e.g. throughput.goodput,
+so the matrix can be written both as a JSON document and as a CSV file.
+"""
+
+import csv
+import json
+import platform
+import time
+from collections import OrderedDict
+from typing import Any, List, Mapping
+
+
+def flatten(values: Mapping[str, Any], prefix: str = '') -> 'OrderedDict[str, Any]':
+    """Flatten nested mappings, lists are kept as JSON strings."""
+    flat = OrderedDict()
+    for name, value in values.items():
+        name = prefix + name
+        if isinstance(value, Mapping):
+            flat.update(flatten(value, name + '.'))
+        elif isinstance(value, list):
+            flat[name] = json.dumps(value)
+        else:
+            flat[name] = value
+    return flat
+
+
+class PerfResults:
+    """Collect the rows of the sweep and write them once the run is over."""
+
+    def __init__(self):
+        self.rows = []  # type: List[OrderedDict]
+        self.environment = OrderedDict([
+            ('date', time.strftime('%Y-%m-%dT%H:%M:%S')),
+            ('host', platform.node()),
+        ])
+
+    def add(self, row: Mapping[str, Any]):
+        self.rows.append(flatten(row))
+
+    def columns(self) -> List[str]:
+        columns = []
+        for row in self.rows:
+            for column in row:
+                if column not in columns:
+                    columns.append(column)
+        return columns
+
+    def write_json(self, path: str):
+        document = OrderedDict([
+            ('environment', self.environment),
+            ('columns', self.columns()),
+            ('rows', self.rows),
+        ])
+        with open(path, 'w') as output:
+            json.dump(document, output, indent=4)
+
+    def write_csv(self, path: str):
+        with open(path, 'w', newline='') as output:
+            writer = csv.DictWriter(output, fieldnames=self.columns())
+            writer.writeheader()
+            for row in self.rows:
+                writer.writerow(row)
@@ -0,0 +1,156 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+"""Link configuration and device-side probes of the performance sweep."""
+
+from collections import OrderedDict
+from time import sleep, perf_counter
+from typing import Any, Callable, List, Mapping, Optional
+
+from common.command_timing import percentile
+
+# PHY mask of setPhy and the controller feature required by each PHY
+PHYS = OrderedDict([
+    ('LE_1M', (0x01, None)),
+    ('LE_2M', (0x02, 'LE_2M_PHY')),
+    ('LE_CODED', (0x04, 'LE_CODED_PHY')),
+])
+
+# ATT_MTU of a connection which has not negotiated it
+DEFAULT_ATT_MTU = 23
+# Largest payload written by the burst procedure
+MAX_PAYLOAD_SIZE = 244
+# Supervision timeout used during the sweep, in units of 10ms; long enough for
+# the slowest connection interval
+SUPERVISION_TIMEOUT = 400
+
+SERVICE_UUID = 0xFFFB
+CHARACTERISTIC_UUID = 0xDEAF
+
+LINK_UPDATE_TIMEOUT = 10
+ATT_MTU_TIMEOUT = 3000
+
+
+def instantiate_sink(server) -> int:
+    """Create a characteristic accepting writes of any payload of the sweep and return its value handle."""
+    server.declareService(SERVICE_UUID)
+    server.declareCharacteristic(CHARACTERISTIC_UUID)
+    server.setCharacteristicProperties("read", "write", "writeWoResp")
+    server.setCharacteristicValue("00")
+    server.setCharacteristicVariableLength(True)
+    server.setCharacteristicMaxLength(MAX_PAYLOAD_SIZE)
+    return server.commitService().result["characteristics"][0]["value_handle"]
+
+
+def connection_record(device, connection_handle: int) -> Optional[Mapping[str, Any]]:
+    """Record of a live connection in gap getConnectionStatistics."""
+    for record in device.gap.getConnectionStatistics().result["connections"]:
+        if record["connection_handle"] == connection_handle and record["connected"]:
+            return record
+    return None
+
+
+def wait_for_link(device, connection_handle: int, predicate: Callable[[Mapping[str, Any]], bool]) \
+        -> Optional[Mapping[str, Any]]:
+    """Poll the connection statistics until the record of the connection satisfies predicate.
+    Returns the record or None on timeout."""
+    deadline = perf_counter() + LINK_UPDATE_TIMEOUT
+    while perf_counter() < deadline:
+        record = connection_record(device, connection_handle)
+        if record is not None and predicate(record):
+            return record
+        sleep(0.2)
+    return None
+
+
+def phy_supported(device, phy: str) -> bool:
+    feature = PHYS[phy][1]
+    return feature is None or device.gap.isFeatureSupported(feature).result
+
+
+def configure_link(central, connection_handle: int, phy: str, negotiate_mtu: bool, interval: int) \
+        -> Mapping[str, Any]:
+    """Apply the link configuration of a point of the sweep from the central.
+    Returns the record of the connection once the configuration is in effect."""
+    if negotiate_mtu:
+        central.gattClient.negotiateAttMtu(connection_handle, ATT_MTU_TIMEOUT)
+
+    mask = PHYS[phy][0]
+    central.gap.setPhy(connection_handle, mask, mask, 0)
+    record = wait_for_link(central, connection_handle, lambda r: r["tx_phy"] == phy and r["rx_phy"] == phy)
+    assert record is not None, "PHY {} not applied".format(phy)
+
+    central.gap.updateConnectionParameters(connection_handle, interval, interval, 0, SUPERVISION_TIMEOUT)
+    record = wait_for_link(central, connection_handle, lambda r: r["interval"] == interval)
+    assert record is not None, "connection interval {} not applied".format(interval)
+    return record
+
+
+def max_payload_size(att_mtu: int) -> int:
+    """Largest payload of a write command for an ATT_MTU."""
+    return min(att_mtu - 3, MAX_PAYLOAD_SIZE)
+
+
+def without_buckets(distribution: Mapping[str, Any]) -> Mapping[str, Any]:
+    return OrderedDict((name, value) for name, value in distribution.items() if name != 'buckets')
+
+
+def throughput_probe(central, peripheral, client_handle: int, server_handle: int, value_handle: int,
+                     size: int, packets: int) -> Mapping[str, Any]:
+    """Write packets of size bytes as fast as the client stack accepts them and count them on the server."""
+    counter = peripheral.gattServer.countWrites.setAsync()(server_handle, value_handle, packets, 30000)
+    # let the server attach its handler before the first write
+    sleep(0.5)
+    burst = central.gattClient.writeWithoutResponseBurst(client_handle, value_handle, packets, size, False).result
+    received = counter.result
+
+    return OrderedDict([
+        ('sent', burst["sent"]),
+        ('received', received["packets"]),
+        ('lost', received["lost"]),
+        ('retries', burst["retries"]),
+        ('backoff', burst["backoff"]),
+        ('client_goodput', burst["goodput"]),
+        ('server_goodput', received["goodput"]),
+        ('write_latency', without_buckets(burst["latency"])),
+        ('server_interval', without_buckets(received["interval"])),
+    ])
+
+
+def latency_probe(central, client_handle: int, value_handle: int, size: int, samples: int) \
+        -> Optional[Mapping[str, Any]]:
+    """Round trip time, in µs, of write requests measured by the client board.
+    The board must report command timings (ble enableCommandTiming), None is
+    returned otherwise."""
+    durations = []  # type: List[int]
+    value = "A5" * size
+    for _ in range(samples):
+        response = central.gattClient.write(client_handle, value_handle, value)
+        timing = response.timing
+        if not timing or "procedure" not in timing:
+            return None
+        durations.append(timing["procedure"] - timing["handler"])
+
+    durations.sort()
+    return OrderedDict([
+        ('count', len(durations)),
+        ('min', durations[0]),
+        ('max', durations[-1]),
+        ('mean', sum(durations) // len(durations)),
+        ('p50', percentile(durations, 50)),
+        ('p90', percentile(durations, 90)),
+        ('p99', percentile(durations, 99)),
+    ])
@@ -0,0 +1,70 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from collections import OrderedDict
+
+import pytest
+
+from common.gap_utils import gap_connect
+from .sweep import (DEFAULT_ATT_MTU, configure_link, instantiate_sink, latency_probe, max_payload_size,
+                    phy_supported, throughput_probe)
+
+LATENCY_SAMPLES = 20
+
+
+def test_link_sweep(central, peripheral, link, payload_sizes, perf_packets, perf_results, record_property):
+    """Measure the throughput and the latency of writes for a link configuration and every payload size"""
+    phy, att_mtu, interval = link
+    if not (phy_supported(central, phy) and phy_supported(peripheral, phy)):
+        pytest.skip('{} not supported'.format(phy))
+
+    value_handle = instantiate_sink(peripheral.gattServer)
+    client_handle, server_handle = gap_connect(central, peripheral)
+    record = configure_link(central, client_handle, phy, att_mtu == 'negotiated', interval)
+
+    # round trip of write requests is measured on the board from the command timing
+    central.ble.enableCommandTiming(True)
+
+    rows = []
+    for size in payload_sizes:
+        row = OrderedDict([
+            ('phy', phy),
+            ('att_mtu', record["att_mtu"]),
+            ('negotiated_att_mtu', record["att_mtu"] != DEFAULT_ATT_MTU),
+            ('interval', record["interval"]),
+            ('payload', size),
+            ('packets', perf_packets),
+            ('skipped', None),
+        ])
+
+        # keep the point in the matrix so a missing measure is not mistaken for a lost run
+        if size > max_payload_size(record["att_mtu"]):
+            row['skipped'] = 'payload larger than ATT_MTU - 3 ({})'.format(max_payload_size(record["att_mtu"]))
+            perf_results.add(row)
+            rows.append(row)
+            continue
+
+        row['throughput'] = throughput_probe(
+            central, peripheral, client_handle, server_handle, value_handle, size, perf_packets
+        )
+        row['latency'] = latency_probe(central, client_handle, value_handle, size, LATENCY_SAMPLES)
+
+        assert row['throughput']['sent'] == perf_packets
+        assert row['throughput']['received'] == perf_packets
+        perf_results.add(row)
+        rows.append(row)
+
+    central.ble.enableCommandTiming(False)
+    record_property('perf_sweep', rows)
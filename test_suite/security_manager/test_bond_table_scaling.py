@@ -0,0 +1,67 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import random
+
+import pytest
+from common.sm_utils import init_security_sessions
+from time import sleep
+
+BOND_COUNT = 8
+BENCHMARK_ITERATIONS = 5
+FILESYSTEM_SIZE = 16384
+DB_PATH = "/fs/bond_table"
+
+
+def random_static_address():
+    address = [random.randint(0, 255) for _ in range(6)]
+    # the two most significant bits of a random static address are set
+    address[0] |= 0xC0
+    return ":".join("{:02X}".format(b) for b in address)
+
+
+@pytest.mark.ble41
+@pytest.mark.parametrize("erase_latency, program_latency", [(0, 0), (4000, 400)])
+def test_bond_table_scaling(central, peripheral, erase_latency, program_latency, record_property):
+    """Measure the restoration of the bond table and the generation of a whitelist as the number of bonds grows"""
+    central_ss, peripheral_ss = init_security_sessions(central, peripheral, responder_bondable=True)
+
+    central.ble.createFilesystem(FILESYSTEM_SIZE, erase_latency, program_latency)
+    central.securityManager.setDatabaseFilepath(DB_PATH)
+    central.securityManager.preserveBondingStateOnReset(True)
+
+    # each bond is made with a new identity of the peripheral
+    peripheral.advParams.setOwnAddressType("RANDOM")
+
+    measures = []
+    for bonds in range(1, BOND_COUNT + 1):
+        peripheral.gap.setRandomStaticAddress(random_static_address())
+
+        central_ss.connect(peripheral_ss)
+        central_ss.start_pairing()
+        central_ss.expect_pairing_success()
+        sleep(1)
+        central.gap.disconnect(central_ss.connection_handle, "USER_TERMINATION")
+        sleep(1)
+
+        result = central.securityManager.benchmarkBondTable(DB_PATH, BENCHMARK_ITERATIONS).result
+        measures.append(dict(result, bonds=bonds))
+
+    record_property("bond_table_scaling", measures)
+
+    # the bond table grows until it reaches the capacity of the database
+    whitelist_sizes = [measure["whitelist_size"] for measure in measures]
+    assert whitelist_sizes[0] > 0
+    assert whitelist_sizes == sorted(whitelist_sizes)
@@ -0,0 +1,82 @@
+# Copyright (c) 2009-2020 Arm Limited
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import pytest
+from common.sm_utils import init_security_sessions
+
+BENCHMARK_ITERATIONS = 5
+
+
+@pytest.mark.ble41
+@pytest.mark.parametrize("allow_legacy_pairing", [True, False])
+@pytest.mark.parametrize("mitm, initiator_io_caps, responder_io_caps", [
+    # just works
+    (False, "IO_CAPS_NONE", "IO_CAPS_NONE"),
+    # passkey entry
+    (True, "IO_CAPS_KEYBOARD_ONLY", "IO_CAPS_DISPLAY_ONLY"),
+    (True, "IO_CAPS_DISPLAY_ONLY", "IO_CAPS_KEYBOARD_ONLY"),
+    (True, "IO_CAPS_KEYBOARD_ONLY", "IO_CAPS_KEYBOARD_ONLY"),
+    # numeric comparison
+    (True, "IO_CAPS_DISPLAY_YESNO", "IO_CAPS_DISPLAY_YESNO"),
+    (True, "IO_CAPS_KEYBOARD_DISPLAY", "IO_CAPS_KEYBOARD_DISPLAY"),
+])
+def test_pairing_benchmark(central, peripheral, allow_legacy_pairing, mitm, initiator_io_caps, responder_io_caps,
+                           record_property):
+    """Measure the phases of pairing for each pairing method, pairing runs on the device without host interaction"""
+    central_ss, peripheral_ss = init_security_sessions(
+        central, peripheral,
+        initiator_mitm=mitm, initiator_io_caps=initiator_io_caps, initiator_bondable=False,
+        responder_mitm=mitm, responder_io_caps=responder_io_caps, responder_bondable=False
+    )
+
+    secure_connections = central.securityManager.getSecureConnectionsSupport().result
+    if not secure_connections and (not allow_legacy_pairing or initiator_io_caps == "IO_CAPS_DISPLAY_YESNO"):
+        # numeric comparison is not available with legacy pairing
+        pytest.skip("Secure Connections not supported")
+
+    assert central.securityManager.allowLegacyPairing(allow_legacy_pairing).success()
+    assert peripheral.securityManager.allowLegacyPairing(allow_legacy_pairing).success()
+
+    central_ss.connect(peripheral_ss)
+    assert peripheral.securityManager.setAutoPairing(True).success()
+
+    benchmark = central.securityManager.benchmarkPairing(central_ss.connection_handle, BENCHMARK_ITERATIONS)
+    peer = peripheral.securityManager.setAutoPairing(False)
+
+    assert benchmark.success()
+    result = benchmark.result
+
+    if allow_legacy_pairing and result["pairing_type"] != "LEGACY":
+        # measured by the case which disallows legacy pairing
+        pytest.skip("legacy pairing allowed but {} pairing used".format(result["pairing_type"]))
+    if not allow_legacy_pairing:
+        assert result["pairing_type"] != "LEGACY"
+
+    record_property("pairing_benchmark", dict(
+        result,
+        allow_legacy_pairing=allow_legacy_pairing,
+        initiator_io_caps=initiator_io_caps,
+        responder_io_caps=responder_io_caps
+    ))
+
+    assert result["successes"] == BENCHMARK_ITERATIONS
+    assert result["failures"] == 0
+    assert result["total"]["count"] == BENCHMARK_ITERATIONS
+    assert (result["pairing_method"] != "JUST_WORKS") == mitm
+    assert peer.result["successes"] == BENCHMARK_ITERATIONS
+
+    if mitm:
+        assert result["link_encryption"] != "NOT_ENCRYPTED"
+        assert result["authentication"]["count"] == BENCHMARK_ITERATIONS